@@ -0,0 +1,113 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define GRID_SIZE 12
+#define LIGHT_COUNT 32
+
+static const char *modeNames[] = { "Forward", "Multi-pass forward", "Deferred" };
+
+static Model sphere = (Model) { 0 };
+static Model plane = (Model) { 0 };
+
+void draw(void)
+{
+    for (int x = 0; x < GRID_SIZE; x++)
+    {
+        for (int z = 0; z < GRID_SIZE; z++)
+        {
+            RLG_DrawModel(sphere, (Vector3) { x - GRID_SIZE/2, 0.0f, z - GRID_SIZE/2 }, 1, WHITE);
+        }
+    }
+
+    RLG_DrawModel(plane, (Vector3) { 0, -0.5, 0 }, 1, WHITE);
+}
+
+int main(void)
+{
+    InitWindow(800, 600, "lighting paths");
+
+    Camera camera = {
+        .position = (Vector3) { -10.0f, 8.0f, -10.0f },
+        .target = (Vector3) { 0.0f, 0.0f, 0.0f },
+        .up = (Vector3) { 0.0f, 1.0f, 0.0f },
+        .fovy = 45.0f
+    };
+
+    RLG_Context rlgCtx = RLG_CreateContext(LIGHT_COUNT);
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetViewPositionV(camera.position);
+
+    // Small attenuated lights, each one only covers a few spheres
+    for (int i = 0; i < RLG_GetLightcount(); i++)
+    {
+        Color color = ColorFromHSV(360.0f*i/LIGHT_COUNT, 0.8f, 1.0f);
+
+        RLG_UseLight(i, true);
+        RLG_SetLightType(i, RLG_OMNILIGHT);
+        RLG_SetLightColor(i, color);
+        RLG_SetLightValue(i, RLG_LIGHT_ATTENUATION_QUADRATIC, 8.0f);
+    }
+
+    sphere = LoadModelFromMesh(GenMeshSphere(0.4f, 32, 32));
+    sphere.materials[0].maps[MATERIAL_MAP_METALNESS].value = 0.5f;
+    sphere.materials[0].maps[MATERIAL_MAP_ROUGHNESS].value = 0.3f;
+
+    plane = LoadModelFromMesh(GenMeshPlane(100, 100, 1, 1));
+
+    int mode = 2;
+    RLG_UseDeferred(true);
+
+    // Uncapped to measure the frame time
+    SetTargetFPS(0);
+
+    float frameTime = 0.0f;
+
+    while (!WindowShouldClose())
+    {
+        if (IsKeyPressed(KEY_SPACE))
+        {
+            mode = (mode + 1)%3;
+            RLG_UseMultiPass(mode == 1);
+            RLG_UseDeferred(mode == 2);
+            frameTime = 0.0f;
+        }
+
+        // The lights circle between the spheres
+        for (int i = 0; i < RLG_GetLightcount(); i++)
+        {
+            float angle = GetTime()*0.5f + 2.0f*PI*i/LIGHT_COUNT;
+            float radius = 1.5f + 3.5f*(i%4)/3.0f;
+            RLG_SetLightXYZ(i, RLG_LIGHT_POSITION, cosf(angle)*radius, 0.25f, sinf(angle)*radius);
+        }
+
+        frameTime = (frameTime == 0.0f) ? GetFrameTime()
+            : frameTime*0.95f + GetFrameTime()*0.05f;
+
+        BeginDrawing();
+
+            ClearBackground(BLACK);
+
+            BeginMode3D(camera);
+                RLG_BeginDeferred();
+                    draw();
+                RLG_EndDeferred();
+            EndMode3D();
+
+            DrawText(TextFormat("%s: %.2f ms (SPACE to switch)",
+                modeNames[mode], frameTime*1000.0f), 10, 10, 20, RAYWHITE);
+
+        EndDrawing();
+    }
+
+    UnloadModel(sphere);
+    UnloadModel(plane);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
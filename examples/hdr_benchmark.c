@@ -0,0 +1,165 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define RUN_COUNT 5
+
+// Encode a float texel as RGBE
+static void encodeRGBE(const float *rgb, unsigned char *rgbe)
+{
+    float maxComponent = fmaxf(rgb[0], fmaxf(rgb[1], rgb[2]));
+
+    if (maxComponent < 1e-32f)
+    {
+        rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+        return;
+    }
+
+    int exponent;
+    float scale = frexpf(maxComponent, &exponent)*256.0f/maxComponent;
+
+    rgbe[0] = (unsigned char)(rgb[0]*scale);
+    rgbe[1] = (unsigned char)(rgb[1]*scale);
+    rgbe[2] = (unsigned char)(rgb[2]*scale);
+    rgbe[3] = (unsigned char)(exponent + 128);
+}
+
+// Write one channel of a scanline as runs and literal spans
+static void writeChannelRLE(FILE *file, const unsigned char *channel, int width)
+{
+    int x = 0;
+
+    while (x < width)
+    {
+        int run = 1;
+        while ((x + run < width) && (run < 127) && (channel[x + run] == channel[x])) run++;
+
+        if (run >= 4)
+        {
+            fputc(128 + run, file);
+            fputc(channel[x], file);
+            x += run;
+            continue;
+        }
+
+        // Literal span up to the next run of at least 4 values
+        int count = 0;
+        while ((x + count < width) && (count < 128))
+        {
+            const unsigned char *c = channel + x + count;
+            if ((x + count + 3 < width) && (c[0] == c[1]) && (c[0] == c[2]) && (c[0] == c[3])) break;
+            count++;
+        }
+
+        fputc(count, file);
+        fwrite(channel + x, 1, count, file);
+        x += count;
+    }
+}
+
+// Save a R32G32B32 image upscaled with bilinear filtering as a run-length encoded Radiance file
+static void saveUpscaledHDR(Image image, int width, int height, const char *fileName)
+{
+    const float *pixels = (const float*)image.data;
+
+    FILE *file = fopen(fileName, "wb");
+    fprintf(file, "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
+
+    unsigned char *rgbe = (unsigned char*)malloc(4*width);
+    unsigned char *channel = (unsigned char*)malloc(width);
+
+    for (int y = 0; y < height; y++)
+    {
+        float sy = ((y + 0.5f)*image.height/height) - 0.5f;
+        int y0 = Clamp(floorf(sy), 0, image.height - 1);
+        int y1 = (y0 + 1 < image.height) ? y0 + 1 : y0;
+        float fy = Clamp(sy - y0, 0.0f, 1.0f);
+
+        for (int x = 0; x < width; x++)
+        {
+            float sx = ((x + 0.5f)*image.width/width) - 0.5f;
+            int x0 = Clamp(floorf(sx), 0, image.width - 1);
+            int x1 = (x0 + 1)%image.width;
+            float fx = Clamp(sx - x0, 0.0f, 1.0f);
+
+            float rgb[3];
+            for (int c = 0; c < 3; c++)
+            {
+                float top = Lerp(pixels[3*(y0*image.width + x0) + c], pixels[3*(y0*image.width + x1) + c], fx);
+                float bottom = Lerp(pixels[3*(y1*image.width + x0) + c], pixels[3*(y1*image.width + x1) + c], fx);
+                rgb[c] = Lerp(top, bottom, fy);
+            }
+
+            encodeRGBE(rgb, rgbe + 4*x);
+        }
+
+        unsigned char header[4] = { 2, 2, (unsigned char)(width >> 8), (unsigned char)(width & 0xFF) };
+        fwrite(header, 1, 4, file);
+
+        for (int c = 0; c < 4; c++)
+        {
+            for (int x = 0; x < width; x++) channel[x] = rgbe[4*x + c];
+            writeChannelRLE(file, channel, width);
+        }
+    }
+
+    free(channel);
+    free(rgbe);
+    fclose(file);
+}
+
+// Best time of several loads of an image, in milliseconds, or -1 if it fails to load
+static double timeLoad(Image (*load)(const char*), const char *fileName)
+{
+    double best = -1.0;
+
+    for (int i = 0; i < RUN_COUNT; i++)
+    {
+        double start = GetTime();
+        Image image = load(fileName);
+        double time = 1000.0*(GetTime() - start);
+
+        if (image.data == NULL) return -1.0;
+        UnloadImage(image);
+
+        if ((best < 0.0) || (time < best)) best = time;
+    }
+
+    return best;
+}
+
+int main(void)
+{
+    // The window only provides the timer
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(320, 240, "hdr decoding benchmark");
+    SetTraceLogLevel(LOG_WARNING);
+
+    const char *fileNames[] = { "resources/skybox.hdr", "skybox_4k.hdr", "skybox_8k.hdr" };
+
+    Image source = RLG_LoadImageHDR(fileNames[0]);
+    saveUpscaledHDR(source, 4096, 2048, fileNames[1]);
+    saveUpscaledHDR(source, 8192, 4096, fileNames[2]);
+    UnloadImage(source);
+
+    printf("%-24s %14s %14s\n", "File", "rlights (ms)", "raylib (ms)");
+
+    for (int i = 0; i < 3; i++)
+    {
+        double rlgTime = timeLoad(RLG_LoadImageHDR, fileNames[i]);
+        double rlTime = timeLoad(LoadImage, fileNames[i]);
+
+        // LoadImage only decodes HDR files when raylib is built with SUPPORT_FILEFORMAT_HDR
+        if (rlTime < 0.0) printf("%-24s %14.2f %14s\n", fileNames[i], rlgTime, "unsupported");
+        else printf("%-24s %14.2f %14.2f\n", fileNames[i], rlgTime, rlTime);
+    }
+
+    remove(fileNames[1]);
+    remove(fileNames[2]);
+
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define GRID_SIZE 12
+
+static Model sphere = (Model) { 0 };
+static Model plane = (Model) { 0 };
+
+void cast(Shader shader)
+{
+    RLG_CastModel(shader, plane, (Vector3) { 0, -0.5, 0 }, 1);
+
+    for (int x = 0; x < GRID_SIZE; x++)
+    {
+        for (int z = 0; z < GRID_SIZE; z++)
+        {
+            RLG_CastModel(shader, sphere, (Vector3) { x - GRID_SIZE/2, 0.0f, z - GRID_SIZE/2 }, 1);
+        }
+    }
+}
+
+void draw(void)
+{
+    // The plane is drawn last and the spheres from back to front,
+    // the worst order for the depth test, to get as much overdraw as possible
+    for (int x = 0; x < GRID_SIZE; x++)
+    {
+        for (int z = 0; z < GRID_SIZE; z++)
+        {
+            RLG_DrawModel(sphere, (Vector3) { x - GRID_SIZE/2, 0.0f, z - GRID_SIZE/2 }, 1, WHITE);
+        }
+    }
+
+    RLG_DrawModel(plane, (Vector3) { 0, -0.5, 0 }, 1, WHITE);
+}
+
+int main(void)
+{
+    InitWindow(800, 600, "depth pre-pass");
+
+    Camera camera = {
+        .position = (Vector3) { -10.0f, 6.0f, -10.0f },
+        .target = (Vector3) { 0.0f, 0.0f, 0.0f },
+        .up = (Vector3) { 0.0f, 1.0f, 0.0f },
+        .fovy = 45.0f
+    };
+
+    RLG_Context rlgCtx = RLG_CreateContext(4);
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetViewPositionV(camera.position);
+
+    for (int i = 0; i < RLG_GetLightcount(); i++)
+    {
+        RLG_UseLight(i, true);
+        RLG_SetLightType(i, RLG_OMNILIGHT);
+        RLG_SetLightXYZ(i, RLG_LIGHT_COLOR, (i & 1), 0.5f, ((i >> 1) & 1));
+        RLG_SetLightXYZ(i, RLG_LIGHT_POSITION, (i & 1) ? 4 : -4, 3.0f, (i & 2) ? 4 : -4);
+        RLG_EnableShadow(i, 512);
+    }
+
+    sphere = LoadModelFromMesh(GenMeshSphere(0.75f, 32, 32));
+    sphere.materials[0].maps[MATERIAL_MAP_METALNESS].value = 0.5f;
+    sphere.materials[0].maps[MATERIAL_MAP_ROUGHNESS].value = 0.3f;
+
+    plane = LoadModelFromMesh(GenMeshPlane(100, 100, 1, 1));
+
+    // Shadows are rendered once, only the cost of the lighting pass changes
+    for (int i = 0; i < RLG_GetLightcount(); i++)
+    {
+        RLG_UpdateShadowMap(i, cast);
+    }
+
+    // Uncapped to measure the frame time
+    SetTargetFPS(0);
+
+    float frameTime = 0.0f;
+
+    while (!WindowShouldClose())
+    {
+        if (IsKeyPressed(KEY_SPACE))
+        {
+            RLG_UseDepthPrepass(!RLG_IsDepthPrepassUsed());
+            frameTime = 0.0f;
+        }
+
+        frameTime = (frameTime == 0.0f) ? GetFrameTime()
+            : frameTime*0.95f + GetFrameTime()*0.05f;
+
+        BeginDrawing();
+
+            ClearBackground(BLACK);
+
+            BeginMode3D(camera);
+                RLG_DrawDepthPrepass(cast);
+                draw();
+                RLG_EndDepthPrepass();
+            EndMode3D();
+
+            DrawText(TextFormat("Depth pre-pass %s: %.2f ms (SPACE to toggle)",
+                RLG_IsDepthPrepassUsed() ? "ON" : "OFF", frameTime*1000.0f), 10, 10, 20, RAYWHITE);
+
+        EndDrawing();
+    }
+
+    UnloadModel(sphere);
+    UnloadModel(plane);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define ROOM_SIZE 8.0f
+
+static Model sphere = (Model) { 0 };
+static Model cube = (Model) { 0 };
+static Model wall = (Model) { 0 };
+
+static RLG_Skybox skybox = (RLG_Skybox) { 0 };
+static Vector3 cubePosition = (Vector3) { 0 };
+
+// Draw the room and the moving cube, called for the frame and for the captures of the probe
+void drawRoom(Shader shader)
+{
+    const float offset = 0.5f*ROOM_SIZE + 0.5f;
+
+    // The floor and the walls are the inner faces of thick slabs, open to the sky above
+    RLG_DrawModelEx(wall, (Vector3) { 0, -offset, 0 }, (Vector3) { 0, 1, 0 }, 0, (Vector3) { ROOM_SIZE + 2, 1, ROOM_SIZE + 2 }, WHITE);
+    RLG_DrawModelEx(wall, (Vector3) { -offset, 0, 0 }, (Vector3) { 0, 1, 0 }, 0, (Vector3) { 1, ROOM_SIZE, ROOM_SIZE }, RED);
+    RLG_DrawModelEx(wall, (Vector3) { offset, 0, 0 }, (Vector3) { 0, 1, 0 }, 0, (Vector3) { 1, ROOM_SIZE, ROOM_SIZE }, GREEN);
+    RLG_DrawModelEx(wall, (Vector3) { 0, 0, -offset }, (Vector3) { 0, 1, 0 }, 0, (Vector3) { ROOM_SIZE, ROOM_SIZE, 1 }, BLUE);
+
+    RLG_DrawModel(cube, cubePosition, 1, WHITE);
+
+    RLG_DrawSkybox(skybox);
+}
+
+int main(void)
+{
+    InitWindow(800, 600, "reflection probes");
+
+    Camera camera = {
+        .position = (Vector3) { 0.0f, 1.0f, 3.5f },
+        .target = (Vector3) { 0.0f, -1.0f, 0.0f },
+        .up = (Vector3) { 0.0f, 1.0f, 0.0f },
+        .fovy = 60.0f
+    };
+
+    RLG_Context rlgCtx = RLG_CreateContext(1);
+    RLG_SetContext(rlgCtx);
+
+    RLG_UseMap(MATERIAL_MAP_METALNESS, true);
+    RLG_UseMap(MATERIAL_MAP_ROUGHNESS, true);
+    RLG_UseMap(MATERIAL_MAP_IRRADIANCE, true);
+    RLG_UseMap(MATERIAL_MAP_PREFILTER, true);
+    RLG_UseMap(MATERIAL_MAP_BRDF, true);
+
+    RLG_UseLight(0, true);
+    RLG_SetLightType(0, RLG_OMNILIGHT);
+    RLG_SetLightXYZ(0, RLG_LIGHT_POSITION, 0, 3, 0);
+
+    // NOTE: HDR support only if you compiled raylib with `SUPPORT_FILEFORMAT_HDR`
+    //skybox = RLG_LoadSkyboxHDR("resources/skybox.hdr", 1024, PIXELFORMAT_UNCOMPRESSED_R32G32B32);
+    skybox = RLG_LoadSkybox("resources/skybox.png");
+
+    sphere = LoadModelFromMesh(GenMeshSphere(1.0f, 32, 64));
+    cube = LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f));
+    wall = LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f));
+
+    sphere.materials[0].maps[MATERIAL_MAP_METALNESS].value = 1.0f;
+    sphere.materials[0].maps[MATERIAL_MAP_ROUGHNESS].value = 0.1f;
+    cube.materials[0].maps[MATERIAL_MAP_EMISSION].color = YELLOW;
+
+    Model *models[3] = { &sphere, &cube, &wall };
+    for (int i = 0; i < 3; i++)
+    {
+        models[i]->materials[0].maps[MATERIAL_MAP_IRRADIANCE].texture = skybox.irradiance;
+        models[i]->materials[0].maps[MATERIAL_MAP_PREFILTER].texture = skybox.prefilter;
+        models[i]->materials[0].maps[MATERIAL_MAP_BRDF].texture = RLG_GetBRDFLUT();
+    }
+
+    // The probe covers the room, the cube moves within it so the probe is captured continuously
+    BoundingBox room = {
+        .min = (Vector3) { -0.5f*ROOM_SIZE, -0.5f*ROOM_SIZE, -0.5f*ROOM_SIZE },
+        .max = (Vector3) { 0.5f*ROOM_SIZE, 0.5f*ROOM_SIZE, 0.5f*ROOM_SIZE }
+    };
+
+    unsigned int probe = RLG_CreateReflectionProbe((Vector3) { 0.0f, 0.0f, 0.0f }, room, 256);
+    RLG_SetReflectionProbeStatic(probe, false);
+
+    bool useProbe = true;
+
+    SetTargetFPS(60);
+
+    while (!WindowShouldClose())
+    {
+        if (IsKeyPressed(KEY_SPACE))
+        {
+            useProbe = !useProbe;
+
+            if (useProbe)
+            {
+                probe = RLG_CreateReflectionProbe((Vector3) { 0.0f, 0.0f, 0.0f }, room, 256);
+                RLG_SetReflectionProbeStatic(probe, false);
+            }
+            else
+            {
+                RLG_DestroyReflectionProbe(probe);
+            }
+        }
+
+        UpdateCamera(&camera, CAMERA_ORBITAL);
+        RLG_SetViewPositionV(camera.position);
+
+        float angle = GetTime()*0.5f;
+        cubePosition = (Vector3) { 2.5f*cosf(angle), -1.0f, 2.5f*sinf(angle) };
+
+        // One face of the probe per frame, a full refresh every twelve frames
+        RLG_UpdateReflectionProbes(drawRoom, 1);
+
+        BeginDrawing();
+
+            ClearBackground(BLACK);
+
+            BeginMode3D(camera);
+                drawRoom(RLG_GetShader(RLG_SHADER_LIGHTING)[0]);
+                RLG_DrawModel(sphere, (Vector3) { 0.0f, -2.0f, 0.0f }, 1.0f, WHITE);
+            EndMode3D();
+
+            DrawText(useProbe ? "Reflection probe (SPACE to disable)" : "Skybox reflections (SPACE to enable)",
+                10, 10, 20, RAYWHITE);
+
+        EndDrawing();
+    }
+
+    if (useProbe) RLG_DestroyReflectionProbe(probe);
+
+    UnloadModel(sphere);
+    UnloadModel(cube);
+    UnloadModel(wall);
+    RLG_UnloadSkybox(skybox);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -73,13 +73,36 @@ int main(void)
 
     SetTargetFPS(60);
 
+    RLG_OmniShadowMode omniMode = RLG_OMNI_SHADOW_CUBEMAP;
+    double updateTime = 0.0;
+
     while (!WindowShouldClose())
     {
         UpdateCamera(&camera, CAMERA_ORBITAL);
+
+        // Switch between cubemap and dual-paraboloid shadows to compare their cost
+        if (IsKeyPressed(KEY_SPACE))
+        {
+            omniMode = (omniMode == RLG_OMNI_SHADOW_CUBEMAP)
+                ? RLG_OMNI_SHADOW_DUAL_PARABOLOID : RLG_OMNI_SHADOW_CUBEMAP;
+
+            for (int i = 0; i < RLG_GetLightcount(); i++)
+            {
+                RLG_SetOmniShadowMode(i, omniMode);
+            }
+
+            updateTime = 0.0;
+        }
+
         BeginDrawing();
 
             ClearBackground(BLACK);
 
+            // Time spent rendering the shadow passes, the GPU is drained before and after
+            // so the measure covers its work and not only the submission of the draws
+            glFinish();
+            double start = GetTime();
+
             for (int i = 0; i < RLG_GetLightcount(); i++)
             {
                 int s = i == 0 ? 1 : -1;
@@ -89,6 +112,11 @@ int main(void)
                 RLG_UpdateShadowMap(i, cast);
             }
 
+            glFinish();
+
+            updateTime = (updateTime == 0.0) ? GetTime() - start
+                : updateTime*0.95 + (GetTime() - start)*0.05;
+
             BeginMode3D(camera);
                 for (int i = 0; i < RLG_GetLightcount(); i++)
                 {
@@ -98,6 +126,10 @@ int main(void)
                 draw();
             EndMode3D();
 
+            DrawText(TextFormat("%s: %.3f ms (SPACE to switch)",
+                (omniMode == RLG_OMNI_SHADOW_CUBEMAP) ? "Cubemap" : "Dual-paraboloid",
+                updateTime*1000.0), 10, 10, 20, RAYWHITE);
+
         EndDrawing();
     }
 
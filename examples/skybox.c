@@ -23,6 +23,8 @@ int main(void)
 
     RLG_UseMap(MATERIAL_MAP_CUBEMAP, true);
     RLG_UseMap(MATERIAL_MAP_IRRADIANCE, true);
+    RLG_UseMap(MATERIAL_MAP_PREFILTER, true);
+    RLG_UseMap(MATERIAL_MAP_BRDF, true);
 
     RLG_UseLight(0, true);
     RLG_SetLightType(0, RLG_OMNILIGHT);
@@ -35,6 +37,8 @@ int main(void)
     Model sphere = LoadModelFromMesh(GenMeshSphere(1.0f, 32, 64));
     sphere.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = skybox.cubemap;
     sphere.materials[0].maps[MATERIAL_MAP_IRRADIANCE].texture = skybox.irradiance;
+    sphere.materials[0].maps[MATERIAL_MAP_PREFILTER].texture = skybox.prefilter;
+    sphere.materials[0].maps[MATERIAL_MAP_BRDF].texture = RLG_GetBRDFLUT();
 
     DisableCursor();
 
@@ -55,8 +59,6 @@ int main(void)
 
             BeginMode3D(camera);
 
-                RLG_DrawSkybox(skybox);
-
                 for (int x = -5; x <= 5; x += 2)
                 {
                     for (int y = -5; y <= 5; y += 2)
@@ -67,6 +69,9 @@ int main(void)
                     }
                 }
 
+                // Drawn last, only behind the spheres
+                RLG_DrawSkybox(skybox);
+
             EndMode3D();
 
         EndDrawing();
@@ -2,6 +2,7 @@
 #define RLIGHTS_H
 
 #include "raylib.h"
+#include <stddef.h>                             // Required for: size_t
 
 #ifndef GL_HEADER
 #   if defined(GRAPHICS_API_OPENGL_ES2)
@@ -31,6 +32,45 @@
 #   endif //PLATFORM
 #endif //GLSL_VERSION
 
+/* Shadow filtering options, to define when compiling rlights */
+
+//#define RLG_SHADOW_HARDWARE_PCF   // Compare depths with sampler2DShadow/samplerCubeShadow, each tap filters 2x2 texels (GLSL 330 only)
+//#define RLG_SHADOW_DEPTH16        // Store the shadow maps with 16-bit depth, halving their memory
+//#define RLG_SHADOW_PCF_POISSON    // Spread the taps on a Poisson disk instead of a regular grid (GLSL 330 only)
+//#define RLG_SHADOW_MOMENTS16      // Store the VSM/EVSM moments as RG16F instead of RG32F, halving their memory
+
+#ifndef RLG_SHADOW_PCF_TAPS
+#   define RLG_SHADOW_PCF_TAPS 9    // Number of filter taps for directional and spot lights (1, 4, 9 or 16)
+#endif
+
+#ifndef RLG_SHADOW_EVSM_EXPONENT
+#   ifdef RLG_SHADOW_MOMENTS16
+#       define RLG_SHADOW_EVSM_EXPONENT 5.0     // Depth warping exponent of EVSM, limited by the half float range
+#   else
+#       define RLG_SHADOW_EVSM_EXPONENT 40.0    // Depth warping exponent of EVSM, limited by the float range
+#   endif
+#endif
+
+/* Skybox options, to define when compiling rlights */
+
+#ifndef RLG_IRRADIANCE_MAX_SAMPLES
+#   define RLG_IRRADIANCE_MAX_SAMPLES 4096  // Upper bound of the sample count of the sampled irradiance cubemaps
+#endif
+
+#ifndef RLG_PREFILTER_SIZE
+#   define RLG_PREFILTER_SIZE 128           // Face size of the first mip level of the prefiltered radiance cubemaps
+#endif
+
+#ifndef RLG_PREFILTER_MIP_LEVELS
+#   define RLG_PREFILTER_MIP_LEVELS 5       // Mip levels of the prefiltered radiance cubemaps, from roughness 0 to 1
+#endif
+
+/* Threading options, to define when compiling rlights */
+
+#ifndef RLG_WORKER_THREADS
+#   define RLG_WORKER_THREADS 4     // Number of threads sharing the CPU work of the skybox loading (1 to disable)
+#endif
+
 /**
  * @brief Enum representing different types of lights.
  */
@@ -49,7 +89,9 @@ typedef enum {
     RLG_SHADER_DEPTH_CUBEMAP,               ///< Enum representing the depth writing shader for shadow cubemaps.
     RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP,  ///< Enum representing the shader for generating skyboxes from HDR textures.
     RLG_SHADER_IRRADIANCE_CONVOLUTION,      ///< Enum representing the shader for generating irradiance maps from skyboxes.
-    RLG_SHADER_SKYBOX                       ///< Enum representing the shader for rendering skyboxes.
+    RLG_SHADER_SKYBOX,                      ///< Enum representing the shader for rendering skyboxes.
+    RLG_SHADER_IRRADIANCE_SAMPLING,         ///< Enum representing the shader for generating irradiance maps with importance sampling.
+    RLG_SHADER_PREFILTER                    ///< Enum representing the shader for generating the GGX prefiltered radiance of skyboxes.
 } RLG_Shader;
 
 /**
@@ -70,6 +112,34 @@ typedef enum {
     RLG_LIGHT_ATTENUATION_QUADRATIC         ///< Quadratic attenuation coefficient of the light.
 } RLG_LightProperty;
 
+/**
+ * @brief Enum representing the flags of a shadow caster registered with RLG_AddShadowCaster.
+ */
+typedef enum {
+    RLG_CAST_DIRLIGHT   = 1 << RLG_DIRLIGHT,    ///< The caster is rendered into the shadow maps of directional lights.
+    RLG_CAST_OMNILIGHT  = 1 << RLG_OMNILIGHT,   ///< The caster is rendered into the shadow maps of omnilights.
+    RLG_CAST_SPOTLIGHT  = 1 << RLG_SPOTLIGHT,   ///< The caster is rendered into the shadow maps of spotlights.
+    RLG_CAST_ALL        = 0x07,                 ///< The caster is rendered into the shadow maps of all light types.
+    RLG_CAST_NO_CULL    = 1 << 3                ///< The caster is never frustum culled (e.g. terrain, large occluders).
+} RLG_CasterFlags;
+
+/**
+ * @brief Enum representing the techniques used to filter the shadows of a light.
+ */
+typedef enum {
+    RLG_SHADOW_TECHNIQUE_PCF = 0,           ///< Percentage closer filtering of the depth map (default).
+    RLG_SHADOW_TECHNIQUE_VSM,               ///< Variance shadow map, blurred depth moments tested with Chebyshev's inequality.
+    RLG_SHADOW_TECHNIQUE_EVSM               ///< Exponential variance shadow map, same as VSM with exponentially warped depths.
+} RLG_ShadowTechnique;
+
+/**
+ * @brief Enum representing the projections used to render the shadows of an omnilight.
+ */
+typedef enum {
+    RLG_OMNI_SHADOW_CUBEMAP = 0,            ///< Six perspective faces of a depth cubemap (default).
+    RLG_OMNI_SHADOW_DUAL_PARABOLOID         ///< Two paraboloid hemispheres side by side in a 2D depth map.
+} RLG_OmniShadowMode;
+
 /**
  * @brief Enum representing all shader locations used by rlights.
  */
@@ -111,6 +181,12 @@ typedef enum {
     RLG_LOC_ROUGHNESS_SCALE,
     RLG_LOC_AO_LIGHT_AFFECT,
     RLG_LOC_HEIGHT_SCALE,
+    RLG_LOC_IRRADIANCE_SH,
+    RLG_LOC_USE_IRRADIANCE_SH,
+    RLG_LOC_USE_PROBE,
+    RLG_LOC_PROBE_POSITION,
+    RLG_LOC_PROBE_BOX_MIN,
+    RLG_LOC_PROBE_BOX_MAX,
 
     /* Internal use */
 
@@ -118,6 +194,25 @@ typedef enum {
 
 } RLG_ShaderLocationIndex;
 
+/**
+ * @brief Enum representing how the skyboxes store their diffuse irradiance.
+ */
+typedef enum {
+    RLG_IRRADIANCE_CUBEMAP = 0,             ///< Irradiance cubemap convolved on the GPU (default).
+    RLG_IRRADIANCE_SH9,                     ///< Nine RGB spherical harmonics coefficients projected on the CPU.
+    RLG_IRRADIANCE_SAMPLED_CUBEMAP          ///< Irradiance cubemap convolved on the GPU with importance sampling, by tiles.
+} RLG_IrradianceMode;
+
+/**
+ * @brief Enum of the packed HDR pixel formats accepted by RLG_LoadSkyboxHDR, in addition to raylib ones.
+ *
+ * Their values follow the ones of raylib PixelFormat, they are only understood by the skybox functions.
+ */
+typedef enum {
+    RLG_PIXELFORMAT_R11G11B10F = 100,       ///< 32 bpp, unsigned floats with 6 bits of mantissa for R and G, 5 bits for B.
+    RLG_PIXELFORMAT_RGB9E5                  ///< 32 bpp, 9 bits of mantissa per channel and a shared 5 bits exponent.
+} RLG_PixelFormat;
+
 /**
  * @brief Structure representing a skybox with associated textures and buffers.
  *
@@ -128,13 +223,27 @@ typedef enum {
  */
 typedef struct {
     TextureCubemap cubemap;       ///< The cubemap texture representing the skybox.
-    TextureCubemap irradiance;    ///< The irradiance cubemap texture for diffuse lighting.
-    int vboPostionsID;            ///< The ID of the vertex buffer object for positions.
-    int vboIndicesID;             ///< The ID of the vertex buffer object for indices.
-    int vaoID;                    ///< The ID of the vertex array object.
+    TextureCubemap irradiance;    ///< The irradiance cubemap texture for diffuse lighting (cubemap mode only).
+    TextureCubemap prefilter;     ///< The GGX prefiltered radiance cubemap for specular lighting, one mip level per roughness step.
+    Vector3 irradianceSH[9];      ///< The SH9 irradiance coefficients for diffuse lighting (SH9 mode only).
+    int vboPostionsID;            ///< The ID of the vertex buffer object for positions, shared by the skyboxes of the context.
+    int vboIndicesID;             ///< The ID of the vertex buffer object for indices, shared by the skyboxes of the context.
+    int vaoID;                    ///< The ID of the vertex array object, shared by the skyboxes of the context.
     bool isHDR;                   ///< Flag indicating if the skybox is HDR (high dynamic range).
+    int bakeTile;                 ///< Next irradiance tile to render by RLG_BakeSkyboxStep (sampled cubemap mode only).
+    int bakeTileCount;            ///< Number of irradiance tiles of the skybox, all rendered once bakeTile reaches it.
 } RLG_Skybox;
 
+/**
+ * @brief Structure describing the content and the activity of the shadow map pool.
+ */
+typedef struct {
+    unsigned int count;           ///< The number of shadow maps kept in the pool, unused by any light.
+    size_t memory;                ///< The estimated video memory used by the pooled shadow maps, in bytes.
+    unsigned int reused;          ///< The number of shadow maps taken from the pool since the context was created.
+    unsigned int loaded;          ///< The number of shadow maps loaded because none matched in the pool.
+} RLG_ShadowPoolStats;
+
 /**
  * @brief Opaque type for a lighting context handle.
  * 
@@ -143,6 +252,11 @@ typedef struct {
  */
 typedef void* RLG_Context;
 
+/**
+ * @brief Opaque type for the handle of a skybox being loaded by RLG_LoadSkyboxHDRAsync.
+ */
+typedef void* RLG_SkyboxLoad;
+
 /**
  * @brief Type definition for a rendering function.
  * 
@@ -517,6 +631,8 @@ Vector3 RLG_GetLightTarget(unsigned int light);
  * @brief Enable shadow casting for a light.
  *
  * @warning Shadow casting is not fully functional for omnilights yet. Please specify the light direction.
+ *
+ * A shadow map of the same kind and resolution is taken from the shadow map pool if there is one.
  * 
  * @param light The index of the light to enable shadow casting for.
  * @param shadowMapResolution The resolution of the shadow map.
@@ -530,6 +646,8 @@ void RLG_EnableShadow(unsigned int light, int shadowMapResolution);
 
 /**
  * @brief Disable shadow casting for a light.
+ *
+ * The shadow map of the light is kept in the shadow map pool, see RLG_TrimShadowPool.
  * 
  * @param light The index of the light to disable shadow casting for.
  */
@@ -559,17 +677,264 @@ void RLG_SetShadowBias(unsigned int light, float value);
  */
 float RLG_GetShadowBias(unsigned int light);
 
+/**
+ * @brief Set the technique used to filter the shadows of a light.
+ *
+ * With VSM and EVSM, the depth moments are rendered into a floating point texture,
+ * blurred at the shadow map resolution and mipmapped, so that the lighting shader only
+ * needs a single trilinear fetch per light whatever the softness of the shadows.
+ * The shadow bias is used as the minimum standard deviation of the depth.
+ *
+ * @note Only directional lights and spotlights support VSM and EVSM, omnilights always use PCF.
+ *       Requires OpenGL 3.3 and the embedded shaders.
+ *
+ * @param light The index of the light to configure.
+ * @param technique The shadow technique to use.
+ */
+void RLG_SetShadowTechnique(unsigned int light, RLG_ShadowTechnique technique);
+
+/**
+ * @brief Get the technique used to filter the shadows of a light.
+ *
+ * @param light The index of the light.
+ * @return The shadow technique of the light.
+ */
+RLG_ShadowTechnique RLG_GetShadowTechnique(unsigned int light);
+
+/**
+ * @brief Set the projection used to render the shadows of an omnilight.
+ *
+ * The dual-paraboloid mode renders the scene twice instead of six times and uses a third
+ * of the memory of the cubemap, at the cost of some distortion of the shadows. The paraboloid
+ * projection is applied per vertex, so coarse casters close to the light can show bent shadows.
+ * It is better suited to small, distant or less important lights.
+ *
+ * @note Requires OpenGL 3.3 and the embedded shaders. Layered rendering only applies to cubemaps.
+ *
+ * @param light The index of the light to configure.
+ * @param mode The shadow projection to use when the light is an omnilight.
+ */
+void RLG_SetOmniShadowMode(unsigned int light, RLG_OmniShadowMode mode);
+
+/**
+ * @brief Get the projection used to render the shadows of an omnilight.
+ *
+ * @param light The index of the light.
+ * @return The omnilight shadow mode of the light.
+ */
+RLG_OmniShadowMode RLG_GetOmniShadowMode(unsigned int light);
+
+/**
+ * @brief Set the range of resolutions that can be automatically selected for the shadow map of a light.
+ *
+ * Each time the shadow map is updated, its resolution is chosen among the powers of two
+ * within this range according to the estimated screen footprint of the light (its range
+ * of influence projected at its distance from the camera). Directional lights and lights
+ * without attenuation always use the maximum resolution. A resolution is only lowered once
+ * the footprint has dropped well below it, so that it does not change back and forth.
+ * The replaced shadow maps are kept in a pool to be reused by any light.
+ *
+ * @note The projection of the camera is the one used by the last call to RLG_DrawMesh.
+ *
+ * @param light The index of the light to configure.
+ * @param min The minimum resolution (e.g. 128).
+ * @param max The maximum resolution (e.g. 2048), 0 disables the automatic selection.
+ */
+void RLG_SetShadowResolutionRange(unsigned int light, int min, int max);
+
+/**
+ * @brief Set the distances from the camera over which the shadow of a light fades out.
+ *
+ * The distance is measured between the view position and the position of the light.
+ * Between the two distances the shadow term smoothly goes to 1.0 (fully lit). Beyond the
+ * end distance the shadow map is no longer sampled nor updated, until the light comes back
+ * within the end distance. The shadow is only turned off a little further than the end
+ * distance, so that a light at the limit does not toggle every frame.
+ *
+ * @note The fade is evaluated when the view position is set and when the shadows are updated.
+ *
+ * @param light The index of the light to configure.
+ * @param start The distance at which the shadow starts to fade.
+ * @param end The distance at which the shadow has fully faded, 0 disables the fade.
+ */
+void RLG_SetShadowFade(unsigned int light, float start, float end);
+
+/**
+ * @brief Get the distances from the camera over which the shadow of a light fades out.
+ *
+ * @param light The index of the light.
+ * @param start Pointer to store the distance at which the shadow starts to fade.
+ * @param end Pointer to store the distance at which the shadow has fully faded.
+ */
+void RLG_GetShadowFade(unsigned int light, float* start, float* end);
+
+/**
+ * @brief Check if the shadow of a light is currently skipped because of its distance.
+ *
+ * @param light The index of the light.
+ * @return true if the light is beyond its shadow fade distance, false otherwise.
+ */
+bool RLG_IsShadowFadedOut(unsigned int light);
+
+/**
+ * @brief Get the amount of memory used by the shadow maps.
+ *
+ * The shadow maps of all the lights are counted, as well as those kept in the pool
+ * and the render targets of the shadow mask.
+ *
+ * @return The estimated video memory used by the shadow maps, in bytes.
+ */
+size_t RLG_GetShadowMemoryUsage(void);
+
+/**
+ * @brief Free the least recently released shadow maps of the pool.
+ *
+ * The shadow maps released by RLG_DisableShadow, by a change of light type or shadow mode,
+ * or by the automatic resolution selection are kept in a pool, where they are reused by any
+ * light that needs a shadow map of the same kind and resolution. This function frees the
+ * ones released the longest ago until the pool fits in the given amount of memory.
+ *
+ * @param maxMemory The video memory the pool may keep, in bytes, 0 frees the whole pool.
+ */
+void RLG_TrimShadowPool(size_t maxMemory);
+
+/**
+ * @brief Get the occupancy of the shadow map pool.
+ *
+ * @return The statistics of the shadow map pool.
+ */
+RLG_ShadowPoolStats RLG_GetShadowPoolStats(void);
+
+/**
+ * @brief Enable or disable single-pass (layered) shadow rendering for omnilights.
+ *
+ * When enabled, the whole shadow cubemap is attached at once and each caster is
+ * submitted a single time, the routing to the cubemap faces being done on the GPU.
+ * Instanced rendering with gl_Layer is used for registered casters when
+ * GL_ARB_shader_viewport_layer_array is available, a geometry shader otherwise.
+ *
+ * @note Requires OpenGL 3.3 and the embedded shaders, the custom depth cubemap
+ *       shader is not used by this path.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) layered rendering.
+ */
+void RLG_UseLayeredShadowMaps(bool active);
+
+/**
+ * @brief Check if single-pass (layered) shadow rendering is enabled for omnilights.
+ *
+ * @return true if layered rendering is enabled, false otherwise.
+ */
+bool RLG_IsLayeredShadowMapsUsed(void);
+
+/**
+ * @brief Enable or disable the screen-space shadow mask.
+ *
+ * When enabled, RLG_UpdateShadowMask renders the depth of the scene and evaluates the shadows
+ * of up to four shadow casting lights once per pixel into an RGBA8 texture. The lighting shader
+ * then reads the shadows of these lights from the mask instead of sampling their shadow maps,
+ * so their cost no longer depends on overdraw or on the complexity of the materials.
+ * The other shadow casting lights are still evaluated per fragment.
+ *
+ * @note Requires OpenGL 3.3 and the embedded lighting shader.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the shadow mask.
+ */
+void RLG_UseShadowMask(bool active);
+
+/**
+ * @brief Check if the screen-space shadow mask is enabled.
+ *
+ * @return true if the shadow mask is enabled, false otherwise.
+ */
+bool RLG_IsShadowMaskUsed(void);
+
+/**
+ * @brief Set the resolution of the shadow mask relative to the render target.
+ *
+ * Below full resolution, the lighting shader upsamples the mask with weights based on the
+ * depth of the scene, so that the shadows of the foreground do not bleed on the background.
+ *
+ * @param scale The resolution scale, clamped between 0.25 and 1.0 (e.g. 0.5 for half resolution).
+ */
+void RLG_SetShadowMaskScale(float scale);
+
+/**
+ * @brief Get the resolution of the shadow mask relative to the render target.
+ *
+ * @return The resolution scale of the shadow mask.
+ */
+float RLG_GetShadowMaskScale(void);
+
+/**
+ * @brief Render the depth of the scene and the shadow mask of the coming frame.
+ *
+ * This function must be called every frame after the shadow maps have been updated and before
+ * the scene is drawn, with the camera used to draw it and outside BeginMode3D. The mask has the
+ * size of the current render target (the screen, or the texture given to BeginTextureMode).
+ * The draw function is called once with the depth shader, the scene must be drawn with the
+ * RLG_Cast* functions.
+ *
+ * @param camera The camera that will be used to draw the scene.
+ * @param drawFunc The function to draw the scene for the depth pre-pass.
+ */
+void RLG_UpdateShadowMask(Camera3D camera, RLG_DrawFunc drawFunc);
+
+/**
+ * @brief Retrieves the shadow mask texture.
+ *
+ * Each channel holds the shadow of one light, from 0 (in shadow) to 1 (lit).
+ *
+ * @return The shadow mask texture, empty if the shadow mask has never been updated.
+ */
+Texture RLG_GetShadowMask(void);
+
 /**
  * @brief Updates the shadow map for a given light source.
- * 
- * This function updates the shadow map for the specified light by calling the provided draw function.
- * It sets the active shadow map for the light and uses the draw function to render the scene.
- * 
+ *
+ * This function updates the shadow map for the specified light. The shadow casters
+ * registered with RLG_AddShadowCaster are culled against the light frustum (against each
+ * face frustum for omnilights) and the survivors are drawn by the library itself.
+ * Cubemap faces that have nothing to draw are skipped entirely.
+ *
+ * If a draw function is provided, it is also called for each rendered face, which
+ * allows you to draw casters that are not registered (in this case no face is skipped).
+ * With layered shadow maps it is called only once for all the faces of an omnilight,
+ * the casters must then be drawn with the RLG_Cast* functions and the given shader.
+ *
  * @param light The identifier of the light source for which to update the shadow map.
- * @param drawFunc The function to draw the scene for shadow rendering.
+ * @param drawFunc The function to draw the scene for shadow rendering (can be NULL).
  */
 void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc);
 
+/**
+ * @brief Updates the shadow maps of all the lights within a per-frame budget.
+ *
+ * This function is meant to be called once per frame instead of RLG_UpdateShadowMap.
+ * Each shadow casting light receives a priority based on its screen-space influence
+ * (range of the light relative to its distance from the view position), on its motion
+ * since its last update and on the age of its shadow map. The lights are then refreshed
+ * by decreasing priority until the budget is spent; the other lights keep their current
+ * shadow map and are served on the following frames, in a round-robin fashion.
+ *
+ * The budget is counted in rendered views: one for a directional or spot light and one
+ * per cubemap face for an omnilight, whose faces can be spread over several frames.
+ *
+ * @note With layered shadow maps an omnilight is always rendered as a whole (six views).
+ *
+ * @param drawFunc The function to draw the scene for shadow rendering (can be NULL).
+ * @param budget The maximum number of views to render, a value <= 0 updates everything.
+ */
+void RLG_UpdateShadows(RLG_DrawFunc drawFunc, int budget);
+
+/**
+ * @brief Get the age of the shadow map of a light.
+ *
+ * @param light The identifier of the light source.
+ * @return The number of RLG_UpdateShadows calls since the oldest face of the shadow map was rendered.
+ */
+unsigned int RLG_GetShadowUpdateAge(unsigned int light);
+
 /**
  * @brief Retrieves the shadow map texture for a given light source.
  * 
@@ -578,6 +943,83 @@ void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc);
  */
 Texture RLG_GetShadowMap(unsigned int light);
 
+/**
+ * @brief Register a model as a shadow caster managed by the library.
+ *
+ * The bounds of the model are stored with the caster so that RLG_UpdateShadowMap
+ * can skip it when it is outside the frustum of a light (or of a cubemap face).
+ *
+ * @note The model data is not copied, it must remain valid until the caster is removed.
+ *
+ * @param model The model to cast.
+ * @param transform The transformation matrix to apply to the model.
+ * @param flags A combination of RLG_CasterFlags, zero is treated as RLG_CAST_ALL.
+ * @return The identifier of the new caster, or 0 on failure.
+ */
+unsigned int RLG_AddShadowCaster(Model model, Matrix transform, unsigned int flags);
+
+/**
+ * @brief Remove a shadow caster previously registered with RLG_AddShadowCaster.
+ *
+ * @param caster The identifier of the caster to remove.
+ */
+void RLG_RemoveShadowCaster(unsigned int caster);
+
+/**
+ * @brief Update the transformation matrix of a registered shadow caster.
+ *
+ * @param caster The identifier of the caster to modify.
+ * @param transform The new transformation matrix to apply to the model.
+ */
+void RLG_SetShadowCasterTransform(unsigned int caster, Matrix transform);
+
+/**
+ * @brief Enable or disable the position-only vertex streams of the depth passes.
+ *
+ * When enabled, the meshes cast with a shader that only reads the vertex positions (such as
+ * the depth shaders given to the draw functions) are drawn through a vertex array that has no
+ * other attribute. It is built the first time each mesh is cast, from the CPU copy of its vertices.
+ * Meshes without a CPU copy of their vertices and animated meshes keep their own vertex array.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the position streams.
+ */
+void RLG_UsePositionStreams(bool active);
+
+/**
+ * @brief Check if the position-only vertex streams are enabled.
+ *
+ * @return true if the position streams are enabled, false otherwise.
+ */
+bool RLG_IsPositionStreamsUsed(void);
+
+/**
+ * @brief Enable or disable the 16-bit quantization of the position streams.
+ *
+ * Quantized positions are stored relative to the bounds of the mesh, in 8 bytes per vertex
+ * instead of 12. The precision is the size of the mesh divided by 65535 along each axis.
+ * Changing this setting releases the streams already built.
+ *
+ * @param active Boolean value indicating whether to quantize (true) or not (false) the positions.
+ */
+void RLG_UseQuantizedPositions(bool active);
+
+/**
+ * @brief Check if the position streams are quantized.
+ *
+ * @return true if the positions are quantized, false otherwise.
+ */
+bool RLG_IsQuantizedPositionsUsed(void);
+
+/**
+ * @brief Release the position stream built for a mesh.
+ *
+ * This must be called before unloading a mesh that has been cast while the position streams
+ * were enabled, or after modifying its vertices, the stream is rebuilt the next time it is cast.
+ *
+ * @param mesh The mesh whose position stream is released.
+ */
+void RLG_UnloadPositionStream(Mesh mesh);
+
 /**
  * @brief Casts a mesh for shadow rendering.
  * 
@@ -609,6 +1051,126 @@ void RLG_CastModel(Shader shader, Model model, Vector3 position, float scale);
  */
 void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale);
 
+/**
+ * @brief Enable or disable the depth pre-pass of the lighting shader.
+ *
+ * When enabled, RLG_DrawDepthPrepass fills the depth buffer with the depth shader, then the
+ * RLG_Draw* functions test the depth for equality without writing it. The lighting shader then
+ * runs once per visible pixel, instead of for every fragment later hidden by another surface.
+ *
+ * @note Fragments discarded by the lighting shader (parallax mapping clipped at the edges
+ * of the height map) are still written by the pre-pass and hide what lies behind them.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the depth pre-pass.
+ */
+void RLG_UseDepthPrepass(bool active);
+
+/**
+ * @brief Check if the depth pre-pass is enabled.
+ *
+ * @return true if the depth pre-pass is enabled, false otherwise.
+ */
+bool RLG_IsDepthPrepassUsed(void);
+
+/**
+ * @brief Fill the depth buffer before the scene is drawn with the lighting shader.
+ *
+ * This function must be called every frame within BeginMode3D, before the RLG_Draw* functions,
+ * it does nothing if the depth pre-pass is disabled. The draw function is called once with the
+ * depth shader, the scene must be drawn with the RLG_Cast* functions and the same transforms
+ * as the ones given to the RLG_Draw* functions.
+ *
+ * Until RLG_EndDepthPrepass, the RLG_Draw* functions into the same framebuffer test the depth
+ * for equality, so every mesh they draw must have been cast by the draw function. The meshes
+ * left out of the pre-pass, such as the transparent ones, are drawn after RLG_EndDepthPrepass.
+ *
+ * @param drawFunc The function to draw the scene for the depth pre-pass.
+ */
+void RLG_DrawDepthPrepass(RLG_DrawFunc drawFunc);
+
+/**
+ * @brief End the draws covered by the last depth pre-pass.
+ *
+ * Must be called after the meshes cast by RLG_DrawDepthPrepass have been drawn, at the latest
+ * before EndMode3D. The RLG_Draw* functions then test and write the depth as usual.
+ */
+void RLG_EndDepthPrepass(void);
+
+/**
+ * @brief Enable or disable the deferred shading path.
+ *
+ * When enabled, the RLG_Draw* functions called between RLG_BeginDeferred and RLG_EndDeferred
+ * write the surfaces of the scene into a G-buffer (albedo/metalness, octahedral normal/roughness,
+ * emission with the ambient and skybox lighting, and depth) with the same material maps and
+ * RLG_UseMap toggles as the lighting shader. RLG_EndDeferred then accumulates the lights one by one,
+ * each covering only the pixels of its volume (a sphere for omnilights, a cone for spotlights,
+ * the whole screen for directional lights), so the cost of a light no longer depends on overdraw
+ * or on the complexity of the materials.
+ *
+ * The RLG_Draw* functions called outside of these two calls still use the forward lighting shader,
+ * this is how transparent objects must be drawn, after RLG_EndDeferred.
+ *
+ * @note Requires OpenGL 3.3 and the embedded lighting shader. The lights do not read the shadow mask
+ * in the deferred path, their shadows are evaluated once per pixel anyway.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the deferred path.
+ */
+void RLG_UseDeferred(bool active);
+
+/**
+ * @brief Check if the deferred shading path is enabled.
+ *
+ * @return true if the deferred path is enabled, false otherwise.
+ */
+bool RLG_IsDeferredUsed(void);
+
+/**
+ * @brief Start drawing the opaque objects of the scene into the G-buffer.
+ *
+ * This function must be called within BeginMode3D, after the shadow maps have been updated.
+ * The G-buffer has the size of the current render target (the screen, or the texture given to
+ * BeginTextureMode). It does nothing if the deferred path is disabled, the RLG_Draw* functions
+ * then draw with the forward lighting shader as usual.
+ */
+void RLG_BeginDeferred(void);
+
+/**
+ * @brief Light the G-buffer into the current render target.
+ *
+ * This function must be called within the same BeginMode3D as RLG_BeginDeferred. The depth of
+ * the G-buffer is written along with the lit pixels, so that the objects drawn afterwards with
+ * the forward lighting shader are hidden by the opaque ones. The pixels not covered by any
+ * object keep the content of the render target.
+ */
+void RLG_EndDeferred(void);
+
+/**
+ * @brief Enable or disable the multi-pass forward lighting.
+ *
+ * When enabled, the RLG_Draw* functions draw each mesh once with the ambient, skybox and emission
+ * lighting, then once more for each light that reaches it, added with a lighting shader that only
+ * evaluates one light. A light whose range does not intersect the bounds of the mesh is skipped,
+ * and the other ones are restricted to the screen rectangle where their range overlaps the mesh.
+ * This suits scenes with few objects and many small lights, where most lights only touch a part
+ * of the screen.
+ *
+ * @note The bounds of a mesh are computed from its CPU vertices, the meshes without them (or animated)
+ * receive every light on the whole screen. Spotlights are bounded by the sphere of their range.
+ *
+ * @note The lights do not read the shadow mask in the multi-pass path, and the deferred path
+ * takes precedence between RLG_BeginDeferred and RLG_EndDeferred.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the multi-pass lighting.
+ */
+void RLG_UseMultiPass(bool active);
+
+/**
+ * @brief Check if the multi-pass forward lighting is enabled.
+ *
+ * @return true if the multi-pass lighting is enabled, false otherwise.
+ */
+bool RLG_IsMultiPassUsed(void);
+
 /**
  * @brief Draw a mesh with a specified material and transformation.
  * 
@@ -647,26 +1209,142 @@ void RLG_DrawModel(Model model, Vector3 position, float scale, Color tint);
 void RLG_DrawModelEx(Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale, Color tint);
 
 /**
- * @brief Loads a skybox from a file.
+ * @brief Set how the skyboxes loaded afterwards store their diffuse irradiance.
  *
- * This function loads a skybox texture from the specified file and returns
- * a RLG_Skybox structure containing the cubemap texture.
+ * In the RLG_IRRADIANCE_SH9 mode, the environment is projected onto nine spherical harmonics
+ * on the CPU instead of being convolved into the irradiance cubemap, which is then left unloaded.
+ * The coefficients are given to the lighting shader with RLG_SetIrradianceSH, the irradiance then
+ * costs a few multiply-adds per fragment instead of a cubemap fetch.
  *
- * @param skyboxFileName The path to the skybox texture file.
- * @return RLG_Skybox The loaded skybox.
+ * In the RLG_IRRADIANCE_SAMPLED_CUBEMAP mode, the irradiance cubemap is convolved with importance
+ * sampling over the mipmaps of the environment, see RLG_SetIrradianceSampleCount and RLG_BakeSkyboxStep.
+ *
+ * @note Reading back the faces of an LDR skybox requires desktop OpenGL, on OpenGL ES
+ * RLG_LoadSkybox keeps generating the irradiance cubemap.
+ *
+ * @param mode The irradiance mode to use for the next skybox loads.
  */
-RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName);
+void RLG_SetIrradianceMode(RLG_IrradianceMode mode);
 
 /**
- * @brief Loads a HDR skybox from a file with specified size and format.
+ * @brief Get the irradiance mode used to load the skyboxes.
  *
- * This function loads a high dynamic range (HDR) skybox texture from the
- * specified file. It creates a cubemap texture with the given size and format.
+ * @return The current irradiance mode.
+ */
+RLG_IrradianceMode RLG_GetIrradianceMode(void);
+
+/**
+ * @brief Set the spherical harmonics irradiance used as ambient lighting.
+ *
+ * While set, the coefficients replace both the ambient color and the irradiance cubemap
+ * of the materials (MATERIAL_MAP_IRRADIANCE) for the lighting shader.
+ *
+ * @param coefficients The nine coefficients of a skybox loaded in the SH9 mode, or NULL to stop using them.
+ */
+void RLG_SetIrradianceSH(const Vector3 *coefficients);
+
+/**
+ * @brief Set the number of samples per texel of the sampled irradiance cubemaps.
+ *
+ * Used by the RLG_IRRADIANCE_SAMPLED_CUBEMAP mode. The samples are distributed over the hemisphere
+ * with a cosine-weighted Hammersley sequence and read the mipmap of the environment matching
+ * their solid angle, so a few hundred samples are enough for a smooth result (default: 512).
+ *
+ * @param count The number of samples, clamped between 1 and RLG_IRRADIANCE_MAX_SAMPLES.
+ */
+void RLG_SetIrradianceSampleCount(int count);
+
+/**
+ * @brief Get the number of samples per texel of the sampled irradiance cubemaps.
+ *
+ * @return The current number of samples.
+ */
+int RLG_GetIrradianceSampleCount(void);
+
+/**
+ * @brief Enable or disable the incremental baking of the sampled irradiance cubemaps.
+ *
+ * By default the skybox loaders render the whole irradiance cubemap before returning.
+ * When enabled, they only allocate it, cleared to black, and the application renders
+ * it a few tiles at a time over the next frames with RLG_BakeSkyboxStep.
+ *
+ * @param active Boolean value to enable (true) or disable (false) the incremental baking.
+ */
+void RLG_UseIncrementalSkyboxBake(bool active);
+
+/**
+ * @brief Check if the sampled irradiance cubemaps are baked incrementally.
+ *
+ * @return true if the incremental baking is enabled, false otherwise.
+ */
+bool RLG_IsIncrementalSkyboxBakeUsed(void);
+
+/**
+ * @brief Render the next tiles of the irradiance cubemap of a skybox.
+ *
+ * Each face of the irradiance cubemap is divided into tiles of 16x16 texels,
+ * the cost of a tile only depends on the sample count, which lets the application
+ * bound the time spent baking in each frame.
+ *
+ * The irradiance cubemap can be assigned to materials while it is baked. For a
+ * packed skybox it is converted to the packed format by the last step, in place,
+ * so the copies of skybox->irradiance keep a valid texture ID.
+ *
+ * @param skybox The skybox being baked, loaded in the RLG_IRRADIANCE_SAMPLED_CUBEMAP mode.
+ * @param tileCount The maximum number of tiles to render in this call.
+ * @return true if the irradiance cubemap is complete, false if tiles remain to be rendered.
+ */
+bool RLG_BakeSkyboxStep(RLG_Skybox *skybox, int tileCount);
+
+/**
+ * @brief Get the BRDF integration lookup table of the split-sum image based lighting.
+ *
+ * The table is computed on the CPU by the first call and kept by the context.
+ * Set it as the MATERIAL_MAP_BRDF texture of the materials reflecting a skybox,
+ * along with the prefilter cubemap of the skybox as their MATERIAL_MAP_PREFILTER texture,
+ * and enable both maps with RLG_UseMap to replace the reflection of the full resolution cubemap.
+ *
+ * @return The BRDF lookup table, indexed by the cosine of the view angle and the roughness.
+ */
+Texture2D RLG_GetBRDFLUT(void);
+
+/**
+ * @brief Loads a skybox from a file.
+ *
+ * This function loads a skybox texture from the specified file and returns
+ * a RLG_Skybox structure containing the cubemap texture.
+ *
+ * @param skyboxFileName The path to the skybox texture file.
+ * @return RLG_Skybox The loaded skybox.
+ */
+RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName);
+
+/**
+ * @brief Load a Radiance (.hdr) image as R32G32B32 floats.
+ *
+ * The file is memory-mapped, its scanlines are located in a first pass and then
+ * decoded by the worker threads. The files using the old run-length encoding,
+ * another orientation or another format are left to LoadImage.
+ *
+ * @param fileName The path of the image file.
+ * @return The loaded image, to unload with UnloadImage.
+ */
+Image RLG_LoadImageHDR(const char *fileName);
+
+/**
+ * @brief Loads a HDR skybox from a file with specified size and format.
+ *
+ * This function loads a high dynamic range (HDR) skybox texture from the
+ * specified file. It creates a cubemap texture with the given size and format.
  *
  * @note On some Android devices with WebGL, framebuffer objects (FBO)
  * do not properly support a FLOAT-based attachment, so the function uses
  * PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 instead of PIXELFORMAT_UNCOMPRESSED_R32G32B32A32.
  *
+ * The packed formats of RLG_PixelFormat take a third of the memory of
+ * PIXELFORMAT_UNCOMPRESSED_R32G32B32. RGB9E5 cannot be rendered to, nor R11G11B10F
+ * on some drivers, such skyboxes are rendered in float and converted on the CPU.
+ *
  * @param skyboxFileName The path to the skybox texture file.
  * @param size The size of the cubemap texture.
  * @param format The pixel format of the cubemap texture.
@@ -674,6 +1352,97 @@ RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName);
  */
 RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format);
 
+/**
+ * @brief Start loading a HDR skybox without blocking the calling thread.
+ *
+ * The panorama is decoded by a worker thread, then each call to RLG_PollSkybox
+ * uploads a few megabytes of it through a pixel buffer object, or renders a face
+ * of one of the cubemaps, so that the load is spread over the frames.
+ * The irradiance mode is the one of the context when the load starts, and the
+ * context must stay the current one until the load ends. The sampled irradiance
+ * is rendered by the polls too, whether the incremental baking is enabled or not.
+ *
+ * @param skyboxFileName The path to the skybox texture file.
+ * @param size The size of the cubemap texture.
+ * @param format The pixel format of the cubemap texture, as for RLG_LoadSkyboxHDR.
+ * @return The handle of the load, to poll until it returns true, or NULL if it could not start.
+ */
+RLG_SkyboxLoad RLG_LoadSkyboxHDRAsync(const char* skyboxFileName, int size, int format);
+
+/**
+ * @brief Advance an asynchronous skybox load by one step.
+ *
+ * Once the panorama is decoded, the skybox written is usable with the textures
+ * completed so far, the others having an ID of 0, and with an irradiance cubemap
+ * evaluated from the SH9 projection of the panorama until its own is rendered.
+ * Its textures change from one poll to the next, it should be called once per
+ * frame before drawing, and the skybox it writes used for that frame only.
+ *
+ * @param load The handle returned by RLG_LoadSkyboxHDRAsync, released once the load ends.
+ * @param skybox The skybox in its current state, owned by the application once the load ends.
+ * @return true if the load has ended, false otherwise. A skybox whose panorama
+ * could not be loaded ends with a cubemap ID of 0.
+ */
+bool RLG_PollSkybox(RLG_SkyboxLoad load, RLG_Skybox *skybox);
+
+/**
+ * @brief Stop an asynchronous skybox load and unload what it has loaded.
+ *
+ * Waits for the worker thread if the panorama is still being decoded.
+ *
+ * @param load The handle returned by RLG_LoadSkyboxHDRAsync, not yet ended by RLG_PollSkybox.
+ */
+void RLG_CancelSkyboxLoad(RLG_SkyboxLoad load);
+
+/**
+ * @brief Save the baked textures of a skybox to a binary file.
+ *
+ * The file contains every mip level of the cubemap, of the prefiltered radiance
+ * and of the irradiance cubemap, or the SH9 coefficients, with a header keyed by
+ * a hash of the source file and by the bake parameters of the context.
+ * A skybox whose irradiance is still being baked by RLG_BakeSkyboxStep cannot be saved.
+ *
+ * @note Not available on OpenGL ES, where textures cannot be read back.
+ *
+ * @param skybox The skybox to save.
+ * @param bakeFileName The path of the file to write.
+ * @param skyboxFileName The path of the source file the skybox was loaded from, or NULL to key the bake on the parameters only.
+ * @return true if the file was written, false otherwise.
+ */
+bool RLG_SaveSkyboxBake(RLG_Skybox skybox, const char *bakeFileName, const char *skyboxFileName);
+
+/**
+ * @brief Load a skybox from a file written by RLG_SaveSkyboxBake.
+ *
+ * The file is memory-mapped and its levels are uploaded as they are, no
+ * decoding nor rendering is done. It is rejected when the source file has changed
+ * or when the irradiance mode, the irradiance sample count or the prefilter options
+ * differ from the ones of the bake, the application then loads the source again.
+ * The size and the format of the cubemap are the ones of the baked skybox.
+ *
+ * @param bakeFileName The path of the bake file.
+ * @param skyboxFileName The path of the source file of the skybox, or NULL to skip its check when only the bake is shipped.
+ * @return The loaded skybox, with a cubemap id of 0 if the bake is missing or outdated.
+ */
+RLG_Skybox RLG_LoadSkyboxBake(const char *bakeFileName, const char *skyboxFileName);
+
+/**
+ * @brief Bake a skybox on the CPU into a file loaded by RLG_LoadSkyboxBake.
+ *
+ * The cubemap, its prefiltered radiance and its irradiance are computed by the worker
+ * threads the same way as by the GPU loaders, without a context nor a window,
+ * which lets build machines bake the skyboxes of a project offline.
+ * The cubemap is stored as R32G32B32 floats.
+ *
+ * @param skyboxFileName The path of the equirectangular source image.
+ * @param bakeFileName The path of the bake file to write.
+ * @param size The face size of the cubemap.
+ * @param irradianceMode The irradiance mode of the contexts that will load the bake.
+ * @param irradianceSamples The irradiance sample count of these contexts (sampled cubemap mode only).
+ * @return true if the file was written, false otherwise.
+ */
+bool RLG_BakeSkyboxFile(const char *skyboxFileName, const char *bakeFileName, int size, RLG_IrradianceMode irradianceMode, int irradianceSamples);
+
 /**
  * @brief Unloads a skybox.
  *
@@ -684,15 +1453,102 @@ RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format);
  */
 void RLG_UnloadSkybox(RLG_Skybox skybox);
 
+/**
+ * @brief Get the video memory used by the textures of a skybox.
+ *
+ * @param skybox The skybox to measure.
+ * @return The size of every mip level of its cubemaps, in bytes.
+ */
+size_t RLG_GetSkyboxMemory(RLG_Skybox skybox);
+
 /**
  * @brief Draws a skybox.
  *
- * This function renders the specified skybox.
+ * This function renders the specified skybox on the far plane, with a depth test
+ * passing on equality and without writing depth. It can be drawn before the scene,
+ * but drawing it after the opaque geometry only shades the pixels left uncovered.
  *
  * @param skybox The skybox to be drawn.
  */
 void RLG_DrawSkybox(RLG_Skybox skybox);
 
+/**
+ * @brief Create a local reflection probe.
+ *
+ * The probe captures the scene around its position into a cubemap, drawn with the lighting
+ * shader by RLG_UpdateReflectionProbes, then prefilters it like the radiance of a skybox.
+ * Once it is complete, it replaces the MATERIAL_MAP_PREFILTER texture of the meshes whose
+ * origin lies within its box (the smallest box when several contain it), and the reflections
+ * are projected on the box to correct their parallax.
+ *
+ * @note The probes only change the split-sum reflections, that is when MATERIAL_MAP_PREFILTER
+ * and MATERIAL_MAP_BRDF are both used.
+ *
+ * @note A new probe is static: it is captured once, then kept until RLG_RefreshReflectionProbe.
+ *
+ * @note The prefiltered radiance is double-buffered, the meshes keep sampling the last complete
+ * refresh while the next one is rendered, at the cost of a second prefiltered cubemap.
+ *
+ * @param position The position the scene is captured from, within the box.
+ * @param box The bounds of the area covered by the probe, matching the walls of a room for instance.
+ * @param resolution The face size of the captured cubemap.
+ * @return The identifier of the new probe, or 0 on failure.
+ */
+unsigned int RLG_CreateReflectionProbe(Vector3 position, BoundingBox box, int resolution);
+
+/**
+ * @brief Destroy a reflection probe previously created with RLG_CreateReflectionProbe.
+ *
+ * @param probe The identifier of the probe to destroy.
+ */
+void RLG_DestroyReflectionProbe(unsigned int probe);
+
+/**
+ * @brief Set whether a reflection probe is captured once or continuously.
+ *
+ * @param probe The identifier of the probe.
+ * @param isStatic true to capture the probe once (default), false to capture it again
+ * and again, for the scenes that move within its box.
+ */
+void RLG_SetReflectionProbeStatic(unsigned int probe, bool isStatic);
+
+/**
+ * @brief Capture a static reflection probe again, after the scene around it has changed.
+ *
+ * The previous capture keeps being sampled until the new one is complete.
+ *
+ * @param probe The identifier of the probe.
+ */
+void RLG_RefreshReflectionProbe(unsigned int probe);
+
+/**
+ * @brief Update the reflection probes within a per-frame budget.
+ *
+ * This function is meant to be called once per frame, after the shadow maps have been updated
+ * and outside of RLG_BeginDeferred and RLG_EndDeferred. The budget is counted in steps: a step
+ * renders one face of the capture of a probe, or prefilters one face once the six faces have
+ * been captured, so a probe is refreshed in twelve steps. The probes that have never been
+ * completed are served first, then the others in a round-robin fashion, and the static probes
+ * that are up to date are skipped.
+ *
+ * The draw function is called with the lighting shader for each captured face, the scene must
+ * be drawn with the RLG_Draw* functions (and RLG_DrawSkybox for the background). The view and
+ * projection are those of the face, the lighting runs in the forward path, without the depth
+ * pre-pass, the shadow mask nor the reflection probes themselves.
+ *
+ * @param drawFunc The function to draw the scene around the probes.
+ * @param budget The maximum number of steps to run, a value <= 0 refreshes every probe once.
+ */
+void RLG_UpdateReflectionProbes(RLG_DrawFunc drawFunc, int budget);
+
+/**
+ * @brief Get the prefiltered radiance of a reflection probe.
+ *
+ * @param probe The identifier of the probe.
+ * @return The prefiltered cubemap of the probe, empty until its first capture is complete.
+ */
+TextureCubemap RLG_GetReflectionProbe(unsigned int probe);
+
 
 #if defined(__cplusplus)
 }
@@ -701,10 +1557,54 @@ void RLG_DrawSkybox(RLG_Skybox skybox);
 #include "raymath.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "rlgl.h"
 
+#include <stdint.h>                         // Required for: uint32_t, uint64_t
+
+#if RLG_WORKER_THREADS > 1 && !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#   include <pthread.h>                     // Required for: pthread_create(), pthread_join()
+#   define RLG_THREADS_SUPPORTED
+#endif
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#   include <pthread.h>                     // Required for: pthread_create(), pthread_mutex_lock()
+#   define RLG_ASYNC_LOAD_SUPPORTED
+#endif
+
+#if defined(__SSE2__)
+#   include <emmintrin.h>                   // Required for: the SSE2 conversion of the RGBE texels
+#endif
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#   include <sys/mman.h>                    // Required for: mmap(), munmap()
+#   include <sys/stat.h>                    // Required for: fstat()
+#   include <fcntl.h>                       // Required for: open()
+#   include <unistd.h>                      // Required for: close()
+#   define RLG_MMAP_SUPPORTED
+#endif
+
 /* Helper macros */
 
+/* Shadow filtering options */
+
+#if GLSL_VERSION < 330
+#   undef RLG_SHADOW_HARDWARE_PCF   // Depth comparison samplers are not available with GLSL 100
+#   undef RLG_SHADOW_PCF_POISSON    // Array constructors are not available with GLSL 100
+#endif
+
+#if RLG_SHADOW_PCF_TAPS == 1
+#   define RLG_SHADOW_PCF_SIZE 1
+#elif RLG_SHADOW_PCF_TAPS == 4
+#   define RLG_SHADOW_PCF_SIZE 2
+#elif RLG_SHADOW_PCF_TAPS == 9
+#   define RLG_SHADOW_PCF_SIZE 3
+#elif RLG_SHADOW_PCF_TAPS == 16
+#   define RLG_SHADOW_PCF_SIZE 4
+#else
+#   error "RLG_SHADOW_PCF_TAPS must be 1, 4, 9 or 16"
+#endif
+
 #define STRINGIFY(x) #x             ///< NOTE: Undefined at the end of the header
 #define TOSTRING(x) STRINGIFY(x)    ///< NOTE: Undefined at the end of the header
 
@@ -731,7 +1631,7 @@ void RLG_DrawSkybox(RLG_Skybox skybox);
 /* Helper defintions */
 
 #define RLG_COUNT_MATERIAL_MAPS 12  ///< Same as MAX_MATERIAL_MAPS defined in raylib/config.h
-#define RLG_COUNT_SHADERS 6         ///< Total shader used by rlights.h internally
+#define RLG_COUNT_SHADERS 8         ///< Total shader used by rlights.h internally
 
 /* Uniform names definitions */
 
@@ -762,6 +1662,7 @@ void RLG_DrawSkybox(RLG_Skybox skybox);
 
 #   define GLSL_TEXTURE_DEF         "#define TEX texture2D\n"
 #   define GLSL_TEXTURE_CUBE_DEF    "#define TEXCUBE textureCube\n"
+#   define GLSL_TEXTURE_CUBE_LOD_DEF "#define TEXCUBE_LOD textureCube\n"     // The level is applied as a bias
 
 #   define GLSL_FS_OUT_DEF          ""
 
@@ -779,6 +1680,7 @@ void RLG_DrawSkybox(RLG_Skybox skybox);
 
 #   define GLSL_TEXTURE_DEF         "#define TEX texture\n"
 #   define GLSL_TEXTURE_CUBE_DEF    "#define TEXCUBE texture\n"
+#   define GLSL_TEXTURE_CUBE_LOD_DEF "#define TEXCUBE_LOD textureLod\n"
 
 #   define GLSL_FS_OUT_DEF          "out vec4 _;"
 
@@ -794,6 +1696,16 @@ void RLG_DrawSkybox(RLG_Skybox skybox);
 
 #endif
 
+#ifdef RLG_SHADOW_HARDWARE_PCF
+#   define GLSL_SHADOW_SAMPLER_DEF          "sampler2DShadow"
+#   define GLSL_SHADOW_CUBE_SAMPLER_DEF     "samplerCubeShadow"
+#   define GLSL_SHADOW_TAP(offset)          "texture(lights[i].shadowMap, vec3(projCoords.xy + " offset "*lights[i].shadowMapTxlSz, depth))"
+#else
+#   define GLSL_SHADOW_SAMPLER_DEF          "sampler2D"
+#   define GLSL_SHADOW_CUBE_SAMPLER_DEF     "samplerCube"
+#   define GLSL_SHADOW_TAP(offset)          "step(depth, TEX(lights[i].shadowMap, projCoords.xy + " offset "*lights[i].shadowMapTxlSz).r)"
+#endif
+
 /* Shader */
 
 static const char rlgLightingVS[] = GLSL_VERSION_DEF
@@ -821,6 +1733,8 @@ static const char rlgLightingVS[] = GLSL_VERSION_DEF
     GLSL_VS_OUT("vec4 fragColor")
     GLSL_VS_FLAT_OUT("mat3 TBN")
 
+    "invariant gl_Position;"    ///< Same depth as the depth shader for the depth pre-pass
+
     "void main()"
     "{"
         "fragPosition = vec3(" RLG_SHADER_LIGHTING_UNIFORM_MATRIX_MODEL "*vec4(" RLG_SHADER_LIGHTING_ATTRIB_POSITION ", 1.0));"
@@ -846,11 +1760,12 @@ static const char rlgLightingVS[] = GLSL_VERSION_DEF
     "}";
 
 static const char rlgLightingFS[] = GLSL_VERSION_DEF
-    GLSL_TEXTURE_DEF GLSL_TEXTURE_CUBE_DEF
+    GLSL_TEXTURE_DEF GLSL_TEXTURE_CUBE_DEF GLSL_TEXTURE_CUBE_LOD_DEF
 
     "#define NUM_LIGHTS"                " %i\n"
-    "#define NUM_MATERIAL_MAPS"         " 7\n"
-    "#define NUM_MATERIAL_CUBEMAPS"     " 2\n"
+    "%s"    // Receives the SHADOW_MASK, GBUFFER, DEFERRED_LIGHT or MULTI_PASS definition of the derived shaders
+    "#define NUM_MATERIAL_MAPS"         " 8\n"
+    "#define NUM_MATERIAL_CUBEMAPS"     " 3\n"
 
     "#define DIRLIGHT"                  " 0\n"
     "#define OMNILIGHT"                 " 1\n"
@@ -863,15 +1778,34 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
     "#define OCCLUSION"                 " 4\n"
     "#define EMISSION"                  " 5\n"
     "#define HEIGHT"                    " 6\n"
+    "#define BRDF"                      " 7\n"
 
     "#define CUBEMAP"                   " 0\n"
     "#define IRRADIANCE"                " 1\n"
+    "#define PREFILTER"                 " 2\n"
+
+    "#define PREFILTER_MAX_LOD"         " (float(" TOSTRING(RLG_PREFILTER_MIP_LEVELS) ") - 1.0)\n"
+
+    // The split-sum reflection replaces the mix of the specular lighting with the skybox
+    "#define SPLIT_SUM"                 " (cubemaps[PREFILTER].active != 0 && maps[BRDF].active != 0)\n"
+    "#define SKYBOX_MIX"                " (cubemaps[CUBEMAP].active != 0 && !SPLIT_SUM)\n"
 
     "#define PI 3.1415926535897932384626433832795028\n"
 
     GLSL_PRECISION("mediump float")
 
 #   if GLSL_VERSION > 100
+    // The shadow mask and deferred light passes draw a fullscreen triangle or a light volume,
+    // the position of the fragment is reconstructed from the depth of the scene instead
+    "\n#if defined(SHADOW_MASK) || defined(DEFERRED_LIGHT)\n"
+    "uniform mat4 matLights[NUM_LIGHTS];"
+    "uniform mat4 sceneInvViewProj;"
+    "vec4 fragPosLightSpace[NUM_LIGHTS];"
+    "vec3 fragPosition;"
+    "\n#ifdef SHADOW_MASK\n"
+    GLSL_FS_IN("vec2 fragTexCoord")
+    "\n#endif\n"
+    "\n#else\n"
     GLSL_FS_IN("vec4 fragPosLightSpace[NUM_LIGHTS]")
 #   else
     "uniform mat4 matLights[NUM_LIGHTS];"
@@ -883,7 +1817,22 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
     GLSL_FS_IN("vec4 fragColor")
     GLSL_FS_FLAT_IN("mat3 TBN")
 
+#   if GLSL_VERSION > 100
+    "\n#endif\n"
+#   endif
+
+#   if GLSL_VERSION > 100
+    // The G-buffer pass writes the attributes of the surface to three render targets
+    "\n#ifdef GBUFFER\n"
+    "layout(location = 0) out vec4 gbufferAlbedo;"     ///< Albedo and metalness (RGBA8)
+    "layout(location = 1) out vec4 gbufferNormal;"     ///< Octahedral normal, roughness and skybox reflection flag (RGB10_A2)
+    "layout(location = 2) out vec4 gbufferLighting;"   ///< Lighting that does not depend on the lights, light affect of the AO (RGBA16F)
+    "\n#else\n"
+    GLSL_FS_OUT_DEF
+    "\n#endif\n"
+#   else
     GLSL_FS_OUT_DEF
+#   endif
 
     "struct MaterialMap {"
         "sampler2D texture;"
@@ -900,8 +1849,11 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
     "};"
 
     "struct Light {"
-        "samplerCube shadowCubemap;"    ///< Sampler for the shadow map texture
-        "sampler2D shadowMap;"          ///< Sampler for the shadow map texture
+        GLSL_SHADOW_CUBE_SAMPLER_DEF " shadowCubemap;"  ///< Sampler for the shadow map texture
+        GLSL_SHADOW_SAMPLER_DEF " shadowMap;"           ///< Sampler for the shadow map texture
+#   if GLSL_VERSION > 100
+        "sampler2D shadowMoments;"      ///< Sampler for the depth moments texture (VSM/EVSM)
+#   endif
         "vec3 position;"                ///< Position of the light in world coordinates
         "vec3 direction;"               ///< Direction vector of the light (for directional and spotlights)
         "vec3 color;"                   ///< Diffuse color of the light
@@ -915,8 +1867,13 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
         "float quadratic;"              ///< Quadratic attenuation factor
         "float shadowMapTxlSz;"         ///< Texel size of the shadow map
         "float depthBias;"              ///< Bias value to avoid self-shadowing artifacts
+        "vec2 shadowDepthParams;"       ///< Converts a distance to the light to the depth of the shadow map (omnilights)
+        "float shadowFade;"             ///< Weight of the shadow, lowered as the light gets far from the camera
         "lowp int type;"                ///< Type of the light (e.g., point, directional, spotlight)
         "lowp int shadow;"              ///< Indicates if the light casts shadows (1 for true, 0 for false)
+        "lowp int shadowTechnique;"     ///< Shadow filtering technique (0 for PCF, 1 for VSM, 2 for EVSM)
+        "lowp int omniShadowMode;"      ///< Omnilight shadow projection (0 for cubemap, 1 for dual-paraboloid)
+        "lowp int shadowMaskChannel;"   ///< Channel of the shadow mask holding the shadow of the light, -1 if none
         "lowp int enabled;"             ///< Indicates if the light is active (1 for true, 0 for false)
     "};"
 
@@ -927,11 +1884,51 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
     "uniform lowp int parallaxMinLayers;"
     "uniform lowp int parallaxMaxLayers;"
 
-    "uniform float farPlane;"   ///< Used to scale depth values ​​when reading the depth cubemap (point shadows)
+    "uniform vec3 irradianceSH[9];"        ///< Irradiance divided by PI, premultiplied by the basis constants
+    "uniform lowp int useIrradianceSH;"
+
+    "uniform lowp int useProbe;"           ///< Reflection probe bound in place of the prefiltered radiance of the skybox
+    "uniform vec3 probePosition;"
+    "uniform vec3 probeBoxMin;"
+    "uniform vec3 probeBoxMax;"
+
+    // The multi-pass lighting draws the ambient, skybox and emission lighting first,
+    // then adds each light with its own pass, in the slot of the first light
+    "\n#ifdef MULTI_PASS\n"
+    "uniform lowp int lightPass;"
+    "\n#endif\n"
+
+#   ifdef RLG_SHADOW_PCF_POISSON
+    "const vec2 POISSON_DISK[16] = vec2[]("
+        "vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),"
+        "vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),"
+        "vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),"
+        "vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),"
+        "vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),"
+        "vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),"
+        "vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),"
+        "vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)"
+    ");"
+#   endif
 
     "uniform vec3 " RLG_SHADER_LIGHTING_UNIFORM_COLOR_AMBIENT ";"
     "uniform vec3 " RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION ";"
 
+#   if GLSL_VERSION > 100
+    "uniform sampler2D shadowMask;"     ///< Shadows of up to four lights evaluated once per pixel
+    "uniform sampler2D sceneDepth;"     ///< Depth of the scene rendered before the shadow mask
+    "uniform vec4 sceneDepthParams;"    ///< Terms of the inverse projection giving the view depth
+    "uniform lowp int useShadowMask;"
+    "vec4 shadowMaskValue = vec4(1.0);"    ///< Shadows of the mask at the current fragment
+
+    "\n#ifdef DEFERRED_LIGHT\n"
+    "uniform sampler2D gbufferAlbedo;"
+    "uniform sampler2D gbufferNormal;"
+    "uniform sampler2D gbufferLighting;"
+    "uniform sampler2D gbufferDepth;"
+    "\n#endif\n"
+#   endif
+
     "float DistributionGGX(float cosTheta, float alpha)"
     "{"
         "float a = cosTheta*alpha;"
@@ -953,6 +1950,30 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
         "return m2*m2*m;" // pow(m,5)
     "}"
 
+    // Evaluate the irradiance from the nine SH coefficients, already divided by PI
+    // SEE: https://graphics.stanford.edu/papers/envmap/envmap.pdf
+    "vec3 IrradianceSH(vec3 n)"
+    "{"
+        "vec3 e = irradianceSH[0]"
+            "+ irradianceSH[1]*n.y + irradianceSH[2]*n.z + irradianceSH[3]*n.x"
+            "+ irradianceSH[4]*(n.x*n.y) + irradianceSH[5]*(n.y*n.z)"
+            "+ irradianceSH[6]*(3.0*n.z*n.z - 1.0)"
+            "+ irradianceSH[7]*(n.x*n.z) + irradianceSH[8]*(n.x*n.x - n.y*n.y);"
+        "return max(e, vec3(0.0));"
+    "}"
+
+    // Intersect the reflected ray with the box of the probe, the direction from the probe
+    // to the intersection gives what the capture shows in the reflection of the fragment
+    // SEE: https://seblagarde.wordpress.com/2012/09/29/image-based-lighting-approaches-and-parallax-corrected-cubemap/
+    "vec3 BoxProjection(vec3 R)"
+    "{"
+        "vec3 planeMax = (probeBoxMax - fragPosition)/R;"
+        "vec3 planeMin = (probeBoxMin - fragPosition)/R;"
+        "vec3 furthest = max(planeMax, planeMin);"
+        "float distance = min(min(furthest.x, furthest.y), furthest.z);"
+        "return fragPosition + R*distance - probePosition;"
+    "}"
+
     "vec3 ComputeF0(float metallic, float specular, vec3 albedo)"
     "{"
         "float dielectric = 0.16*specular*specular;"
@@ -1002,11 +2023,19 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
     "float ShadowOmni(int i, float cNdotL)"
     "{"
         "vec3 fragToLight = fragPosition - lights[i].position;"
-        "float closestDepth = TEXCUBE(lights[i].shadowCubemap, fragToLight).r;"
-        "closestDepth *= farPlane;" // Rescale depth
-        "float currentDepth = length(fragToLight);"
         "float bias = lights[i].depthBias*max(1.0 - cNdotL, 0.05);"
-        "return currentDepth - bias > closestDepth ? 0.0 : 1.0;"
+
+        // The view depth in the face the fragment projects to is the distance along the major axis,
+        // it is converted to the perspective depth written by the rasterizer for this face
+        "vec3 axisDistances = abs(fragToLight);"
+        "float viewDepth = max(axisDistances.x, max(axisDistances.y, axisDistances.z)) - bias;"
+        "float currentDepth = lights[i].shadowDepthParams.x - lights[i].shadowDepthParams.y/viewDepth;"
+#   ifdef RLG_SHADOW_HARDWARE_PCF
+        "return texture(lights[i].shadowCubemap, vec4(fragToLight, currentDepth));"
+#   else
+        "float closestDepth = TEXCUBE(lights[i].shadowCubemap, fragToLight).r;"
+        "return currentDepth > closestDepth ? 0.0 : 1.0;"
+#   endif
     "}"
 
     "float Shadow(int i, float cNdotL)"
@@ -1031,197 +2060,460 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
         "float depth = projCoords.z;"
         "float shadow = 0.0;"
 
-        // NOTE: You can increase iterations to improve PCF quality
-        "for (int x = -1; x <= 1; x++)"
+        // NOTE: The number of taps is set by RLG_SHADOW_PCF_TAPS
+#   ifdef RLG_SHADOW_PCF_POISSON
+        "for (int k = 0; k < " TOSTRING(RLG_SHADOW_PCF_TAPS) "; k++)"
         "{"
-            "for (int y = -1; y <= 1; y++)"
-            "{"
-                "float pcfDepth = TEX(lights[i].shadowMap, projCoords.xy + vec2(x, y)*lights[i].shadowMapTxlSz).r;"
-                "shadow += step(depth, pcfDepth);"
-            "}"
+            "vec2 offset = 1.5*POISSON_DISK[k];"
+            "shadow += " GLSL_SHADOW_TAP("offset") ";"
         "}"
-
-        "return shadow/9.0;"
-    "}"
-
-    "void main()"
-    "{"
-        // Compute the view direction vector for this fragment
-        "vec3 V = normalize(" RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION " - fragPosition);"
-
-        // Compute fragTexCoord (UV), apply parallax if height map is enabled
-        "vec2 uv = fragTexCoord;"
-        "if (maps[HEIGHT].active != 0)"
+#   else
+        "for (int x = 0; x < " TOSTRING(RLG_SHADOW_PCF_SIZE) "; x++)"
         "{"
-            "uv = (parallaxMinLayers > 0 && parallaxMaxLayers > 1)"
-                "? DeepParallax(uv, V) : Parallax(uv, V);"
-
-            "if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0)"
+            "for (int y = 0; y < " TOSTRING(RLG_SHADOW_PCF_SIZE) "; y++)"
             "{"
-                "discard;"
+                "vec2 offset = vec2(x, y) - 0.5*float(" TOSTRING(RLG_SHADOW_PCF_SIZE) " - 1);"
+                "shadow += " GLSL_SHADOW_TAP("offset") ";"
             "}"
         "}"
+#   endif
 
-        // Compute albedo (base color) by sampling the texture and multiplying by the diffuse color
-        "vec3 albedo = maps[ALBEDO].color.rgb*fragColor.rgb;"
-        "if (maps[ALBEDO].active != 0)"
-            "albedo *= TEX(maps[ALBEDO].texture, uv).rgb;"
-
-        // Compute metallic factor; if a metalness map is used, sample it
-        "float metalness = maps[METALNESS].value;"
-        "if (maps[METALNESS].active != 0)"
-            "metalness *= TEX(maps[METALNESS].texture, uv).b;"
-
-        // Compute roughness factor; if a roughness map is used, sample it
-        "float roughness = maps[ROUGHNESS].value;"
-        "if (maps[ROUGHNESS].active != 0)"
-            "roughness *= TEX(maps[ROUGHNESS].texture, uv).g;"
+        "return shadow/" TOSTRING(RLG_SHADOW_PCF_TAPS) ".0;"
+    "}"
 
-        // Compute F0 (reflectance at normal incidence) based on the metallic factor
-        "vec3 F0 = ComputeF0(metalness, 0.5, albedo);"
+#   if GLSL_VERSION > 100
+    "float ShadowParaboloid(int i, float cNdotL)"
+    "{"
+        "vec3 fragToLight = fragPosition - lights[i].position;"
+        "float dist = length(fragToLight);"
+        "vec3 dir = fragToLight/dist;"
 
-        // Compute the normal vector; if a normal map is used, transform it to tangent space
-        "vec3 N = (maps[NORMAL].active == 0) ? normalize(fragNormal)"
-            ": normalize(TBN*(TEX(maps[NORMAL].texture, uv).rgb*2.0 - 1.0));"
+        // Same projection as the depth pass, the hemisphere facing +Z is on the left half of the map
+        "float hemisphere = (dir.z >= 0.0) ? 1.0 : -1.0;"
+        "vec2 uv = vec2(-hemisphere*dir.x, dir.y)/(1.0 + hemisphere*dir.z)*0.5 + 0.5;"
+        "uv = clamp(uv, 0.5*lights[i].shadowMapTxlSz, 1.0 - 0.5*lights[i].shadowMapTxlSz);"
+        "vec3 projCoords = vec3(0.5*uv.x + ((hemisphere > 0.0) ? 0.0 : 0.5), uv.y, 0.0);"
 
-        // Compute the dot product of the normal and view direction
-        "float NdotV = dot(N, V);"
-        "float cNdotV = max(NdotV, 1e-4);"  // Clamped to avoid division by zero
+        "float bias = lights[i].depthBias*max(1.0 - cNdotL, 0.05);"
+        "float depth = (dist - bias)*lights[i].shadowDepthParams.x - lights[i].shadowDepthParams.y;"
+        "return " GLSL_SHADOW_TAP("vec2(0.0)") ";"
+    "}"
 
-        // Initialize diffuse and specular lighting accumulators
-        "vec3 diffLighting = vec3(0.0);"
-        "vec3 specLighting = vec3(0.0);"
+    "float ShadowMoments(int i)"
+    "{"
+        "vec4 p = fragPosLightSpace[i];"
+        "vec3 projCoords = p.xyz/p.w;"
+        "projCoords = projCoords*0.5 + 0.5;"
 
-        // Loop through all lights
-        "for (int i = 0; i < NUM_LIGHTS; i++)"
+        "if (projCoords.z > 1.0 || projCoords.x > 1.0 || projCoords.y > 1.0)"
         "{"
-            "if (lights[i].enabled != 0)"
-            "{"
-                "float size_A = 0.0;"
-                "vec3 L = vec3(0.0);"
-
-                // Compute the light direction vector
-                "if (lights[i].type != DIRLIGHT)"
-                "{"
-                    "vec3 LV = lights[i].position - fragPosition;"
-                    "L = normalize(LV);"
-
-                    // If the light has a size, compute the attenuation factor based on the distance
-                    "if (lights[i].size > 0.0)"
-                    "{"
-                        "float t = lights[i].size/max(0.001, length(LV));"
-                        "size_A = max(0.0, 1.0 - 1.0/sqrt(1.0 + t*t));"
-                    "}"
-                "}"
-                "else"
-                "{"
-                    // For directional lights, use the negative direction as the light direction
-                    "L = normalize(-lights[i].direction);"
-                "}"
-
-                // Compute the dot product of the normal and light direction, adjusted by size_A
-                "float NdotL = min(size_A + dot(N, L), 1.0);"
-                "float cNdotL = max(NdotL, 0.0);" // clamped NdotL
-
-                // Compute the halfway vector between the view and light directions
-                "vec3 H = normalize(V + L);"
-                "float cNdotH = clamp(size_A + dot(N, H), 0.0, 1.0);"
-                "float cLdotH = clamp(size_A + dot(L, H), 0.0, 1.0);"
-
-                // Compute light color energy
-                "vec3 lightColE = lights[i].color*lights[i].energy;"
-
-                // Compute diffuse lighting (Burley model) if the material is not fully metallic
-                "vec3 diffLight = vec3(0.0);"
-                "if (metalness < 1.0)"
-                "{"
-                    "float FD90_minus_1 = 2.0*cLdotH*cLdotH*roughness - 0.5;"
-                    "float FdV = 1.0 + FD90_minus_1*SchlickFresnel(cNdotV);"
-                    "float FdL = 1.0 + FD90_minus_1*SchlickFresnel(cNdotL);"
-
-                    "float diffBRDF = (1.0/PI)*FdV*FdL*cNdotL;"
-                    "diffLight = diffBRDF*lightColE;"
-                "}"
-
-                // Compute specular lighting using the Schlick-GGX model
-                // NOTE: When roughness is 0, specular light should not be entirely disabled.
-                // TODO: Handle perfect mirror reflection when roughness is 0.
-                "vec3 specLight = vec3(0.0);"
-                "if (roughness > 0.0)"
-                "{"
-                    "float alphaGGX = roughness*roughness;"
-                    "float D = DistributionGGX(cNdotH, alphaGGX);"
-                    "float G = GeometrySmith(cNdotL, cNdotV, alphaGGX);"
-
-                    "float cLdotH5 = SchlickFresnel(cLdotH);"
-                    "float F90 = clamp(50.0*F0.g, 0.0, 1.0);"
-                    "vec3 F = F0 + (F90 - F0)*cLdotH5;"
-
-                    "vec3 specBRDF = cNdotL*D*F*G;"
-                    "specLight = specBRDF*lightColE*lights[i].specular;"
-                "}"
-
-                // Apply spotlight effect if the light is a spotlight
-                "float intensity = 1.0;"
-                "if (lights[i].type == SPOTLIGHT)"
-                "{"
-                    "float theta = dot(L, normalize(-lights[i].direction));"
-                    "float epsilon = (lights[i].innerCutOff - lights[i].outerCutOff);"
-                    "intensity = smoothstep(0.0, 1.0, (theta - lights[i].outerCutOff)/epsilon);"
-                "}"
-
-                // Apply attenuation based on the distance from the light
-                "float distance    = length(lights[i].position - fragPosition);"
-                "float attenuation = 1.0/(lights[i].constant +"
-                                         "lights[i].linear*distance +"
-                                         "lights[i].quadratic*(distance*distance));"
-
-                // Apply shadow factor if the light casts shadows
-                "float shadow = 1.0;"
-                "if (lights[i].shadow != 0)"
-                "{"
-                    "shadow = (lights[i].type == OMNILIGHT)"
-                        "? ShadowOmni(i, cNdotL) : Shadow(i, cNdotL);"
-                "}"
-
-                // Compute the final intensity factor combining intensity, attenuation, and shadow
-                "float factor = intensity*attenuation*shadow;"
-
-                // Accumulate the diffuse and specular lighting contributions
-                "diffLighting += diffLight*factor;"
-                "specLighting += specLight*factor;"
-            "}"
+            "return 1.0;"
         "}"
 
-        // Compute ambient
-        "vec3 ambient = " RLG_SHADER_LIGHTING_UNIFORM_COLOR_AMBIENT ";"
-        "if (cubemaps[IRRADIANCE].active != 0)"
-        "{"
-            "vec3 kS = F0 + (1.0 - F0)*SchlickFresnel(cNdotV);"
-            "vec3 kD = (1.0 - kS)*(1.0 - metalness);"
-            "ambient = kD*TEXCUBE(cubemaps[IRRADIANCE].texture, N).rgb;"
-        "}"
+        "vec2 moments = texture(lights[i].shadowMoments, projCoords.xy).rg;"
+        "float depth = projCoords.z;"
+        "float minVariance = lights[i].depthBias*lights[i].depthBias;"
 
-        // Compute ambient occlusion
-        "if (maps[OCCLUSION].active != 0)"
+        // EVSM: compare the exponentially warped depths, the variance scales with the warping slope
+        "if (lights[i].shadowTechnique == 2)"
         "{"
-            "float ao = TEX(maps[OCCLUSION].texture, uv).r;"
-            "ambient *= ao;"
-
-            "float lightAffect = mix(1.0, ao, maps[OCCLUSION].value);"
-            "diffLighting *= lightAffect;"
-            "specLighting *= lightAffect;"
+            "depth = exp(" TOSTRING(RLG_SHADOW_EVSM_EXPONENT) "*depth);"
+            "minVariance *= " TOSTRING(RLG_SHADOW_EVSM_EXPONENT) "*depth*" TOSTRING(RLG_SHADOW_EVSM_EXPONENT) "*depth;"
         "}"
 
-        // Skybox reflection
-        "if (cubemaps[CUBEMAP].active != 0)"
+        "if (depth <= moments.x)"
         "{"
-            "vec3 reflectCol = TEXCUBE(cubemaps[CUBEMAP].texture, reflect(-V, N)).rgb;"
-            "specLighting = mix(specLighting, reflectCol, 1.0 - roughness);"
+            "return 1.0;"
         "}"
 
-        // Compute the final diffuse color, including ambient and diffuse lighting contributions
-        "vec3 diffuse = albedo*(ambient + diffLighting);"
+        // One-tailed Chebyshev upper bound, with the low probabilities cut to reduce light bleeding
+        "float variance = max(moments.y - moments.x*moments.x, minVariance);"
+        "float d = depth - moments.x;"
+        "float pMax = variance/(variance + d*d);"
+        "return clamp((pMax - 0.2)/0.8, 0.0, 1.0);"
+    "}"
+#   endif
+
+    "float ShadowFactor(int i, float cNdotL)"
+    "{"
+        "float shadow = 1.0;"
+#       if GLSL_VERSION > 100
+        "if (lights[i].type == OMNILIGHT && lights[i].omniShadowMode == 0) shadow = ShadowOmni(i, cNdotL);"
+        "else if (lights[i].type == OMNILIGHT) shadow = ShadowParaboloid(i, cNdotL);"
+        "else if (lights[i].shadowTechnique != 0) shadow = ShadowMoments(i);"
+        "else shadow = Shadow(i, cNdotL);"
+#       else
+        "shadow = (lights[i].type == OMNILIGHT)"
+            "? ShadowOmni(i, cNdotL) : Shadow(i, cNdotL);"
+#       endif
+        "return shadow;"
+    "}"
+
+#   if GLSL_VERSION > 100
+    "float ViewDepth(float depth)"
+    "{"
+        "float z = depth*2.0 - 1.0;"
+        "return (sceneDepthParams.x*z + sceneDepthParams.y)/(sceneDepthParams.z*z + sceneDepthParams.w);"
+    "}"
+
+    "vec4 SampleShadowMask()"
+    "{"
+        "ivec2 screenSize = textureSize(sceneDepth, 0);"
+        "ivec2 maskSize = textureSize(shadowMask, 0);"
+        "if (maskSize == screenSize) return texelFetch(shadowMask, ivec2(gl_FragCoord.xy), 0);"
+
+        // Depth-aware upsampling: the bilinear weights of the four nearest mask texels are
+        // scaled down when the depth they were evaluated at differs from the depth of the fragment
+        "vec2 scale = vec2(maskSize)/vec2(screenSize);"
+        "vec2 texel = gl_FragCoord.xy*scale - 0.5;"
+        "vec2 f = fract(texel);"
+        "ivec2 base = ivec2(floor(texel));"
+        "float depth = ViewDepth(gl_FragCoord.z);"
+
+        "vec4 mask = vec4(0.0);"
+        "float weightSum = 0.0;"
+        "for (int k = 0; k < 4; k++)"
+        "{"
+            "ivec2 offset = ivec2(k & 1, k >> 1);"
+            "ivec2 t = clamp(base + offset, ivec2(0), maskSize - 1);"
+            "float texelDepth = ViewDepth(texelFetch(sceneDepth, ivec2((vec2(t) + 0.5)/scale), 0).r);"
+            "vec2 b = mix(1.0 - f, f, vec2(offset));"
+            "float weight = b.x*b.y/(1e-3 + abs(texelDepth - depth)/abs(depth));"
+            "mask += texelFetch(shadowMask, t, 0)*weight;"
+            "weightSum += weight;"
+        "}"
+
+        "return mask/max(weightSum, 1e-6);"
+    "}"
+
+    // Octahedral mapping of the unit normals, the two components fit the 10-bit channels of the G-buffer
+    // SEE: https://jcgt.org/published/0003/02/01/
+    "vec2 EncodeOctahedron(vec3 n)"
+    "{"
+        "n /= abs(n.x) + abs(n.y) + abs(n.z);"
+        "vec2 signs = vec2((n.x >= 0.0) ? 1.0 : -1.0, (n.y >= 0.0) ? 1.0 : -1.0);"
+        "vec2 e = (n.z >= 0.0) ? n.xy : (1.0 - abs(n.yx))*signs;"
+        "return e*0.5 + 0.5;"
+    "}"
+
+    "vec3 DecodeOctahedron(vec2 e)"
+    "{"
+        "e = e*2.0 - 1.0;"
+        "vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));"
+        "vec2 signs = vec2((n.x >= 0.0) ? 1.0 : -1.0, (n.y >= 0.0) ? 1.0 : -1.0);"
+        "n.xy -= max(-n.z, 0.0)*signs;"
+        "return normalize(n);"
+    "}"
+#   endif
+
+    // Diffuse and specular lighting received from a light, before the albedo is applied
+    "void LightContribution(int i, vec3 N, vec3 V, float cNdotV, vec3 F0, float metalness, float roughness,"
+        "inout vec3 diffLighting, inout vec3 specLighting)"
+    "{"
+        "float size_A = 0.0;"
+        "vec3 L = vec3(0.0);"
+
+        // Compute the light direction vector
+        "if (lights[i].type != DIRLIGHT)"
+        "{"
+            "vec3 LV = lights[i].position - fragPosition;"
+            "L = normalize(LV);"
+
+            // If the light has a size, compute the attenuation factor based on the distance
+            "if (lights[i].size > 0.0)"
+            "{"
+                "float t = lights[i].size/max(0.001, length(LV));"
+                "size_A = max(0.0, 1.0 - 1.0/sqrt(1.0 + t*t));"
+            "}"
+        "}"
+        "else"
+        "{"
+            // For directional lights, use the negative direction as the light direction
+            "L = normalize(-lights[i].direction);"
+        "}"
+
+        // Compute the dot product of the normal and light direction, adjusted by size_A
+        "float NdotL = min(size_A + dot(N, L), 1.0);"
+        "float cNdotL = max(NdotL, 0.0);" // clamped NdotL
+
+        // Compute the halfway vector between the view and light directions
+        "vec3 H = normalize(V + L);"
+        "float cNdotH = clamp(size_A + dot(N, H), 0.0, 1.0);"
+        "float cLdotH = clamp(size_A + dot(L, H), 0.0, 1.0);"
+
+        // Compute light color energy
+        "vec3 lightColE = lights[i].color*lights[i].energy;"
+
+        // Compute diffuse lighting (Burley model) if the material is not fully metallic
+        "vec3 diffLight = vec3(0.0);"
+        "if (metalness < 1.0)"
+        "{"
+            "float FD90_minus_1 = 2.0*cLdotH*cLdotH*roughness - 0.5;"
+            "float FdV = 1.0 + FD90_minus_1*SchlickFresnel(cNdotV);"
+            "float FdL = 1.0 + FD90_minus_1*SchlickFresnel(cNdotL);"
+
+            "float diffBRDF = (1.0/PI)*FdV*FdL*cNdotL;"
+            "diffLight = diffBRDF*lightColE;"
+        "}"
+
+        // Compute specular lighting using the Schlick-GGX model
+        // NOTE: When roughness is 0, specular light should not be entirely disabled.
+        // TODO: Handle perfect mirror reflection when roughness is 0.
+        "vec3 specLight = vec3(0.0);"
+        "if (roughness > 0.0)"
+        "{"
+            "float alphaGGX = roughness*roughness;"
+            "float D = DistributionGGX(cNdotH, alphaGGX);"
+            "float G = GeometrySmith(cNdotL, cNdotV, alphaGGX);"
+
+            "float cLdotH5 = SchlickFresnel(cLdotH);"
+            "float F90 = clamp(50.0*F0.g, 0.0, 1.0);"
+            "vec3 F = F0 + (F90 - F0)*cLdotH5;"
+
+            "vec3 specBRDF = cNdotL*D*F*G;"
+            "specLight = specBRDF*lightColE*lights[i].specular;"
+        "}"
+
+        // Apply spotlight effect if the light is a spotlight
+        "float intensity = 1.0;"
+        "if (lights[i].type == SPOTLIGHT)"
+        "{"
+            "float theta = dot(L, normalize(-lights[i].direction));"
+            "float epsilon = (lights[i].innerCutOff - lights[i].outerCutOff);"
+            "intensity = smoothstep(0.0, 1.0, (theta - lights[i].outerCutOff)/epsilon);"
+        "}"
+
+        // Apply attenuation based on the distance from the light
+        "float distance    = length(lights[i].position - fragPosition);"
+        "float attenuation = 1.0/(lights[i].constant +"
+                                 "lights[i].linear*distance +"
+                                 "lights[i].quadratic*(distance*distance));"
+
+        // Apply shadow factor if the light casts shadows
+        "float shadow = 1.0;"
+        "if (lights[i].shadow != 0 && lights[i].shadowFade > 0.0)"
+        "{"
+#       if GLSL_VERSION > 100
+            "shadow = (lights[i].shadowMaskChannel >= 0)"
+                "? shadowMaskValue[lights[i].shadowMaskChannel] : ShadowFactor(i, cNdotL);"
+#       else
+            "shadow = ShadowFactor(i, cNdotL);"
+#       endif
+            "shadow = mix(1.0, shadow, lights[i].shadowFade);"
+        "}"
+
+        // Compute the final intensity factor combining intensity, attenuation, and shadow
+        "float factor = intensity*attenuation*shadow;"
+
+        // Accumulate the diffuse and specular lighting contributions
+        "diffLighting += diffLight*factor;"
+        "specLighting += specLight*factor;"
+    "}"
+
+#   if GLSL_VERSION > 100
+    "\n#ifdef SHADOW_MASK\n"
+    "void main()"
+    "{"
+        // Reconstruct the world position from the scene depth, and a normal from its derivatives
+        // NOTE: The position is rebuilt at the center of the fetched depth texel, which is also
+        // the one the lighting shader compares to when the mask has a lower resolution
+        "vec2 depthSize = vec2(textureSize(sceneDepth, 0));"
+        "ivec2 depthTexel = ivec2(fragTexCoord*depthSize);"
+        "vec2 uv = (vec2(depthTexel) + 0.5)/depthSize;"
+        "float depth = texelFetch(sceneDepth, depthTexel, 0).r;"
+        "vec4 position = sceneInvViewProj*vec4(vec3(uv, depth)*2.0 - 1.0, 1.0);"
+        "fragPosition = position.xyz/position.w;"
+
+        "vec3 N = normalize(cross(dFdx(fragPosition), dFdy(fragPosition)));"
+        "if (dot(N, " RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION " - fragPosition) < 0.0) N = -N;"
+
+        "vec4 mask = vec4(1.0);"
+        "if (depth < 1.0)"
+        "{"
+            "for (int i = 0; i < NUM_LIGHTS; i++)"
+            "{"
+                "if (lights[i].enabled == 0) continue;"
+
+                "vec3 L = (lights[i].type == DIRLIGHT) ? -lights[i].direction : lights[i].position - fragPosition;"
+                "float cNdotL = max(dot(N, normalize(L)), 0.0);"
+
+                "fragPosLightSpace[i] = matLights[i]*vec4(fragPosition, 1.0);"
+                "mask[i] = ShadowFactor(i, cNdotL);"
+            "}"
+        "}"
+
+        GLSL_FINAL_COLOR("mask")
+    "}"
+    "\n#elif defined(DEFERRED_LIGHT)\n"
+    "void main()"
+    "{"
+        // Reconstruct the world position from the depth of the G-buffer
+        "ivec2 texel = ivec2(gl_FragCoord.xy);"
+        "float depth = texelFetch(gbufferDepth, texel, 0).r;"
+        "if (depth == 1.0) discard;"
+
+        "vec2 uv = gl_FragCoord.xy/vec2(textureSize(gbufferDepth, 0));"
+        "vec4 position = sceneInvViewProj*vec4(vec3(uv, depth)*2.0 - 1.0, 1.0);"
+        "fragPosition = position.xyz/position.w;"
+        "fragPosLightSpace[0] = matLights[0]*vec4(fragPosition, 1.0);"
+
+        // Decode the surface written by the G-buffer pass
+        "vec4 albedoMetalness = texelFetch(gbufferAlbedo, texel, 0);"
+        "vec4 normalRoughness = texelFetch(gbufferNormal, texel, 0);"
+        "float lightAffect = texelFetch(gbufferLighting, texel, 0).a;"
+
+        "vec3 albedo = albedoMetalness.rgb;"
+        "float metalness = albedoMetalness.a;"
+        "float roughness = normalRoughness.z;"
+        "vec3 N = DecodeOctahedron(normalRoughness.xy);"
+
+        "vec3 V = normalize(" RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION " - fragPosition);"
+        "vec3 F0 = ComputeF0(metalness, 0.5, albedo);"
+        "float cNdotV = max(dot(N, V), 1e-4);"
+
+        "vec3 diffLighting = vec3(0.0);"
+        "vec3 specLighting = vec3(0.0);"
+        "LightContribution(0, N, V, cNdotV, F0, metalness, roughness, diffLighting, specLighting);"
+
+        // Same weight of the specular lighting as when it is mixed with the skybox reflection
+        "if (normalRoughness.w > 0.5) specLighting *= roughness;"
+
+        // Added to the lighting of the G-buffer pass by the blending
+        GLSL_FINAL_COLOR("vec4((albedo*diffLighting + specLighting)*lightAffect, 0.0)")
+    "}"
+    "\n#else\n"
+#   endif
+
+    "void main()"
+    "{"
+        // Compute the view direction vector for this fragment
+        "vec3 V = normalize(" RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION " - fragPosition);"
+
+        // Compute fragTexCoord (UV), apply parallax if height map is enabled
+        "vec2 uv = fragTexCoord;"
+        "if (maps[HEIGHT].active != 0)"
+        "{"
+            "uv = (parallaxMinLayers > 0 && parallaxMaxLayers > 1)"
+                "? DeepParallax(uv, V) : Parallax(uv, V);"
+
+            "if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0)"
+            "{"
+                "discard;"
+            "}"
+        "}"
+
+        // Compute albedo (base color) by sampling the texture and multiplying by the diffuse color
+        "vec3 albedo = maps[ALBEDO].color.rgb*fragColor.rgb;"
+        "if (maps[ALBEDO].active != 0)"
+            "albedo *= TEX(maps[ALBEDO].texture, uv).rgb;"
+
+        // Compute metallic factor; if a metalness map is used, sample it
+        "float metalness = maps[METALNESS].value;"
+        "if (maps[METALNESS].active != 0)"
+            "metalness *= TEX(maps[METALNESS].texture, uv).b;"
+
+        // Compute roughness factor; if a roughness map is used, sample it
+        "float roughness = maps[ROUGHNESS].value;"
+        "if (maps[ROUGHNESS].active != 0)"
+            "roughness *= TEX(maps[ROUGHNESS].texture, uv).g;"
+
+        // Compute F0 (reflectance at normal incidence) based on the metallic factor
+        "vec3 F0 = ComputeF0(metalness, 0.5, albedo);"
+
+        // Compute the normal vector; if a normal map is used, transform it to tangent space
+        "vec3 N = (maps[NORMAL].active == 0) ? normalize(fragNormal)"
+            ": normalize(TBN*(TEX(maps[NORMAL].texture, uv).rgb*2.0 - 1.0));"
+
+        // Compute the dot product of the normal and view direction
+        "float NdotV = dot(N, V);"
+        "float cNdotV = max(NdotV, 1e-4);"  // Clamped to avoid division by zero
+
+        // Initialize diffuse and specular lighting accumulators
+        "vec3 diffLighting = vec3(0.0);"
+        "vec3 specLighting = vec3(0.0);"
+
+#       if GLSL_VERSION > 100
+        // The lights are accumulated by the deferred light pass
+        "\n#ifndef GBUFFER\n"
+
+        // Shadows already evaluated by the shadow mask pass
+        "if (useShadowMask != 0) shadowMaskValue = SampleShadowMask();"
+#       endif
+
+        "\n#ifdef MULTI_PASS\n"
+        // The pass of a light only outputs what the light adds to the base pass
+        "if (lightPass != 0)"
+        "{"
+            "LightContribution(0, N, V, cNdotV, F0, metalness, roughness, diffLighting, specLighting);"
+
+            "float lightAffect = 1.0;"
+            "if (maps[OCCLUSION].active != 0)"
+                "lightAffect = mix(1.0, TEX(maps[OCCLUSION].texture, uv).r, maps[OCCLUSION].value);"
+
+            // Same weight of the specular lighting as when it is mixed with the skybox reflection
+            "if (SKYBOX_MIX) specLighting *= roughness;"
+
+            GLSL_FINAL_COLOR("vec4((albedo*diffLighting + specLighting)*lightAffect, 0.0)")
+            "return;"
+        "}"
+        "\n#else\n"
+
+        // Loop through all lights
+        "for (int i = 0; i < NUM_LIGHTS; i++)"
+        "{"
+            "if (lights[i].enabled != 0)"
+            "{"
+                "LightContribution(i, N, V, cNdotV, F0, metalness, roughness, diffLighting, specLighting);"
+            "}"
+        "}"
+        "\n#endif\n"
+
+#       if GLSL_VERSION > 100
+        "\n#endif\n"
+#       endif
+
+        // Compute ambient
+        "vec3 ambient = " RLG_SHADER_LIGHTING_UNIFORM_COLOR_AMBIENT ";"
+        "if (useIrradianceSH != 0 || cubemaps[IRRADIANCE].active != 0)"
+        "{"
+            "vec3 kS = F0 + (1.0 - F0)*SchlickFresnel(cNdotV);"
+            "vec3 kD = (1.0 - kS)*(1.0 - metalness);"
+            "vec3 irradiance = (useIrradianceSH != 0) ? IrradianceSH(N) : TEXCUBE(cubemaps[IRRADIANCE].texture, N).rgb;"
+            "ambient = kD*irradiance;"
+        "}"
+
+        // Compute ambient occlusion
+        "float ao = 1.0;"
+        "float lightAffect = 1.0;"
+        "if (maps[OCCLUSION].active != 0)"
+        "{"
+            "ao = TEX(maps[OCCLUSION].texture, uv).r;"
+            "ambient *= ao;"
+
+            "lightAffect = mix(1.0, ao, maps[OCCLUSION].value);"
+            "diffLighting *= lightAffect;"
+            "specLighting *= lightAffect;"
+        "}"
+
+        // Skybox reflection, with the split-sum approximation when the prefiltered radiance is given,
+        // occluded like the ambient diffuse as both come from the environment
+        // SEE: https://cdn2.unrealengine.com/Resources/files/2013SiggraphPresentationsNotes-26915738.pdf
+        "if (SPLIT_SUM)"
+        "{"
+            "vec3 R = reflect(-V, N);"
+            "if (useProbe != 0) R = BoxProjection(R);"
+            "vec3 prefiltered = TEXCUBE_LOD(cubemaps[PREFILTER].texture, R, roughness*PREFILTER_MAX_LOD).rgb;"
+            "vec2 envBRDF = TEX(maps[BRDF].texture, vec2(cNdotV, roughness)).rg;"
+            "specLighting += ao*prefiltered*(F0*envBRDF.x + envBRDF.y);"
+        "}"
+        "else if (cubemaps[CUBEMAP].active != 0)"
+        "{"
+            "vec3 reflectCol = TEXCUBE(cubemaps[CUBEMAP].texture, reflect(-V, N)).rgb;"
+            "specLighting = mix(specLighting, reflectCol, 1.0 - roughness);"
+        "}"
+
+        // Compute the final diffuse color, including ambient and diffuse lighting contributions
+        "vec3 diffuse = albedo*(ambient + diffLighting);"
 
         // Compute emission color; if an emissive map is used, sample it
         "vec3 emission = maps[EMISSION].color.rgb;"
@@ -1230,13 +2522,32 @@ static const char rlgLightingFS[] = GLSL_VERSION_DEF
             "emission *= TEX(maps[EMISSION].texture, uv).rgb;"
         "}"
 
+#       if GLSL_VERSION > 100
+        // Without the lights, the lighting of the G-buffer is the ambient, the skybox reflection and the emission
+        "\n#ifdef GBUFFER\n"
+        "gbufferAlbedo = vec4(albedo, metalness);"
+        "gbufferNormal = vec4(EncodeOctahedron(N), roughness, (SKYBOX_MIX) ? 1.0 : 0.0);"
+        "gbufferLighting = vec4(diffuse + specLighting + emission, lightAffect);"
+        "\n#else\n"
+#       endif
+
         // Compute the final fragment color by combining diffuse, specular, and emission contributions
         GLSL_FINAL_COLOR("vec4(diffuse + specLighting + emission, 1.0)")
-    "}";
+
+#       if GLSL_VERSION > 100
+        "\n#endif\n"
+#       endif
+    "}"
+
+#   if GLSL_VERSION > 100
+    "\n#endif\n"
+#   endif
+    ;
 
 static const char rlgDepthVS[] = GLSL_VERSION_DEF
     GLSL_VS_IN("vec3 vertexPosition")
     "uniform mat4 mvp;"
+    "invariant gl_Position;"    ///< Same depth as the lighting shader for the depth pre-pass
     "void main()"
     "{"
         "gl_Position = mvp*vec4(vertexPosition, 1.0);"
@@ -1247,29 +2558,140 @@ static const char rlgDepthFS[] = GLSL_VERSION_DEF
     "void main()"
     "{}";
 
-static const char rlgDepthCubemapVS[] = GLSL_VERSION_DEF
+#if GLSL_VERSION >= 330
+
+static const char rlgDepthLayeredVS[] = GLSL_VERSION_DEF
+    GLSL_VS_IN("vec3 vertexPosition")
+    "uniform mat4 matModel;"
+    "void main()"
+    "{"
+        "gl_Position = matModel*vec4(vertexPosition, 1.0);"
+    "}";
+
+static const char rlgDepthLayeredGS[] = GLSL_VERSION_DEF
+    "layout(triangles) in;"
+    "layout(triangle_strip, max_vertices = 18) out;"
+    "uniform mat4 matFaces[6];"
+    "uniform int faceMask;"
+    "void main()"
+    "{"
+        "for (int face = 0; face < 6; face++)"
+        "{"
+            "if ((faceMask & (1 << face)) == 0) continue;"
+            "for (int i = 0; i < 3; i++)"
+            "{"
+                "gl_Layer = face;"
+                "gl_Position = matFaces[face]*gl_in[i].gl_Position;"
+                "EmitVertex();"
+            "}"
+            "EndPrimitive();"
+        "}"
+    "}";
+
+static const char rlgDepthLayeredInstancedVS[] = GLSL_VERSION_DEF
+    "#extension GL_ARB_shader_viewport_layer_array : require\n"
+    GLSL_VS_IN("vec3 vertexPosition")
+    "uniform mat4 matModel;"
+    "uniform mat4 matFaces[6];"
+    "uniform int faceIndices[6];"
+    "void main()"
+    "{"
+        "int face = faceIndices[gl_InstanceID];"
+        "vec4 position = matModel*vec4(vertexPosition, 1.0);"
+        "gl_Layer = face;"
+        "gl_Position = matFaces[face]*position;"
+    "}";
+
+static const char rlgDepthParaboloidVS[] = GLSL_VERSION_DEF
     GLSL_VS_IN("vec3 vertexPosition")
-    GLSL_VS_OUT("vec3 fragPosition")
     "uniform mat4 matModel;"
+    "uniform vec3 lightPos;"
+    "uniform float hemisphere;"     ///< 1.0 for the hemisphere facing +Z, -1.0 for the one facing -Z
+    "uniform vec2 depthParams;"     ///< Scale and offset converting the distance to the light to depth
+    "void main()"
+    "{"
+        "vec3 toVertex = vec3(matModel*vec4(vertexPosition, 1.0)) - lightPos;"
+        "float dist = length(toVertex);"
+        "vec3 dir = toVertex/dist;"
+        "float z = hemisphere*dir.z;"
+
+        // Vertices behind the hemisphere are clipped, the others are projected on the paraboloid
+        "gl_ClipDistance[0] = z;"
+        "vec2 position = vec2(-hemisphere*dir.x, dir.y)/max(1.0 + z, 0.5);"
+        "gl_Position = vec4(position, 2.0*(dist*depthParams.x - depthParams.y) - 1.0, 1.0);"
+    "}";
+
+static const char rlgDepthMomentsFS[] = GLSL_VERSION_DEF
+    GLSL_FS_OUT_DEF
+    "uniform float exponent;"   ///< Depth warping exponent, zero for VSM
+    "void main()"
+    "{"
+        "float depth = gl_FragCoord.z;"
+        "if (exponent > 0.0) depth = exp(exponent*depth);"
+        GLSL_FINAL_COLOR("vec4(depth, depth*depth, 0.0, 1.0)")
+    "}";
+
+static const char rlgFullscreenVS[] = GLSL_VERSION_DEF
+    GLSL_VS_OUT("vec2 fragTexCoord")
+    "void main()"
+    "{"
+        // Single triangle covering the whole viewport, without any vertex buffer
+        "vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);"
+        "fragTexCoord = position;"
+        "gl_Position = vec4(position*2.0 - 1.0, 0.0, 1.0);"
+    "}";
+
+static const char rlgDeferredLightVS[] = GLSL_VERSION_DEF
+    GLSL_VS_IN("vec3 vertexPosition")
     "uniform mat4 mvp;"
+    "uniform int fullscreen;"   ///< Draws the fullscreen triangle instead of the light volume (directional lights)
     "void main()"
     "{"
-        "fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));"
-        "gl_Position = mvp*vec4(vertexPosition, 1.0);"
+        "if (fullscreen != 0)"
+        "{"
+            "vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);"
+            "gl_Position = vec4(position*2.0 - 1.0, 0.0, 1.0);"
+        "}"
+        "else"
+        "{"
+            "gl_Position = mvp*vec4(vertexPosition, 1.0);"
+        "}"
+    "}";
+
+static const char rlgDeferredCompositeFS[] = GLSL_VERSION_DEF
+    GLSL_FS_OUT_DEF
+    "uniform sampler2D gbufferLighting;"
+    "uniform sampler2D gbufferDepth;"
+    "void main()"
+    "{"
+        // The depth of the G-buffer is copied for the light volumes and the forward pass that follows
+        "ivec2 texel = ivec2(gl_FragCoord.xy);"
+        "float depth = texelFetch(gbufferDepth, texel, 0).r;"
+        "if (depth == 1.0) discard;"
+        "gl_FragDepth = depth;"
+        GLSL_FINAL_COLOR("vec4(texelFetch(gbufferLighting, texel, 0).rgb, 1.0)")
     "}";
 
-static const char rlgDepthCubemapFS[] = GLSL_VERSION_DEF
+static const char rlgMomentsBlurFS[] = GLSL_VERSION_DEF
     GLSL_PRECISION("mediump float")
-    GLSL_FS_IN("vec3 fragPosition")
-    "uniform vec3 lightPos;"
-    "uniform float farPlane;"
+    GLSL_FS_IN("vec2 fragTexCoord")
+    GLSL_FS_OUT_DEF
+    "uniform sampler2D texture0;"
+    "uniform vec2 direction;"   ///< Offset between two taps, in texture coordinates
+    "const float WEIGHTS[5] = float[](0.2270270, 0.1945946, 0.1216216, 0.0540540, 0.0162162);"
     "void main()"
     "{"
-        "float lightDistance = length(fragPosition - lightPos);"
-        "lightDistance = lightDistance/farPlane;"
-        "gl_FragDepth = lightDistance;"
+        "vec2 moments = textureLod(texture0, fragTexCoord, 0.0).rg*WEIGHTS[0];"
+        "for (int i = 1; i < 5; i++)"
+        "{"
+            "moments += textureLod(texture0, fragTexCoord + float(i)*direction, 0.0).rg*WEIGHTS[i];"
+            "moments += textureLod(texture0, fragTexCoord - float(i)*direction, 0.0).rg*WEIGHTS[i];"
+        "}"
+        GLSL_FINAL_COLOR("vec4(moments, 0.0, 1.0)")
     "}";
 
+#endif //GLSL_VERSION
+
 static const char rlgShadowMapFS[] = GLSL_VERSION_DEF
     GLSL_PRECISION("mediump float")
     GLSL_FS_IN("vec2 fragTexCoord")
@@ -1370,6 +2792,152 @@ static const char rlgIrradianceConvolutionFS[] = GLSL_VERSION_DEF
         GLSL_FINAL_COLOR("vec4(irradiance, 1.0)")
     "}";
 
+static const char rlgIrradianceSamplingFS[] = GLSL_VERSION_DEF
+    GLSL_TEXTURE_CUBE_LOD_DEF
+
+    "#define PI 3.14159265359\n"
+    "#define MAX_SAMPLES " TOSTRING(RLG_IRRADIANCE_MAX_SAMPLES) "\n"
+
+    GLSL_PRECISION("mediump float")
+    GLSL_FS_IN("vec3 fragPosition")
+    GLSL_FS_OUT_DEF
+
+    "uniform samplerCube environmentMap;"
+    "uniform int sampleCount;"
+    "uniform float environmentSize;"    ///< Size of the faces of the environment cubemap
+    "uniform float implicitLod;"        ///< Mipmap level already selected by the derivatives, removed from the bias (GLSL 100 only)
+
+    // Van der Corput radical inverse in base 2, with float operations to also work with GLSL 100
+    "float RadicalInverse(float i)"
+    "{"
+        "float r = 0.0;"
+        "float f = 0.5;"
+        "for (int b = 0; b < 16; b++)"
+        "{"
+            "if (i < 1.0) break;"
+            "float h = floor(i*0.5);"
+            "r += f*(i - 2.0*h);"
+            "i = h;"
+            "f *= 0.5;"
+        "}"
+        "return r;"
+    "}"
+
+    "void main()"
+    "{"
+        "vec3 N = normalize(fragPosition);"
+
+        "vec3 up = (abs(N.y) < 0.999) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);"
+        "vec3 right = normalize(cross(up, N));"
+        "up = cross(N, right);"
+
+        "float n = float(sampleCount);"
+        "float texelSolidAngle = 4.0*PI/(6.0*environmentSize*environmentSize);"
+
+        "vec3 irradiance = vec3(0.0);"
+
+        "for (int i = 0; i < MAX_SAMPLES; i++)"
+        "{"
+            "if (i >= sampleCount) break;"
+
+            // Cosine-weighted Hammersley point, its pdf is cos(theta)/PI
+            "float phi = 2.0*PI*float(i)/n;"
+            "float u = RadicalInverse(float(i));"
+            "float cosTheta = sqrt(1.0 - u);"
+            "float sinTheta = sqrt(u);"
+
+            "vec3 L = (cos(phi)*right + sin(phi)*up)*sinTheta + N*cosTheta;"
+
+            // Read the mipmap whose texels cover the solid angle of the sample, instead of
+            // aliasing over the full resolution environment
+            "float pdf = max(cosTheta, 1e-4)/PI;"
+            "float lod = 0.5*log2(1.0/(n*pdf*texelSolidAngle));"
+
+            "irradiance += TEXCUBE_LOD(environmentMap, L, max(lod, 0.0) - implicitLod).rgb;"
+        "}"
+
+        // With cosine-weighted samples, the mean radiance is the irradiance divided by PI
+        GLSL_FINAL_COLOR("vec4(irradiance/n, 1.0)")
+    "}";
+
+static const char rlgPrefilterFS[] = GLSL_VERSION_DEF
+    GLSL_TEXTURE_CUBE_LOD_DEF
+
+    "#define PI 3.14159265359\n"
+    "#define MAX_SAMPLES " TOSTRING(RLG_IRRADIANCE_MAX_SAMPLES) "\n"
+
+    GLSL_PRECISION("mediump float")
+    GLSL_FS_IN("vec3 fragPosition")
+    GLSL_FS_OUT_DEF
+
+    "uniform samplerCube environmentMap;"
+    "uniform int sampleCount;"
+    "uniform float environmentSize;"    ///< Size of the faces of the environment cubemap
+    "uniform float implicitLod;"        ///< Mipmap level already selected by the derivatives, removed from the bias (GLSL 100 only)
+    "uniform float roughness;"          ///< Roughness of the mip level being rendered
+
+    "float RadicalInverse(float i)"
+    "{"
+        "float r = 0.0;"
+        "float f = 0.5;"
+        "for (int b = 0; b < 16; b++)"
+        "{"
+            "if (i < 1.0) break;"
+            "float h = floor(i*0.5);"
+            "r += f*(i - 2.0*h);"
+            "i = h;"
+            "f *= 0.5;"
+        "}"
+        "return r;"
+    "}"
+
+    "void main()"
+    "{"
+        // The view and reflection directions are assumed equal to the normal
+        "vec3 N = normalize(fragPosition);"
+
+        "vec3 up = (abs(N.y) < 0.999) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);"
+        "vec3 right = normalize(cross(up, N));"
+        "up = cross(N, right);"
+
+        "float alpha = roughness*roughness;"
+        "float a2 = alpha*alpha;"
+
+        "float n = float(sampleCount);"
+        "float texelSolidAngle = 4.0*PI/(6.0*environmentSize*environmentSize);"
+
+        "vec3 color = vec3(0.0);"
+        "float weight = 0.0;"
+
+        "for (int i = 0; i < MAX_SAMPLES; i++)"
+        "{"
+            "if (i >= sampleCount) break;"
+
+            // GGX importance sampling of the half vector
+            "float phi = 2.0*PI*float(i)/n;"
+            "float u = RadicalInverse(float(i));"
+            "float cosTheta = sqrt((1.0 - u)/(1.0 + (a2 - 1.0)*u));"
+            "float sinTheta = sqrt(1.0 - cosTheta*cosTheta);"
+
+            "vec3 H = (cos(phi)*right + sin(phi)*up)*sinTheta + N*cosTheta;"
+            "vec3 L = 2.0*dot(N, H)*H - N;"
+
+            "float NdotL = dot(N, L);"
+            "if (NdotL > 0.0)"
+            "{"
+                // With V = N, the pdf of L is D(H)/4, the sample reads the mip level matching its solid angle
+                "float d = cosTheta*cosTheta*(a2 - 1.0) + 1.0;"
+                "float pdf = a2/(PI*d*d)*0.25 + 1e-4;"
+                "float lod = (roughness > 0.0) ? 0.5*log2(1.0/(n*pdf*texelSolidAngle)) : 0.0;"
+
+                "color += TEXCUBE_LOD(environmentMap, L, max(lod, 0.0) - implicitLod).rgb*NdotL;"
+                "weight += NdotL;"
+            "}"
+        "}"
+
+        GLSL_FINAL_COLOR("vec4(color/max(weight, 1e-4), 1.0)")
+    "}";
+
 static const char rlgSkyboxVS[] = GLSL_VERSION_DEF
     GLSL_VS_IN("vec3 vertexPosition")
     GLSL_VS_OUT("vec3 fragPosition")
@@ -1382,7 +2950,7 @@ static const char rlgSkyboxVS[] = GLSL_VERSION_DEF
         "fragPosition = vertexPosition;"
         "mat4 rotView = mat4(mat3(matView));"
         "vec4 clipPos = matProjection*rotView*vec4(vertexPosition, 1.0);"
-        "gl_Position = clipPos;"
+        "gl_Position = clipPos.xyww;" // On the far plane, behind everything already drawn
     "}";
 
 static const char rlgSkyboxFS[] = GLSL_VERSION_DEF
@@ -1417,6 +2985,72 @@ struct RLG_ShadowMap
     Texture2D depth;
     unsigned int id;
     int width, height;
+    unsigned int emptyFaces;    ///< Bit mask of the faces cleared without any caster during their last update
+    unsigned int dirtyFaces;    ///< Bit mask of the faces rendered before the last motion of the light
+    unsigned int faceAges[6];   ///< Number of RLG_UpdateShadows calls since each face was rendered
+    Vector3 lastPosition;       ///< Position of the light when its motion was last checked
+    Vector3 lastDirection;      ///< Direction of the light when its motion was last checked
+    bool updated;               ///< Indicates whether the shadow map has been rendered at least once
+    float zFar;                 ///< Far plane of the omnilight faces, fitted to the range of the light
+    Texture2D moments;          ///< Blurred depth moments (VSM/EVSM only)
+    unsigned int momentsId;     ///< Framebuffer of the moments texture, used as target of the blur
+    Matrix viewProj;            ///< Last view-projection matrix sent to the lighting shader (directional and spot lights)
+    Vector2 depthParams;        ///< Last depth terms sent to the lighting shader (omnilights)
+};
+
+enum RLG_ShadowStorage
+{
+    RLG_SHADOW_STORAGE_DEPTH = 0,           ///< 2D depth texture and its framebuffer
+    RLG_SHADOW_STORAGE_DEPTH_CUBE,          ///< Depth cubemap and its framebuffer
+    RLG_SHADOW_STORAGE_DEPTH_PARABOLOID,    ///< 2D depth texture holding two hemispheres side by side, and its framebuffer
+    RLG_SHADOW_STORAGE_MOMENTS              ///< Mipmapped 2D moments texture and its color-only framebuffer
+};
+
+struct RLG_PooledShadowMap
+{
+    Texture2D texture;
+    unsigned int id;
+    int storage;                ///< One of the values of RLG_ShadowStorage
+};
+
+struct RLG_Frustum
+{
+    Vector4 planes[6];          ///< Plane equations (xyz: normal pointing inside, w: distance)
+};
+
+struct RLG_ShadowCaster
+{
+    Model model;                ///< NOTE: Not owned, the user must keep the model alive
+    Matrix transform;           ///< Model transform combined with the transform given by the user
+    BoundingBox localBounds;    ///< Bounds of all the meshes of the model, in model space
+    BoundingBox bounds;         ///< Bounds of the caster in world space (used for culling)
+    unsigned int flags;
+    unsigned int faceMask;      ///< Scratch value, faces of the light being updated the caster intersects
+    bool used;
+};
+
+struct RLG_ReflectionProbe
+{
+    RLG_Skybox capture;         ///< Scene around the probe (cubemap) and the prefiltered radiance being rendered (prefilter)
+    TextureCubemap prefilter;   ///< Prefiltered radiance sampled by the meshes, swapped with capture.prefilter by the last step
+    unsigned int framebufferId; ///< Capture target with a depth renderbuffer, a face of the cubemap is attached for each step
+    Vector3 position;
+    BoundingBox box;
+    int step;                   ///< Next face to capture (0 to 5), then to prefilter (6 to 11)
+    bool isStatic;              ///< Captured once, until RLG_RefreshReflectionProbe
+    bool upToDate;              ///< Every step has been run since the creation or the last refresh
+    bool complete;              ///< The prefiltered radiance has been rendered once, the probe can be sampled
+    bool used;
+};
+
+struct RLG_PositionStream
+{
+    unsigned int meshVboId;     ///< Position buffer of the mesh the stream was built from, identifies the mesh
+    unsigned int vaoId;
+    unsigned int vboId;         ///< NOTE: Only owned when quantized, the position buffer of the mesh is used otherwise
+    int vertexCount;
+    Matrix dequantize;          ///< Transform reconstructing the positions of the mesh from the stream
+    bool quantized;
 };
 
 struct RLG_Material ///< NOTE: This struct is used to handle data that cannot be stored in the MaterialMap struct of raylib.
@@ -1438,31 +3072,38 @@ struct RLG_Material ///< NOTE: This struct is used to handle data that cannot be
     data;
 };
 
+struct RLG_LightLocs
+{
+    int vpMatrix;       ///< NOTE: Not present in the Light shader struct but in a separate uniform
+    int shadowCubemap;
+    int shadowMap;
+    int shadowMoments;
+    int position;
+    int direction;
+    int color;
+    int energy;
+    int specular;
+    int size;
+    int innerCutOff;
+    int outerCutOff;
+    int constant;
+    int linear;
+    int quadratic;
+    int shadowMapTxlSz;
+    int depthBias;
+    int shadowDepthParams;
+    int shadowFade;
+    int type;
+    int shadow;
+    int shadowTechnique;
+    int omniShadowMode;
+    int shadowMaskChannel;
+    int enabled;
+};
+
 struct RLG_Light
 {
-    struct
-    {
-        int vpMatrix;       ///< NOTE: Not present in the Light shader struct but in a separate uniform
-        int shadowCubemap;
-        int shadowMap;
-        int position;
-        int direction;
-        int color;
-        int energy;
-        int specular;
-        int size;
-        int innerCutOff;
-        int outerCutOff;
-        int constant;
-        int linear;
-        int quadratic;
-        int shadowMapTxlSz;
-        int depthBias;
-        int type;
-        int shadow;
-        int enabled;
-    }
-    locs;
+    struct RLG_LightLocs locs;
 
     struct
     {
@@ -1480,9 +3121,20 @@ struct RLG_Light
         float quadratic;
         float shadowMapTxlSz;
         float depthBias;
+        float shadowFade;
         int type;
         int shadow;
+        int shadowTechnique;
+        int omniShadowMode;
+        int shadowMaskChannel;
         int enabled;
+
+        int shadowMinResolution;    ///< NOTE: Not sent to the shader, used for automatic resolution selection
+        int shadowMaxResolution;
+
+        float shadowFadeStart;      ///< NOTE: Not sent to the shader, used to compute the fade
+        float shadowFadeEnd;
+        int shadowFadedOut;         ///< NOTE: The shadow uniform is off while the light is beyond its fade distance
     }
     data;
 };
@@ -1492,6 +3144,142 @@ struct RLG_SkyboxHandling
     unsigned int previousCubemapID;  /*< Indicates whether to update the data sent to the skybox
                                          shader if different from the ID of the skybox to render */
     int locDoGamma;
+
+    int locSampleCount;              ///< Uniforms of the importance sampled irradiance shader
+    int locEnvironmentSize;
+    int locImplicitLod;
+
+    int locPrefilterSampleCount;     ///< Uniforms of the prefilter shader
+    int locPrefilterEnvironmentSize;
+    int locPrefilterImplicitLod;
+    int locPrefilterRoughness;
+
+    Texture2D brdfLUT;               ///< Split-sum BRDF lookup table, computed by the first call to RLG_GetBRDFLUT
+
+    unsigned int vaoId;              ///< Unit cube shared by every skybox, loaded with the first one
+    unsigned int vboPositionsId;
+    unsigned int vboIndicesId;
+};
+
+struct RLG_LayeredShader
+{
+    Shader shader;
+    int locFaces;       ///< View-projection matrices of the six cubemap faces
+    int locRouting;     ///< Face mask (geometry shader) or face indices (instanced)
+};
+
+struct RLG_LayeredShadows
+{
+    struct RLG_LayeredShader geometry;      ///< Routes each triangle to the faces of a mask
+    struct RLG_LayeredShader instanced;     ///< One instance per face, requires GL_ARB_shader_viewport_layer_array
+    bool loaded;                            ///< Indicates whether the shaders loading has been attempted
+    bool active;
+};
+
+struct RLG_ParaboloidShadows
+{
+    Shader shader;
+    int locLightPos;
+    int locHemisphere;
+    int locDepthParams;
+    bool loaded;            ///< Indicates whether the shader loading has been attempted
+};
+
+struct RLG_ShadowMaskLight
+{
+    int vpMatrix;
+    int shadowCubemap;
+    int shadowMap;
+    int shadowMoments;
+    int position;
+    int direction;
+    int shadowMapTxlSz;
+    int depthBias;
+    int shadowDepthParams;
+    int type;
+    int shadowTechnique;
+    int omniShadowMode;
+    int enabled;
+};
+
+struct RLG_ShadowMask
+{
+    Shader shader;                          ///< Lighting shader built with SHADOW_MASK, one light per channel
+    struct RLG_ShadowMaskLight locs[4];     ///< Uniforms of the light evaluated in each channel
+    int locInvViewProj;
+    int locViewPos;
+    int locSceneDepth;
+
+    int locLightingMask;                    ///< Uniforms of the lighting shader reading the mask
+    int locLightingDepth;
+    int locLightingDepthParams;
+    int locLightingUse;
+
+    unsigned int vaoId;                     ///< Empty vertex array for the fullscreen triangle
+    Texture2D depth;                        ///< Depth of the scene, at the resolution of the render target
+    unsigned int depthId;
+    Texture2D mask;                         ///< Shadow of the light of each channel (RGBA8)
+    unsigned int maskId;
+
+    int lights[4];                          ///< Light evaluated in each channel, -1 if none
+    float scale;                            ///< Resolution of the mask relative to the render target
+    bool loaded;                            ///< Indicates whether the shader loading has been attempted
+    bool active;
+};
+
+struct RLG_Deferred
+{
+    Shader gbuffer;                         ///< Lighting shader built with GBUFFER, same locations as the lighting shader
+    int locUseMaps[RLG_COUNT_MATERIAL_MAPS];
+    int locParallaxMinLayers;
+    int locParallaxMaxLayers;
+
+    Shader light;                           ///< Lighting shader built with DEFERRED_LIGHT, evaluates one light
+    struct RLG_LightLocs lightLocs;
+    int locInvViewProj;
+    int locViewPos;
+    int locMvp;
+    int locFullscreen;
+
+    Shader composite;                       ///< Copies the lighting and the depth of the G-buffer to the render target
+
+    unsigned int vaoId;                     ///< Light volumes, the fullscreen triangle is generated from gl_VertexID
+    unsigned int vboId;
+    int sphereVertexCount;                  ///< The cone follows the sphere in the vertex buffer
+    int coneVertexCount;
+
+    unsigned int framebufferId;
+    Texture2D albedo;                       ///< Albedo and metalness (RGBA8)
+    Texture2D normal;                       ///< Octahedral normal, roughness and skybox reflection flag (RGB10_A2)
+    Texture2D lighting;                     ///< Ambient, skybox reflection and emission, AO light affect (RGBA16F)
+    Texture2D depth;
+    unsigned int previousFramebuffer;       ///< Render target bound by RLG_BeginDeferred, lit by RLG_EndDeferred
+
+    bool loaded;                            ///< Indicates whether the shaders loading has been attempted
+    bool drawing;                           ///< Indicates that the RLG_Draw* functions write to the G-buffer
+    bool active;
+};
+
+struct RLG_MultiPass
+{
+    Shader shader;                          ///< Lighting shader built with MULTI_PASS for one light, same locations as the lighting shader
+    int locUseMaps[RLG_COUNT_MATERIAL_MAPS];
+    int locParallaxMinLayers;
+    int locParallaxMaxLayers;
+    int locLightPass;                       ///< Selects the base pass (0) or the pass of the light (1)
+    struct RLG_LightLocs lightLocs;
+    bool loaded;                            ///< Indicates whether the shader loading has been attempted
+    bool active;
+};
+
+struct RLG_MomentsShadows
+{
+    Shader depth;           ///< Writes the (warped) depth and its square
+    Shader blur;            ///< One direction of the separable Gaussian blur
+    unsigned int vaoId;     ///< Empty vertex array for the fullscreen triangle of the blur
+    int locExponent;
+    int locDirection;
+    bool loaded;            ///< Indicates whether the shaders loading has been attempted
 };
 
 static struct RLG_Core
@@ -1509,6 +3297,38 @@ static struct RLG_Core
 
     struct RLG_SkyboxHandling skybox;
 
+    /* Shadow maps released by the lights, from the least to the most recently released */
+
+    struct RLG_PooledShadowMap *shadowPool;
+    unsigned int shadowPoolCount;
+    unsigned int shadowPoolCapacity;
+    unsigned int shadowPoolReused;
+    unsigned int shadowPoolLoaded;
+
+    /* Layered omnilight shadow rendering */
+
+    struct RLG_LayeredShadows layered;
+
+    /* Dual-paraboloid omnilight shadow rendering */
+
+    struct RLG_ParaboloidShadows paraboloid;
+
+    /* Variance shadow map rendering */
+
+    struct RLG_MomentsShadows moments;
+
+    /* Screen-space shadow mask */
+
+    struct RLG_ShadowMask shadowMask;
+
+    /* Deferred shading path */
+
+    struct RLG_Deferred deferred;
+
+    /* Multi-pass forward lighting */
+
+    struct RLG_MultiPass multiPass;
+
     /* Lighting shader data*/
 
     struct RLG_Material material;
@@ -1518,14 +3338,57 @@ static struct RLG_Core
     Vector3 colAmbient;
     Vector3 viewPos;
 
+    RLG_IrradianceMode irradianceMode;  ///< Irradiance storage of the skyboxes loaded afterwards
+    int irradianceSamples;              ///< Samples per texel of the sampled irradiance cubemaps
+    bool incrementalBake;               ///< Sampled irradiance cubemaps left to RLG_BakeSkyboxStep
+    Vector3 irradianceSH[9];
+    int useIrradianceSH;
+
+    /* Shadow casters registered by the user */
+
+    struct RLG_ShadowCaster *casters;
+    unsigned int casterCapacity;
+
+    /* Depth pre-pass of the lighting shader */
+
+    struct
+    {
+        bool active;
+        bool drawing;   ///< Indicates that RLG_DrawDepthPrepass is calling the draw function
+        bool filled;    ///< The depth buffer of the target holds the pre-pass, until RLG_EndDepthPrepass
+        int framebufferId;  ///< Framebuffer whose depth the pre-pass filled
+    }
+    depthPrepass;
+
+    /* Local reflection probes */
+
+    struct
+    {
+        struct RLG_ReflectionProbe *probes;
+        unsigned int capacity;
+        unsigned int next;      ///< Probe served first by the next RLG_UpdateReflectionProbes, in a round-robin fashion
+        bool capturing;         ///< Indicates that RLG_UpdateReflectionProbes is calling the draw function
+    }
+    reflectionProbes;
+
+    /* Position-only vertex streams of the depth passes, sorted by mesh buffer */
+
+    struct
+    {
+        struct RLG_PositionStream *streams;
+        unsigned int count;
+        unsigned int capacity;
+        bool quantized;
+        bool active;
+    }
+    positionStreams;
+
     /* Special values ​​and uniforms */
 
     float zNear;
     float zFar;
+    float projScale;    ///< Vertical scale factor of the last projection used by RLG_DrawMesh
 
-    int locDepthCubemapLightPos;
-    int locDepthCubemapFar;
-    int locLightingFar;
 }
 *rlgCtx = NULL;
 
@@ -1537,11 +3400,17 @@ static struct RLG_Core
         *rlgCachedDepthVS = rlgDepthVS,
         *rlgCachedDepthFS = rlgDepthFS;
     static const char
-        *rlgCachedDepthCubemapVS = rlgDepthCubemapVS,
-        *rlgCachedDepthCubemapFS = rlgDepthCubemapFS;
+        *rlgCachedDepthCubemapVS = rlgDepthVS,
+        *rlgCachedDepthCubemapFS = rlgDepthFS;
     static const char
         *rlgCachedIrradianceConvolutionVS = rlgCubemapVS,
         *rlgCachedIrradianceConvolutionFS = rlgIrradianceConvolutionFS;
+    static const char
+        *rlgCachedIrradianceSamplingVS = rlgCubemapVS,
+        *rlgCachedIrradianceSamplingFS = rlgIrradianceSamplingFS;
+    static const char
+        *rlgCachedPrefilterVS = rlgCubemapVS,
+        *rlgCachedPrefilterFS = rlgPrefilterFS;
     static const char
         *rlgCachedEquirectangularToCubemapVS = rlgCubemapVS,
         *rlgCachedSkyboxVS = rlgSkyboxVS,
@@ -1558,6 +3427,10 @@ static struct RLG_Core
         *rlgCachedDepthCubemapFS                = NULL,
         *rlgCachedIrradianceConvolutionFS       = NULL,
         *rlgCachedIrradianceConvolutionVS       = NULL,
+        *rlgCachedIrradianceSamplingVS          = NULL,
+        *rlgCachedIrradianceSamplingFS          = NULL,
+        *rlgCachedPrefilterVS                   = NULL,
+        *rlgCachedPrefilterFS                   = NULL,
         *rlgCachedEquirectangularToCubemapVS    = NULL,
         *rlgCachedEquirectangularToCubemapFS    = NULL,
         *rlgCachedSkyboxVS                      = NULL,
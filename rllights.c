@@ -1,5 +1,112 @@
 #include "rlights.h"
 
+// Texture units where the shadow samplers of a light are left when they are not in use
+#ifdef RLG_SHADOW_HARDWARE_PCF
+// The depth comparison samplers have no material map of the same type, they get units of their own,
+// after the units of the lights (11 + i) and of the shadow mask and its depth in the lighting shader
+#define RLG_SHADOW_PARK_UNIT_2D     (13 + (int)rlgCtx->lightCount)
+#define RLG_SHADOW_PARK_UNIT_CUBE   (14 + (int)rlgCtx->lightCount)
+#else
+// These are the units of material maps whose samplers in the lighting shader have the same type
+#define RLG_SHADOW_PARK_UNIT_2D     MATERIAL_MAP_BRDF
+#define RLG_SHADOW_PARK_UNIT_CUBE   MATERIAL_MAP_PREFILTER
+#endif
+#define RLG_SHADOW_PARK_UNIT_MOMENTS MATERIAL_MAP_ALBEDO    // Same sampler type as the albedo map
+
+// Proportion of the fade end distance beyond which the shadow of a light is turned off
+#define RLG_SHADOW_FADE_HYSTERESIS  1.1f
+
+static void rlgGetLightingLocations(Shader *shader)
+{
+    // NOTE: Locations that cannot be retrieved are set to -1 by 'rlGetLocationAttrib'
+    shader->locs = (int*)malloc(RLG_COUNT_LOCS*sizeof(int));
+
+    // Get handles to GLSL input attribute locations
+    shader->locs[RLG_LOC_VERTEX_POSITION]    = rlGetLocationAttrib(shader->id, RLG_SHADER_LIGHTING_ATTRIB_POSITION);
+    shader->locs[RLG_LOC_VERTEX_TEXCOORD01]  = rlGetLocationAttrib(shader->id, RLG_SHADER_LIGHTING_ATTRIB_TEXCOORD);
+    shader->locs[RLG_LOC_VERTEX_TEXCOORD02]  = rlGetLocationAttrib(shader->id, RLG_SHADER_LIGHTING_ATTRIB_TEXCOORD2);
+    shader->locs[RLG_LOC_VERTEX_NORMAL]      = rlGetLocationAttrib(shader->id, RLG_SHADER_LIGHTING_ATTRIB_NORMAL);
+    shader->locs[RLG_LOC_VERTEX_TANGENT]     = rlGetLocationAttrib(shader->id, RLG_SHADER_LIGHTING_ATTRIB_TANGENT);
+    shader->locs[RLG_LOC_VERTEX_COLOR]       = rlGetLocationAttrib(shader->id, RLG_SHADER_LIGHTING_ATTRIB_COLOR);
+
+    // Get handles to GLSL uniform locations (vertex shader)
+    shader->locs[RLG_LOC_MATRIX_MVP]         = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_MVP);
+    shader->locs[RLG_LOC_MATRIX_VIEW]        = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_VIEW);
+    shader->locs[RLG_LOC_MATRIX_PROJECTION]  = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_PROJECTION);
+    shader->locs[RLG_LOC_MATRIX_MODEL]       = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_MODEL);
+    shader->locs[RLG_LOC_MATRIX_NORMAL]      = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_NORMAL);
+
+    // Get handles to GLSL uniform locations (fragment shader)
+    shader->locs[RLG_LOC_COLOR_AMBIENT]      = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_COLOR_AMBIENT);
+    shader->locs[RLG_LOC_VECTOR_VIEW]        = rlGetLocationUniform(shader->id, RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION);
+
+    shader->locs[RLG_LOC_COLOR_DIFFUSE]      = rlGetLocationUniform(shader->id, TextFormat("maps[%i].color", MATERIAL_MAP_ALBEDO));
+    shader->locs[RLG_LOC_COLOR_SPECULAR]     = rlGetLocationUniform(shader->id, TextFormat("maps[%i].color", MATERIAL_MAP_METALNESS));
+    shader->locs[RLG_LOC_COLOR_EMISSION]     = rlGetLocationUniform(shader->id, TextFormat("maps[%i].color", MATERIAL_MAP_EMISSION));
+
+    shader->locs[RLG_LOC_MAP_ALBEDO]         = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_ALBEDO));
+    shader->locs[RLG_LOC_MAP_METALNESS]      = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_METALNESS));
+    shader->locs[RLG_LOC_MAP_NORMAL]         = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_NORMAL));
+    shader->locs[RLG_LOC_MAP_ROUGHNESS]      = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_ROUGHNESS));
+    shader->locs[RLG_LOC_MAP_OCCLUSION]      = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_OCCLUSION));
+    shader->locs[RLG_LOC_MAP_EMISSION]       = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_EMISSION));
+    shader->locs[RLG_LOC_MAP_HEIGHT]         = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_HEIGHT));
+    shader->locs[RLG_LOC_MAP_BRDF]           = rlGetLocationUniform(shader->id, TextFormat("maps[%i].texture", MATERIAL_MAP_HEIGHT + 1));
+
+    shader->locs[RLG_LOC_MAP_CUBEMAP]        = rlGetLocationUniform(shader->id, TextFormat("cubemaps[%i].texture", 0));
+    shader->locs[RLG_LOC_MAP_IRRADIANCE]     = rlGetLocationUniform(shader->id, TextFormat("cubemaps[%i].texture", 1));
+    shader->locs[RLG_LOC_MAP_PREFILTER]      = rlGetLocationUniform(shader->id, TextFormat("cubemaps[%i].texture", 2));
+
+    shader->locs[RLG_LOC_METALNESS_SCALE]    = rlGetLocationUniform(shader->id, TextFormat("maps[%i].value", MATERIAL_MAP_METALNESS));
+    shader->locs[RLG_LOC_ROUGHNESS_SCALE]    = rlGetLocationUniform(shader->id, TextFormat("maps[%i].value", MATERIAL_MAP_ROUGHNESS));
+    shader->locs[RLG_LOC_AO_LIGHT_AFFECT]    = rlGetLocationUniform(shader->id, TextFormat("maps[%i].value", MATERIAL_MAP_OCCLUSION));
+    shader->locs[RLG_LOC_HEIGHT_SCALE]       = rlGetLocationUniform(shader->id, TextFormat("maps[%i].value", MATERIAL_MAP_HEIGHT));
+
+    shader->locs[RLG_LOC_IRRADIANCE_SH]      = rlGetLocationUniform(shader->id, "irradianceSH");
+    shader->locs[RLG_LOC_USE_IRRADIANCE_SH]  = rlGetLocationUniform(shader->id, "useIrradianceSH");
+
+    shader->locs[RLG_LOC_USE_PROBE]          = rlGetLocationUniform(shader->id, "useProbe");
+    shader->locs[RLG_LOC_PROBE_POSITION]     = rlGetLocationUniform(shader->id, "probePosition");
+    shader->locs[RLG_LOC_PROBE_BOX_MIN]      = rlGetLocationUniform(shader->id, "probeBoxMin");
+    shader->locs[RLG_LOC_PROBE_BOX_MAX]      = rlGetLocationUniform(shader->id, "probeBoxMax");
+
+    // Give each material sampler its own texture unit, the same one used when binding its texture
+    for (int i = RLG_LOC_MAP_ALBEDO; i <= RLG_LOC_MAP_BRDF; i++)
+    {
+        int unit = i - RLG_LOC_MAP_ALBEDO;
+        SetShaderValue(*shader, shader->locs[i], &unit, SHADER_UNIFORM_INT);
+    }
+}
+
+static void rlgGetLightLocations(unsigned int shaderId, unsigned int light, struct RLG_LightLocs *locs)
+{
+    locs->vpMatrix       = rlGetLocationUniform(shaderId, TextFormat("matLights[%i]", light));
+    locs->shadowCubemap  = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowCubemap", light));
+    locs->shadowMap      = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowMap", light));
+    locs->shadowMoments  = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowMoments", light));
+    locs->position       = rlGetLocationUniform(shaderId, TextFormat("lights[%i].position", light));
+    locs->direction      = rlGetLocationUniform(shaderId, TextFormat("lights[%i].direction", light));
+    locs->color          = rlGetLocationUniform(shaderId, TextFormat("lights[%i].color", light));
+    locs->energy         = rlGetLocationUniform(shaderId, TextFormat("lights[%i].energy", light));
+    locs->specular       = rlGetLocationUniform(shaderId, TextFormat("lights[%i].specular", light));
+    locs->size           = rlGetLocationUniform(shaderId, TextFormat("lights[%i].size", light));
+    locs->innerCutOff    = rlGetLocationUniform(shaderId, TextFormat("lights[%i].innerCutOff", light));
+    locs->outerCutOff    = rlGetLocationUniform(shaderId, TextFormat("lights[%i].outerCutOff", light));
+    locs->constant       = rlGetLocationUniform(shaderId, TextFormat("lights[%i].constant", light));
+    locs->linear         = rlGetLocationUniform(shaderId, TextFormat("lights[%i].linear", light));
+    locs->quadratic      = rlGetLocationUniform(shaderId, TextFormat("lights[%i].quadratic", light));
+    locs->shadowMapTxlSz = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowMapTxlSz", light));
+    locs->depthBias      = rlGetLocationUniform(shaderId, TextFormat("lights[%i].depthBias", light));
+    locs->shadowDepthParams = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowDepthParams", light));
+    locs->shadowFade     = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowFade", light));
+    locs->type           = rlGetLocationUniform(shaderId, TextFormat("lights[%i].type", light));
+    locs->shadow         = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadow", light));
+    locs->shadowTechnique = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowTechnique", light));
+    locs->omniShadowMode = rlGetLocationUniform(shaderId, TextFormat("lights[%i].omniShadowMode", light));
+    locs->shadowMaskChannel = rlGetLocationUniform(shaderId, TextFormat("lights[%i].shadowMaskChannel", light));
+    locs->enabled        = rlGetLocationUniform(shaderId, TextFormat("lights[%i].enabled", light));
+}
+
 RLG_Context RLG_CreateContext(unsigned int count)
 {
     // On-heap allocation for the context's core structure, initializing it with zeros
@@ -46,7 +153,7 @@ RLG_Context RLG_CreateContext(unsigned int count)
         {
             // Format frag shader with lights count
             char *fmtFrag = (char*)malloc(sizeof(rlgLightingFS));
-            snprintf(fmtFrag, sizeof(rlgLightingFS), rlgLightingFS, count);
+            snprintf(fmtFrag, sizeof(rlgLightingFS), rlgLightingFS, count, "");
             lightFS = fmtFrag;
         }
 
@@ -59,49 +166,7 @@ RLG_Context RLG_CreateContext(unsigned int count)
     // After shader loading, we TRY to set default location names
     if (lightShader.id > 0)
     {
-        // NOTE: Locations that cannot be retrieved are set to -1 by 'rlGetLocationAttrib'
-        lightShader.locs = (int*)malloc(RLG_COUNT_LOCS*sizeof(int));
-
-        // Get handles to GLSL input attribute locations
-        lightShader.locs[RLG_LOC_VERTEX_POSITION]    = rlGetLocationAttrib(lightShader.id, RLG_SHADER_LIGHTING_ATTRIB_POSITION);
-        lightShader.locs[RLG_LOC_VERTEX_TEXCOORD01]  = rlGetLocationAttrib(lightShader.id, RLG_SHADER_LIGHTING_ATTRIB_TEXCOORD);
-        lightShader.locs[RLG_LOC_VERTEX_TEXCOORD02]  = rlGetLocationAttrib(lightShader.id, RLG_SHADER_LIGHTING_ATTRIB_TEXCOORD2);
-        lightShader.locs[RLG_LOC_VERTEX_NORMAL]      = rlGetLocationAttrib(lightShader.id, RLG_SHADER_LIGHTING_ATTRIB_NORMAL);
-        lightShader.locs[RLG_LOC_VERTEX_TANGENT]     = rlGetLocationAttrib(lightShader.id, RLG_SHADER_LIGHTING_ATTRIB_TANGENT);
-        lightShader.locs[RLG_LOC_VERTEX_COLOR]       = rlGetLocationAttrib(lightShader.id, RLG_SHADER_LIGHTING_ATTRIB_COLOR);
-
-        // Get handles to GLSL uniform locations (vertex shader)
-        lightShader.locs[RLG_LOC_MATRIX_MVP]         = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_MVP);
-        lightShader.locs[RLG_LOC_MATRIX_VIEW]        = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_VIEW);
-        lightShader.locs[RLG_LOC_MATRIX_PROJECTION]  = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_PROJECTION);
-        lightShader.locs[RLG_LOC_MATRIX_MODEL]       = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_MODEL);
-        lightShader.locs[RLG_LOC_MATRIX_NORMAL]      = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_NORMAL);
-
-        // Get handles to GLSL uniform locations (fragment shader)
-        lightShader.locs[RLG_LOC_COLOR_AMBIENT]      = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_COLOR_AMBIENT);
-        lightShader.locs[RLG_LOC_VECTOR_VIEW]        = rlGetLocationUniform(lightShader.id, RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION);
-
-        lightShader.locs[RLG_LOC_COLOR_DIFFUSE]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_ALBEDO));
-        lightShader.locs[RLG_LOC_COLOR_SPECULAR]     = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_METALNESS));
-        lightShader.locs[RLG_LOC_COLOR_EMISSION]     = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_EMISSION));
-
-        lightShader.locs[RLG_LOC_MAP_ALBEDO]         = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_ALBEDO));
-        lightShader.locs[RLG_LOC_MAP_METALNESS]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_METALNESS));
-        lightShader.locs[RLG_LOC_MAP_NORMAL]         = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_NORMAL));
-        lightShader.locs[RLG_LOC_MAP_ROUGHNESS]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_ROUGHNESS));
-        lightShader.locs[RLG_LOC_MAP_OCCLUSION]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_OCCLUSION));
-        lightShader.locs[RLG_LOC_MAP_EMISSION]       = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_EMISSION));
-        lightShader.locs[RLG_LOC_MAP_HEIGHT]         = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_HEIGHT));
-        lightShader.locs[RLG_LOC_MAP_BRDF]           = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_HEIGHT + 1));
-
-        lightShader.locs[RLG_LOC_MAP_CUBEMAP]        = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].texture", 0));
-        lightShader.locs[RLG_LOC_MAP_IRRADIANCE]     = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].texture", 1));
-        lightShader.locs[RLG_LOC_MAP_PREFILTER]      = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].texture", 2));
-
-        lightShader.locs[RLG_LOC_METALNESS_SCALE]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_METALNESS));
-        lightShader.locs[RLG_LOC_ROUGHNESS_SCALE]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_ROUGHNESS));
-        lightShader.locs[RLG_LOC_AO_LIGHT_AFFECT]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_OCCLUSION));
-        lightShader.locs[RLG_LOC_HEIGHT_SCALE]       = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_HEIGHT));
+        rlgGetLightingLocations(&lightShader);
 
         // Definition of the lighting shader once initialization is successful
         rlgCtx->shaders[RLG_SHADER_LIGHTING] = lightShader;
@@ -146,9 +211,10 @@ RLG_Context RLG_CreateContext(unsigned int count)
     // Recovery of “special” lighting shader uniforms
     rlgCtx->material.locs.parallaxMinLayers = rlGetLocationUniform(lightShader.id, "parallaxMinLayers");
     rlgCtx->material.locs.parallaxMaxLayers = rlGetLocationUniform(lightShader.id, "parallaxMaxLayers");
-    rlgCtx->locLightingFar = rlGetLocationUniform(lightShader.id, "farPlane");
 
     // Allocation and initialization of the desired number of lights
+    // NOTE: The light count is set first, the units the shadow samplers are parked on depend on it
+    rlgCtx->lightCount = count;
     rlgCtx->lights = (struct RLG_Light*)calloc(count, sizeof(struct RLG_Light));
     for (unsigned int i = 0; i < count; i++)
     {
@@ -168,29 +234,24 @@ RLG_Context RLG_CreateContext(unsigned int count)
         light->data.quadratic      = 0.0f;
         light->data.shadowMapTxlSz = 0.0f;
         light->data.depthBias      = 0.0f;
+        light->data.shadowFade     = 1.0f;
         light->data.type           = RLG_DIRLIGHT;
         light->data.shadow         = 0;
         light->data.enabled        = 0;
 
-        light->locs.vpMatrix       = rlGetLocationUniform(lightShader.id, TextFormat("matLights[%i]", i));
-        light->locs.shadowCubemap  = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadowCubemap", i));
-        light->locs.shadowMap      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadowMap", i));
-        light->locs.position       = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].position", i));
-        light->locs.direction      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].direction", i));
-        light->locs.color          = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].color", i));
-        light->locs.energy         = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].energy", i));
-        light->locs.specular       = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].specular", i));
-        light->locs.size           = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].size", i));
-        light->locs.innerCutOff    = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].innerCutOff", i));
-        light->locs.outerCutOff    = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].outerCutOff", i));
-        light->locs.constant       = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].constant", i));
-        light->locs.linear         = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].linear", i));
-        light->locs.quadratic      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].quadratic", i));
-        light->locs.shadowMapTxlSz = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadowMapTxlSz", i));
-        light->locs.depthBias      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].depthBias", i));
-        light->locs.type           = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].type", i));
-        light->locs.shadow         = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadow", i));
-        light->locs.enabled        = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].enabled", i));
+        rlgGetLightLocations(lightShader.id, i, &light->locs);
+
+        // Park the shadow samplers on texture units that no sampler of another type uses
+        // NOTE: Two samplers of different types referring to the same unit make draws fail
+        int parkMap = RLG_SHADOW_PARK_UNIT_2D, parkCubemap = RLG_SHADOW_PARK_UNIT_CUBE;
+        int parkMoments = RLG_SHADOW_PARK_UNIT_MOMENTS;
+        SetShaderValue(lightShader, light->locs.shadowMap, &parkMap, SHADER_UNIFORM_INT);
+        SetShaderValue(lightShader, light->locs.shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT);
+        SetShaderValue(lightShader, light->locs.shadowMoments, &parkMoments, SHADER_UNIFORM_INT);
+
+        // No light reads its shadow from the shadow mask until it is used
+        light->data.shadowMaskChannel = -1;
+        SetShaderValue(lightShader, light->locs.shadowMaskChannel, &light->data.shadowMaskChannel, SHADER_UNIFORM_INT);
 
         SetShaderValue(lightShader, light->locs.color, &light->data.color, SHADER_UNIFORM_VEC3);
         SetShaderValue(lightShader, light->locs.energy, &light->data.energy, SHADER_UNIFORM_FLOAT);
@@ -198,10 +259,16 @@ RLG_Context RLG_CreateContext(unsigned int count)
         SetShaderValue(lightShader, light->locs.innerCutOff, &light->data.innerCutOff, SHADER_UNIFORM_FLOAT);
         SetShaderValue(lightShader, light->locs.outerCutOff, &light->data.outerCutOff, SHADER_UNIFORM_FLOAT);
         SetShaderValue(lightShader, light->locs.constant, &light->data.constant, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(lightShader, light->locs.shadowFade, &light->data.shadowFade, SHADER_UNIFORM_FLOAT);
     }
 
-    // Set light count
-    rlgCtx->lightCount = count;
+    // Retrieving the lighting shader uniforms reading the shadow mask (GLSL 330 only)
+    rlgCtx->shadowMask.locLightingMask = rlGetLocationUniform(lightShader.id, "shadowMask");
+    rlgCtx->shadowMask.locLightingDepth = rlGetLocationUniform(lightShader.id, "sceneDepth");
+    rlgCtx->shadowMask.locLightingDepthParams = rlGetLocationUniform(lightShader.id, "sceneDepthParams");
+    rlgCtx->shadowMask.locLightingUse = rlGetLocationUniform(lightShader.id, "useShadowMask");
+    rlgCtx->shadowMask.scale = 1.0f;
+    for (int i = 0; i < 4; i++) rlgCtx->shadowMask.lights[i] = -1;
 
     // Init default material maps
     Texture defaultTexture  = (Texture){0};
@@ -229,16 +296,13 @@ RLG_Context RLG_CreateContext(unsigned int count)
 
     // Load depth cubemap shader (used for omnilight shadow casting)
     rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP] = LoadShaderFromMemory(rlgCachedDepthCubemapVS, rlgCachedDepthCubemapFS);
-    rlgCtx->locDepthCubemapLightPos = rlGetLocationUniform(rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP].id, "lightPos");
-    rlgCtx->locDepthCubemapFar = rlGetLocationUniform(rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP].id, "farPlane");
 
     // Get Near/Far render values
     rlgCtx->zNear = 0.01f;  // TODO: replace with rlGetCullDistanceNear()
     rlgCtx->zFar = 1000.0f; // TODO: replace with rlGetCullDistanceFar()
 
-    // Send Near/Far to shaders who need it
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP],
-        rlgCtx->locDepthCubemapFar, &rlgCtx->zFar, SHADER_UNIFORM_FLOAT);
+    // Rough projection scale (45 degrees fov) until the first call to RLG_DrawMesh
+    rlgCtx->projScale = 1.2f;
 
     // Load equirectangular to cubemap shader (used for skybox cubemap generation)
     rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP] = LoadShaderFromMemory(
@@ -252,6 +316,25 @@ RLG_Context RLG_CreateContext(unsigned int count)
     rlgCtx->shaders[RLG_SHADER_SKYBOX] = LoadShaderFromMemory(rlgCachedSkyboxVS, rlgCachedSkyboxFS);
     rlgCtx->skybox.locDoGamma = rlGetLocationUniform(rlgCtx->shaders[RLG_SHADER_SKYBOX].id, "doGamma");
 
+    // Load importance sampled irradiance shader (used to bake the sampled irradiance cubemaps)
+    rlgCtx->shaders[RLG_SHADER_IRRADIANCE_SAMPLING] = LoadShaderFromMemory(
+        rlgCachedIrradianceSamplingVS, rlgCachedIrradianceSamplingFS);
+
+    unsigned int samplingId = rlgCtx->shaders[RLG_SHADER_IRRADIANCE_SAMPLING].id;
+    rlgCtx->skybox.locSampleCount = rlGetLocationUniform(samplingId, "sampleCount");
+    rlgCtx->skybox.locEnvironmentSize = rlGetLocationUniform(samplingId, "environmentSize");
+    rlgCtx->skybox.locImplicitLod = rlGetLocationUniform(samplingId, "implicitLod");
+    rlgCtx->irradianceSamples = 512;
+
+    // Load prefilter shader (used to generate the GGX prefiltered radiance of the skyboxes)
+    rlgCtx->shaders[RLG_SHADER_PREFILTER] = LoadShaderFromMemory(rlgCachedPrefilterVS, rlgCachedPrefilterFS);
+
+    unsigned int prefilterId = rlgCtx->shaders[RLG_SHADER_PREFILTER].id;
+    rlgCtx->skybox.locPrefilterSampleCount = rlGetLocationUniform(prefilterId, "sampleCount");
+    rlgCtx->skybox.locPrefilterEnvironmentSize = rlGetLocationUniform(prefilterId, "environmentSize");
+    rlgCtx->skybox.locPrefilterImplicitLod = rlGetLocationUniform(prefilterId, "implicitLod");
+    rlgCtx->skybox.locPrefilterRoughness = rlGetLocationUniform(prefilterId, "roughness");
+
     return (RLG_Context)rlgCtx;
 }
 
@@ -268,6 +351,12 @@ void RLG_DestroyContext(RLG_Context ctx)
         }
     }
 
+    UnloadTexture(pCtx->skybox.brdfLUT);
+
+    if (pCtx->skybox.vaoId > 0) rlUnloadVertexArray(pCtx->skybox.vaoId);
+    if (pCtx->skybox.vboPositionsId > 0) rlUnloadVertexBuffer(pCtx->skybox.vboPositionsId);
+    if (pCtx->skybox.vboIndicesId > 0) rlUnloadVertexBuffer(pCtx->skybox.vboIndicesId);
+
     if (pCtx->lights != NULL)
     {
         for (unsigned int i = 0; i < pCtx->lightCount; i++)
@@ -279,6 +368,12 @@ void RLG_DestroyContext(RLG_Context ctx)
                 rlUnloadTexture(light->data.shadowMap.depth.id);
                 rlUnloadFramebuffer(light->data.shadowMap.id);
             }
+
+            if (light->data.shadowMap.momentsId != 0)
+            {
+                rlUnloadTexture(light->data.shadowMap.moments.id);
+                rlUnloadFramebuffer(light->data.shadowMap.momentsId);
+            }
         }
 
         free(pCtx->lights);
@@ -286,6 +381,110 @@ void RLG_DestroyContext(RLG_Context ctx)
     }
 
     pCtx->lightCount = 0;
+
+    // Unload the layered shaders, these are not managed by raylib
+    struct RLG_LayeredShader *layeredShaders[2] = { &pCtx->layered.geometry, &pCtx->layered.instanced };
+    for (int i = 0; i < 2; i++)
+    {
+        if (layeredShaders[i]->shader.id > 0)
+        {
+            rlUnloadShaderProgram(layeredShaders[i]->shader.id);
+            free(layeredShaders[i]->shader.locs);
+            layeredShaders[i]->shader = (Shader){0};
+        }
+    }
+
+    // Unload the dual-paraboloid shader
+    if (pCtx->paraboloid.shader.id > 0) UnloadShader(pCtx->paraboloid.shader);
+    pCtx->paraboloid = (struct RLG_ParaboloidShadows){0};
+
+    // Unload the variance shadow map shaders
+    if (pCtx->moments.depth.id > 0) UnloadShader(pCtx->moments.depth);
+    if (pCtx->moments.blur.id > 0) UnloadShader(pCtx->moments.blur);
+    if (pCtx->moments.vaoId > 0) rlUnloadVertexArray(pCtx->moments.vaoId);
+    pCtx->moments = (struct RLG_MomentsShadows){0};
+
+    // Unload the shadow mask shader and its render targets
+    if (pCtx->shadowMask.shader.id > 0) UnloadShader(pCtx->shadowMask.shader);
+    if (pCtx->shadowMask.vaoId > 0) rlUnloadVertexArray(pCtx->shadowMask.vaoId);
+    if (pCtx->shadowMask.depthId > 0)
+    {
+        rlUnloadTexture(pCtx->shadowMask.depth.id);
+        rlUnloadFramebuffer(pCtx->shadowMask.depthId);
+    }
+    if (pCtx->shadowMask.maskId > 0)
+    {
+        rlUnloadTexture(pCtx->shadowMask.mask.id);
+        rlUnloadFramebuffer(pCtx->shadowMask.maskId);
+    }
+    pCtx->shadowMask = (struct RLG_ShadowMask){0};
+
+    // Unload the deferred shaders, the light volumes and the G-buffer
+    if (pCtx->deferred.gbuffer.id > 0) UnloadShader(pCtx->deferred.gbuffer);
+    if (pCtx->deferred.light.id > 0) UnloadShader(pCtx->deferred.light);
+    if (pCtx->deferred.composite.id > 0) UnloadShader(pCtx->deferred.composite);
+    if (pCtx->deferred.vaoId > 0)
+    {
+        rlUnloadVertexArray(pCtx->deferred.vaoId);
+        rlUnloadVertexBuffer(pCtx->deferred.vboId);
+    }
+    if (pCtx->deferred.framebufferId > 0)
+    {
+        rlUnloadTexture(pCtx->deferred.albedo.id);
+        rlUnloadTexture(pCtx->deferred.normal.id);
+        rlUnloadTexture(pCtx->deferred.lighting.id);
+        rlUnloadTexture(pCtx->deferred.depth.id);
+        rlUnloadFramebuffer(pCtx->deferred.framebufferId);
+    }
+    pCtx->deferred = (struct RLG_Deferred){0};
+
+    // Unload the multi-pass lighting shader
+    if (pCtx->multiPass.shader.id > 0) UnloadShader(pCtx->multiPass.shader);
+    pCtx->multiPass = (struct RLG_MultiPass){0};
+
+    for (unsigned int i = 0; i < pCtx->shadowPoolCount; i++)
+    {
+        rlUnloadTexture(pCtx->shadowPool[i].texture.id);
+        rlUnloadFramebuffer(pCtx->shadowPool[i].id);
+    }
+
+    free(pCtx->shadowPool);
+    pCtx->shadowPool = NULL;
+    pCtx->shadowPoolCount = 0;
+    pCtx->shadowPoolCapacity = 0;
+
+    free(pCtx->casters);
+    pCtx->casters = NULL;
+    pCtx->casterCapacity = 0;
+
+    for (unsigned int i = 0; i < pCtx->reflectionProbes.capacity; i++)
+    {
+        struct RLG_ReflectionProbe *probe = &pCtx->reflectionProbes.probes[i];
+
+        if (probe->used)
+        {
+            RLG_UnloadSkybox(probe->capture);
+            rlUnloadTexture(probe->prefilter.id);
+            rlUnloadFramebuffer(probe->framebufferId);
+        }
+    }
+
+    free(pCtx->reflectionProbes.probes);
+    pCtx->reflectionProbes.probes = NULL;
+    pCtx->reflectionProbes.capacity = 0;
+
+    // Unload the position streams, the quantized ones own their vertex buffer
+    for (unsigned int i = 0; i < pCtx->positionStreams.count; i++)
+    {
+        struct RLG_PositionStream *stream = &pCtx->positionStreams.streams[i];
+        if (stream->vaoId > 0) rlUnloadVertexArray(stream->vaoId);
+        if (stream->quantized) rlUnloadVertexBuffer(stream->vboId);
+    }
+
+    free(pCtx->positionStreams.streams);
+    pCtx->positionStreams.streams = NULL;
+    pCtx->positionStreams.count = 0;
+    pCtx->positionStreams.capacity = 0;
 }
 
 void RLG_SetContext(RLG_Context ctx)
@@ -332,6 +531,16 @@ void RLG_SetCustomShaderCode(RLG_Shader shader, const char *vsCode, const char *
             rlgCachedSkyboxFS = fsCode;
             break;
 
+        case RLG_SHADER_IRRADIANCE_SAMPLING:
+            rlgCachedIrradianceSamplingVS = vsCode;
+            rlgCachedIrradianceSamplingFS = fsCode;
+            break;
+
+        case RLG_SHADER_PREFILTER:
+            rlgCachedPrefilterVS = vsCode;
+            rlgCachedPrefilterFS = fsCode;
+            break;
+
         default:
             TraceLog(LOG_WARNING, "Unsupported 'shader' passed to 'RLG_SetCustomShader'");
             break;
@@ -348,6 +557,49 @@ const Shader* RLG_GetShader(RLG_Shader shader)
     return &rlgCtx->shaders[shader];
 }
 
+// Fades the shadow of a light according to its distance from the view position
+static void rlgUpdateShadowFade(struct RLG_Light *l)
+{
+    float fade = 1.0f;
+    bool fadedOut = false;
+
+    if (l->data.shadowFadeEnd > 0.0f)
+    {
+        float start = l->data.shadowFadeStart, end = l->data.shadowFadeEnd;
+        float distance = Vector3Distance(rlgCtx->viewPos, l->data.position);
+
+        if (distance >= end) fade = 0.0f;
+        else if (distance > start)
+        {
+            float t = (distance - start)/(end - start);
+            fade = 1.0f - t*t*(3.0f - 2.0f*t);
+        }
+
+        // The shadow is turned off a little beyond the end of the fade, where it no longer
+        // contributes, and only turned back on once the light is within the end of the fade
+        fadedOut = l->data.shadowFadedOut ? (distance > end) : (distance > end*RLG_SHADOW_FADE_HYSTERESIS);
+    }
+
+    if (fade != l->data.shadowFade)
+    {
+        l->data.shadowFade = fade;
+        SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.shadowFade,
+            &l->data.shadowFade, SHADER_UNIFORM_FLOAT);
+    }
+
+    if (fadedOut != (bool)l->data.shadowFadedOut)
+    {
+        l->data.shadowFadedOut = fadedOut;
+
+        // The casters may have moved while the shadow map was left out of the updates
+        if (!fadedOut) l->data.shadowMap.dirtyFaces = 0x3F;
+
+        int shadow = l->data.shadow && !fadedOut;
+        SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.shadow,
+            &shadow, SHADER_UNIFORM_INT);
+    }
+}
+
 void RLG_SetViewPosition(float x, float y, float z)
 {
     RLG_SetViewPositionV((Vector3){ x, y, z});
@@ -362,6 +614,11 @@ void RLG_SetViewPositionV(Vector3 position)
         rlgCtx->viewPos = position;
         SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING],
             loc, &rlgCtx->viewPos, SHADER_UNIFORM_VEC3);
+
+        for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+        {
+            rlgUpdateShadowFade(&rlgCtx->lights[i]);
+        }
     }
 
 }
@@ -544,17 +801,17 @@ void RLG_SetLightType(unsigned int light, RLG_LightType type)
 
     if (l->data.type != type)
     {
-        if (l->data.shadow)
-        {
-            int shadowMapResolution = l->data.shadowMap.width;
-
-            RLG_DisableShadow(light);
-            RLG_EnableShadow(light, shadowMapResolution);
-        }
+        // The shadow map goes back to the pool with the storage of the previous type,
+        // then one with the storage of the new type is taken from it
+        bool shadow = l->data.shadow;
+        int shadowMapResolution = l->data.shadowMap.width;
+        if (shadow) RLG_DisableShadow(light);
 
         l->data.type = (int)type;
         SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.type,
             &l->data.type, SHADER_UNIFORM_INT);
+
+        if (shadow) RLG_EnableShadow(light, shadowMapResolution);
     }
 }
 
@@ -1076,6 +1333,259 @@ Vector3 RLG_GetLightTarget(unsigned int light)
     return result;
 }
 
+/* Shadow map storage */
+
+#ifdef RLG_SHADOW_DEPTH16
+#   define RLG_SHADOW_DEPTH_FORMAT GL_DEPTH_COMPONENT16
+#   define RLG_SHADOW_DEPTH_BYTES 2
+#else
+#   define RLG_SHADOW_DEPTH_FORMAT GL_DEPTH_COMPONENT
+#   define RLG_SHADOW_DEPTH_BYTES 4     // NOTE: Assumes the driver stores unsized depth on 32 bits
+#endif
+
+#ifdef RLG_SHADOW_HARDWARE_PCF
+#   define RLG_SHADOW_FILTER GL_LINEAR  // Linear filtering gives a 2x2 comparison per tap
+#else
+#   define RLG_SHADOW_FILTER GL_NEAREST
+#endif
+
+static int rlgGetShadowStorage(const struct RLG_Light *l)
+{
+    if (l->data.type != RLG_OMNILIGHT) return RLG_SHADOW_STORAGE_DEPTH;
+
+    return (l->data.omniShadowMode == RLG_OMNI_SHADOW_DUAL_PARABOLOID)
+        ? RLG_SHADOW_STORAGE_DEPTH_PARABOLOID : RLG_SHADOW_STORAGE_DEPTH_CUBE;
+}
+
+static void rlgLoadShadowMap(struct RLG_ShadowMap *sm, int storage, int resolution)
+{
+    // Set up a cube map for omnidirectional light shadows
+    if (storage == RLG_SHADOW_STORAGE_DEPTH_CUBE)
+    {
+        glGenFramebuffers(1, &sm->id);
+        glGenTextures(1, &sm->depth.id);
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, sm->depth.id);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, RLG_SHADOW_DEPTH_FORMAT,
+                resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        }
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, RLG_SHADOW_FILTER);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, RLG_SHADOW_FILTER);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+#   ifdef RLG_SHADOW_HARDWARE_PCF
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+#   endif
+
+        glBindFramebuffer(GL_FRAMEBUFFER, sm->id);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, sm->depth.id, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+
+        // Check if the framebuffer is complete
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            // Log an error if the framebuffer is not complete
+            TraceLog(LOG_ERROR, "Framebuffer is not complete for omnidirectional shadow map");
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Configure the shadow map parameters
+        sm->depth.width = sm->depth.height = resolution;
+        sm->width = sm->height = resolution;
+        sm->depth.format = 19, sm->depth.mipmaps = 1;
+    }
+    else
+    {
+        // Set up a 2D texture for shadow map for other light types,
+        // the two hemispheres of a dual-paraboloid map are side by side
+        int width = (storage == RLG_SHADOW_STORAGE_DEPTH_PARABOLOID) ? 2*resolution : resolution;
+
+        sm->id = rlLoadFramebuffer(width, resolution);
+        sm->width = sm->height = resolution;
+        rlEnableFramebuffer(sm->id);
+
+#   if defined(RLG_SHADOW_DEPTH16)
+        glGenTextures(1, &sm->depth.id);
+        glBindTexture(GL_TEXTURE_2D, sm->depth.id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16,
+            width, resolution, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+#   else
+        sm->depth.id = rlLoadTextureDepth(width, resolution, false);
+#   endif
+        sm->depth.width = width;
+        sm->depth.height = resolution;
+        sm->depth.format = 19, sm->depth.mipmaps = 1;
+
+        rlTextureParameters(sm->depth.id, RL_TEXTURE_WRAP_S, RL_TEXTURE_WRAP_CLAMP);
+        rlTextureParameters(sm->depth.id, RL_TEXTURE_WRAP_T, RL_TEXTURE_WRAP_CLAMP);
+        rlTextureParameters(sm->depth.id, RL_TEXTURE_MIN_FILTER, RLG_SHADOW_FILTER);
+        rlTextureParameters(sm->depth.id, RL_TEXTURE_MAG_FILTER, RLG_SHADOW_FILTER);
+
+#   ifdef RLG_SHADOW_HARDWARE_PCF
+        glBindTexture(GL_TEXTURE_2D, sm->depth.id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+#   endif
+        rlFramebufferAttach(sm->id, sm->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+    }
+}
+
+#if GLSL_VERSION >= 330
+#   ifdef RLG_SHADOW_MOMENTS16
+#       define RLG_SHADOW_MOMENTS_FORMAT GL_RG16F
+#       define RLG_SHADOW_MOMENTS_BYTES 4
+#   else
+#       define RLG_SHADOW_MOMENTS_FORMAT GL_RG32F
+#       define RLG_SHADOW_MOMENTS_BYTES 8
+#   endif
+#else
+#   define RLG_SHADOW_MOMENTS_BYTES 0
+#endif
+
+static void rlgLoadMomentsMap(Texture2D *moments, unsigned int *id, int resolution)
+{
+#if GLSL_VERSION >= 330
+    // Count the mip levels down to 1x1
+    int mipmaps = 1;
+    while ((resolution >> mipmaps) > 0) mipmaps++;
+
+    glGenTextures(1, &moments->id);
+    glBindTexture(GL_TEXTURE_2D, moments->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, RLG_SHADOW_MOMENTS_FORMAT,
+        resolution, resolution, 0, GL_RG, GL_FLOAT, NULL);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Trilinear filtering, the moments are meant to be filtered
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    moments->width = moments->height = resolution;
+    moments->mipmaps = mipmaps;
+    moments->format = PIXELFORMAT_UNCOMPRESSED_R32G32B32A32;    // NOTE: Closest raylib format, only informative
+
+    // Color-only framebuffer, target of the second blur pass
+    *id = rlLoadFramebuffer(resolution, resolution);
+    rlFramebufferAttach(*id, moments->id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    if (!rlFramebufferComplete(*id))
+    {
+        TraceLog(LOG_ERROR, "Framebuffer is not complete for shadow moments map");
+    }
+#else
+    (void)moments, (void)id, (void)resolution;
+#endif
+}
+
+static bool rlgTakePooledShadowStorage(int storage, int resolution, Texture2D *texture, unsigned int *id)
+{
+    // Reuse the most recently released storage of the same kind if there is one
+    // NOTE: The format of a storage kind is fixed at compile time, it is not part of the key
+    for (unsigned int i = rlgCtx->shadowPoolCount; i-- > 0;)
+    {
+        struct RLG_PooledShadowMap *pooled = &rlgCtx->shadowPool[i];
+
+        if (pooled->storage == storage && pooled->texture.height == resolution)
+        {
+            *texture = pooled->texture;
+            *id = pooled->id;
+
+            // Keep the pool ordered by release, the oldest entries are the first to be trimmed
+            rlgCtx->shadowPoolCount--;
+            memmove(pooled, pooled + 1, (rlgCtx->shadowPoolCount - i)*sizeof(struct RLG_PooledShadowMap));
+
+            rlgCtx->shadowPoolReused++;
+            return true;
+        }
+    }
+
+    rlgCtx->shadowPoolLoaded++;
+    return false;
+}
+
+static void rlgPutPooledShadowStorage(int storage, Texture2D texture, unsigned int id)
+{
+    // Grow the pool if it is full
+    if (rlgCtx->shadowPoolCount == rlgCtx->shadowPoolCapacity)
+    {
+        unsigned int capacity = (rlgCtx->shadowPoolCapacity == 0) ? 8 : 2*rlgCtx->shadowPoolCapacity;
+        struct RLG_PooledShadowMap *pool = (struct RLG_PooledShadowMap*)realloc(
+            rlgCtx->shadowPool, capacity*sizeof(struct RLG_PooledShadowMap));
+
+        if (!pool)
+        {
+            // Unable to keep it, the storage is simply unloaded
+            rlUnloadTexture(texture.id);
+            rlUnloadFramebuffer(id);
+            return;
+        }
+
+        rlgCtx->shadowPool = pool;
+        rlgCtx->shadowPoolCapacity = capacity;
+    }
+
+    rlgCtx->shadowPool[rlgCtx->shadowPoolCount++] = (struct RLG_PooledShadowMap) {
+        texture, id, storage
+    };
+}
+
+static void rlgAcquireShadowMap(struct RLG_ShadowMap *sm, int storage, int resolution)
+{
+    if (rlgTakePooledShadowStorage(storage, resolution, &sm->depth, &sm->id))
+    {
+        sm->width = sm->height = resolution;
+        return;
+    }
+
+    rlgLoadShadowMap(sm, storage, resolution);
+}
+
+static void rlgReleaseShadowMap(struct RLG_ShadowMap *sm, int storage)
+{
+    rlgPutPooledShadowStorage(storage, sm->depth, sm->id);
+}
+
+static void rlgAcquireShadowMoments(struct RLG_ShadowMap *sm, int resolution)
+{
+    if (!rlgTakePooledShadowStorage(RLG_SHADOW_STORAGE_MOMENTS, resolution, &sm->moments, &sm->momentsId))
+    {
+        rlgLoadMomentsMap(&sm->moments, &sm->momentsId, resolution);
+    }
+}
+
+static void rlgReleaseShadowMoments(struct RLG_ShadowMap *sm)
+{
+    if (sm->momentsId == 0) return;
+
+    rlgPutPooledShadowStorage(RLG_SHADOW_STORAGE_MOMENTS, sm->moments, sm->momentsId);
+    sm->moments = (Texture2D){ 0 };
+    sm->momentsId = 0;
+}
+
+static size_t rlgGetShadowStorageSize(Texture2D texture, int storage)
+{
+    size_t texels = (size_t)texture.width*texture.height;
+
+    switch (storage)
+    {
+        case RLG_SHADOW_STORAGE_DEPTH_CUBE: return texels*RLG_SHADOW_DEPTH_BYTES*6;
+        case RLG_SHADOW_STORAGE_MOMENTS: return texels*RLG_SHADOW_MOMENTS_BYTES*4/3;   // Mip chain included
+        default: return texels*RLG_SHADOW_DEPTH_BYTES;
+    }
+}
+
 void RLG_EnableShadow(unsigned int light, int shadowMapResolution)
 {
     // Check if the specified light ID is within the valid range
@@ -1091,69 +1601,21 @@ void RLG_EnableShadow(unsigned int light, int shadowMapResolution)
     // Check if the current shadow map resolution is different from the desired resolution
     if (l->data.shadowMap.width != shadowMapResolution)
     {
-        // If the shadow map is already initialized, unload the existing texture and framebuffer
-        if (l->data.shadowMap.id != 0)
-        {
-            rlUnloadTexture(l->data.shadowMap.depth.id);
-            rlUnloadFramebuffer(l->data.shadowMap.id);
-        }
-
         // Get a pointer to the shadow map structure of the light
         struct RLG_ShadowMap *sm = &l->data.shadowMap;
+        int storage = rlgGetShadowStorage(l);
 
-        // If the light is an omnidirectional light, set up a cube map for shadows
-        if (l->data.type == RLG_OMNILIGHT)
-        {
-            glGenFramebuffers(1, &sm->id);
-            glGenTextures(1, &sm->depth.id);
-
-            glBindTexture(GL_TEXTURE_CUBE_MAP, sm->depth.id);
-            for (unsigned int i = 0; i < 6; ++i)
-            {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-                    shadowMapResolution, shadowMapResolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-            }
-
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-            glBindFramebuffer(GL_FRAMEBUFFER, sm->id);
-            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, sm->depth.id, 0);
-            glDrawBuffer(GL_NONE);
-            glReadBuffer(GL_NONE);
-
-            // Check if the framebuffer is complete
-            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            {
-                // Log an error if the framebuffer is not complete
-                TraceLog(LOG_ERROR, "Framebuffer is not complete for omnidirectional shadow map");
-            }
-
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // If the shadow map is already initialized, it goes back to the pool
+        if (sm->id != 0) rlgReleaseShadowMap(sm, storage);
 
-            // Configure the shadow map parameters
-            sm->depth.width = sm->depth.height = shadowMapResolution;
-            sm->width = sm->height = shadowMapResolution;
-            sm->depth.format = 19, sm->depth.mipmaps = 1;
-        }
-        else
-        {
-            // Set up a 2D texture for shadow map for other light types
-            sm->id = rlLoadFramebuffer(shadowMapResolution, shadowMapResolution);
-            sm->width = sm->height = shadowMapResolution;
-            rlEnableFramebuffer(sm->id);
+        // The moments are taken at the new resolution on the next update
+        rlgReleaseShadowMoments(sm);
 
-            sm->depth.id = rlLoadTextureDepth(shadowMapResolution, shadowMapResolution, false);
-            sm->depth.width = sm->depth.height = shadowMapResolution;
-            sm->depth.format = 19, sm->depth.mipmaps = 1;
+        sm->emptyFaces = 0;
+        sm->dirtyFaces = 0x3F;
 
-            rlTextureParameters(sm->depth.id, RL_TEXTURE_WRAP_S, RL_TEXTURE_WRAP_CLAMP);
-            rlTextureParameters(sm->depth.id, RL_TEXTURE_WRAP_T, RL_TEXTURE_WRAP_CLAMP);
-            rlFramebufferAttach(sm->id, sm->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
-        }
+        // Take a shadow map of this kind from the pool, or load one if there is none
+        rlgAcquireShadowMap(sm, storage, shadowMapResolution);
 
         // REVIEW: Should this value be modifiable by the user?
         float texelSize = 1.0f/shadowMapResolution;
@@ -1166,10 +1628,12 @@ void RLG_EnableShadow(unsigned int light, int shadowMapResolution)
             &l->data.depthBias, SHADER_UNIFORM_FLOAT);
     }
 
-    // Enable shadows for the light and send the information to the shader
+    // Enable shadows for the light and send the information to the shader,
+    // unless the light is beyond its shadow fade distance
     l->data.shadow = true;
+    int shadow = !l->data.shadowFadedOut;
     SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.shadow,
-        &l->data.shadow, SHADER_UNIFORM_INT);
+        &shadow, SHADER_UNIFORM_INT);
 }
 
 void RLG_DisableShadow(unsigned int light)
@@ -1184,9 +1648,9 @@ void RLG_DisableShadow(unsigned int light)
 
     if (l->data.shadow)
     {
-        // Unload depth texture and framebuffer
-        rlUnloadTexture(l->data.shadowMap.depth.id);
-        rlUnloadFramebuffer(l->data.shadowMap.id);
+        // The depth texture, the framebuffer and the moments go back to the pool
+        rlgReleaseShadowMap(&l->data.shadowMap, rlgGetShadowStorage(l));
+        rlgReleaseShadowMoments(&l->data.shadowMap);
 
         // Fill shadow map struct with zeroes
         l->data.shadowMap = (struct RLG_ShadowMap){0};
@@ -1235,1063 +1699,6160 @@ float RLG_GetShadowBias(unsigned int light)
     return rlgCtx->lights[light].data.depthBias;
 }
 
-void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc)
+void RLG_SetShadowResolutionRange(unsigned int light, int min, int max)
 {
-    // Directions and up vectors for the 6 faces of the cubemap
-    static const Vector3 dirs[6] = {
-        {  1.0,  0.0,  0.0 }, // +X
-        { -1.0,  0.0,  0.0 }, // -X
-        {  0.0,  1.0,  0.0 }, // +Y
-        {  0.0, -1.0,  0.0 }, // -Y
-        {  0.0,  0.0,  1.0 }, // +Z
-        {  0.0,  0.0, -1.0 }  // -Z
-    };
+    if (light >= rlgCtx->lightCount)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetShadowResolutionRange' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return;
+    }
 
-    static const Vector3 ups[6] = {
-        {  0.0, -1.0,  0.0 }, // +X
-        {  0.0, -1.0,  0.0 }, // -X
-        {  0.0,  0.0,  1.0 }, // +Y
-        {  0.0,  0.0, -1.0 }, // -Y
-        {  0.0, -1.0,  0.0 }, // +Z
-        {  0.0, -1.0,  0.0 }  // -Z
-    };
+    struct RLG_Light *l = &rlgCtx->lights[light];
 
-    // Safety checks
-    if (!drawFunc)
+    if (max <= 0)
     {
-        // Log an error if the draw function pointer is NULL
-        TraceLog(LOG_ERROR, "The drawing function pointer specified to 'RLG_UpdateShadowMap' is NULL");
-        return;  
+        l->data.shadowMinResolution = l->data.shadowMaxResolution = 0;
+        return;
     }
 
+    // Round the bounds to powers of two
+    int pMin = 1, pMax = 1;
+    while (pMin < min) pMin *= 2;
+    while (pMax < max) pMax *= 2;
+
+    l->data.shadowMinResolution = (pMin < pMax) ? pMin : pMax;
+    l->data.shadowMaxResolution = pMax;
+}
+
+void RLG_SetShadowFade(unsigned int light, float start, float end)
+{
     if (light >= rlgCtx->lightCount)
     {
-        // Log an error if the light ID exceeds the number of allocated lights
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_UpdateShadowMap' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetShadowFade' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
         return;
     }
 
-    // Get a pointer to the specified light structure
     struct RLG_Light *l = &rlgCtx->lights[light];
-    if (!l->data.shadow)
-    {
-        TraceLog(LOG_ERROR, "Light [ID %i] does not support shadow casting", light);
-        return;
-    }
 
-    // Flush the rendering batch and enable the shadow map framebuffer
-    rlDrawRenderBatchActive();
-    rlEnableFramebuffer(l->data.shadowMap.id);
+    if (end <= 0.0f) start = end = 0.0f;
+    if (start > end) start = end;
 
-    // Configure the projection for the shadow map
-    rlViewport(0, 0, l->data.shadowMap.width, l->data.shadowMap.height);
-    rlMatrixMode(RL_PROJECTION);
-    rlPushMatrix();
-    rlLoadIdentity();
+    l->data.shadowFadeStart = start;
+    l->data.shadowFadeEnd = end;
 
-    // Near and far clipping planes for shadow map rendering
-    rlgCtx->zNear = 0.01f;      // TODO: replace with rlGetCullDistanceNear()
-    rlgCtx->zFar = 1000.0f;     // TODO: replace with rlGetCullDistanceFar()
+    rlgUpdateShadowFade(l);
+}
 
-    // Set up projection matrix based on the light type
-    switch (l->data.type)
+void RLG_GetShadowFade(unsigned int light, float* start, float* end)
+{
+    if (light >= rlgCtx->lightCount)
     {
-        case RLG_DIRLIGHT:
-        case RLG_SPOTLIGHT:
-            // Orthographic projection for directional and spotlight
-            rlOrtho(-10.0, 10.0, -10.0, 10.0, rlgCtx->zNear, rlgCtx->zFar);
-            break;
-
-        case RLG_OMNILIGHT:
-            // Perspective projection for omnidirectional light
-            rlMultMatrixf(MatrixToFloat(MatrixPerspective(90*DEG2RAD, 1.0, rlgCtx->zNear, rlgCtx->zFar)));
-            break;
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowFade' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return;
     }
 
-    // Switch to modelview matrix mode
-    rlMatrixMode(RL_MODELVIEW);
-
-    // Enable depth test and disable color blending
-    rlEnableDepthTest();
-    rlDisableColorBlend();
+    if (start) *start = rlgCtx->lights[light].data.shadowFadeStart;
+    if (end) *end = rlgCtx->lights[light].data.shadowFadeEnd;
+}
 
-    // Select the appropriate depth shader
-    Shader shader = { 0 };
-    if (l->data.type == RLG_OMNILIGHT)
+bool RLG_IsShadowFadedOut(unsigned int light)
+{
+    if (light >= rlgCtx->lightCount)
     {
-        shader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP];
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_IsShadowFadedOut' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return false;
+    }
 
-        // Send the light position to the depth shader
-        SetShaderValue(shader, rlgCtx->locDepthCubemapLightPos,
-            &l->data.position, SHADER_UNIFORM_VEC3);
+    return rlgCtx->lights[light].data.shadowFadedOut;
+}
 
-        // Send zFar to the depth shader to scale depth from [0..zFar] to [0..1]
-        SetShaderValue(shader, rlgCtx->locDepthCubemapFar,
-            &rlgCtx->zFar, SHADER_UNIFORM_FLOAT);
+size_t RLG_GetShadowMemoryUsage(void)
+{
+    size_t size = 0;
 
-        // Send zFar to the lighting shader to scale depth from [0..1] to [0..zFar]
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING],
-            rlgCtx->locLightingFar, &rlgCtx->zFar,
-            SHADER_UNIFORM_FLOAT);
-    }
-    else
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
     {
-        shader = rlgCtx->shaders[RLG_SHADER_DEPTH];
-    }
+        const struct RLG_Light *l = &rlgCtx->lights[i];
 
-    // Determine the number of iterations for omnidirectional light
-    int iterationCount = (l->data.type == RLG_OMNILIGHT) ? 6 : 1;
-    for (int i = 0; i < iterationCount; i++)
-    {
-        // Configure the ModelView matrix
-        Matrix matView = { 0 };
-        if (l->data.type == RLG_OMNILIGHT)
+        if (l->data.shadowMap.id != 0)
         {
-            // Attach the depth texture of the i-th face
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                l->data.shadowMap.depth.id, 0);
-
-            // Calculate the view matrix
-            matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, dirs[i]), ups[i]);
+            size += rlgGetShadowStorageSize(l->data.shadowMap.depth, rlgGetShadowStorage(l));
         }
-        else
-        {
-            // Calculate the view matrix for directional and spotlight
-            matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, l->data.direction), (Vector3){ 0, 1, 0});
 
-            // Calculate and send the view-projection matrix to the lighting shader for later rendering
-            Matrix viewProj = MatrixMultiply(matView, rlGetMatrixProjection());
-            SetShaderValueMatrix(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.vpMatrix, viewProj);
+        if (l->data.shadowMap.momentsId != 0)
+        {
+            size += rlgGetShadowStorageSize(l->data.shadowMap.moments, RLG_SHADOW_STORAGE_MOMENTS);
         }
+    }
 
-        // Apply the view matrix for rendering into the depth texture
-        rlLoadIdentity();
-        rlMultMatrixf(MatrixToFloat(matView));
-
-        // Clear the previous state of the depth texture
-        rlClearScreenBuffers();
-
-        // Render objects in the light's context
-        drawFunc(shader);
-
-        // Flush the rendering batch
-        rlDrawRenderBatchActive();
+    for (unsigned int i = 0; i < rlgCtx->shadowPoolCount; i++)
+    {
+        size += rlgGetShadowStorageSize(rlgCtx->shadowPool[i].texture, rlgCtx->shadowPool[i].storage);
     }
 
-    // End rendering
-    rlEnableColorBlend();
-    rlDisableFramebuffer();
+    // Depth pre-pass (always 32 bits) and RGBA8 shadow mask
+    size += (size_t)rlgCtx->shadowMask.depth.width*rlgCtx->shadowMask.depth.height*4;
+    size += (size_t)rlgCtx->shadowMask.mask.width*rlgCtx->shadowMask.mask.height*4;
 
-    // Reset the viewport and projection matrix to the screen settings
-    rlViewport(0, 0, GetScreenWidth(), GetScreenHeight());
-    rlMatrixMode(RL_PROJECTION);
-    rlPopMatrix();
-    rlMatrixMode(RL_MODELVIEW);
-    rlLoadIdentity();
+    return size;
 }
 
-Texture RLG_GetShadowMap(unsigned int light)
+void RLG_TrimShadowPool(size_t maxMemory)
 {
-    if (light >= rlgCtx->lightCount)
+    size_t size = 0;
+    for (unsigned int i = 0; i < rlgCtx->shadowPoolCount; i++)
     {
-        // Log an error if the light ID exceeds the number of allocated lights
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowMap' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
-        return (Texture){0};
+        size += rlgGetShadowStorageSize(rlgCtx->shadowPool[i].texture, rlgCtx->shadowPool[i].storage);
     }
 
-    return rlgCtx->lights[light].data.shadowMap.depth;
-}
+    // Free the least recently released entries first
+    unsigned int count = 0;
+    while (count < rlgCtx->shadowPoolCount && size > maxMemory)
+    {
+        struct RLG_PooledShadowMap *pooled = &rlgCtx->shadowPool[count++];
+        size -= rlgGetShadowStorageSize(pooled->texture, pooled->storage);
 
-void RLG_CastMesh(Shader shader, Mesh mesh, Matrix transform)
-{
-    // Bind shader program
-    rlEnableShader(shader.id);
+        rlUnloadTexture(pooled->texture.id);
+        rlUnloadFramebuffer(pooled->id);
+    }
 
-    // Get a copy of current matrices to work with,
-    // just in case stereo render is required, and we need to modify them
-    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
-    // That's because BeginMode3D() sets it and there is no model-drawing function
-    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
-    Matrix matModel = MatrixIdentity();
-    Matrix matView = rlGetMatrixModelview();
-    Matrix matModelView = MatrixIdentity();
-    Matrix matProjection = rlGetMatrixProjection();
+    rlgCtx->shadowPoolCount -= count;
+    memmove(rlgCtx->shadowPool, rlgCtx->shadowPool + count,
+        rlgCtx->shadowPoolCount*sizeof(struct RLG_PooledShadowMap));
+}
 
-    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
-    if (shader.locs[RLG_LOC_MATRIX_MODEL] != -1)
-        rlSetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MODEL], transform);
+RLG_ShadowPoolStats RLG_GetShadowPoolStats(void)
+{
+    RLG_ShadowPoolStats stats = { 0 };
+    stats.count = rlgCtx->shadowPoolCount;
+    stats.reused = rlgCtx->shadowPoolReused;
+    stats.loaded = rlgCtx->shadowPoolLoaded;
 
-    // Accumulate several model transformations:
-    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
-    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
-    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+    for (unsigned int i = 0; i < rlgCtx->shadowPoolCount; i++)
+    {
+        stats.memory += rlgGetShadowStorageSize(rlgCtx->shadowPool[i].texture, rlgCtx->shadowPool[i].storage);
+    }
 
-    // Get model-view matrix
-    matModelView = MatrixMultiply(matModel, matView);
+    return stats;
+}
 
-    // Try binding vertex array objects (VAO) or use VBOs if not possible
-    if (!rlEnableVertexArray(mesh.vaoId))
+/* Shadow casting helpers */
+
+// Directions and up vectors for the 6 faces of the cubemap
+static const Vector3 rlgCubemapDirs[6] = {
+    {  1.0,  0.0,  0.0 }, // +X
+    { -1.0,  0.0,  0.0 }, // -X
+    {  0.0,  1.0,  0.0 }, // +Y
+    {  0.0, -1.0,  0.0 }, // -Y
+    {  0.0,  0.0,  1.0 }, // +Z
+    {  0.0,  0.0, -1.0 }  // -Z
+};
+
+static const Vector3 rlgCubemapUps[6] = {
+    {  0.0, -1.0,  0.0 }, // +X
+    {  0.0, -1.0,  0.0 }, // -X
+    {  0.0,  0.0,  1.0 }, // +Y
+    {  0.0,  0.0, -1.0 }, // -Y
+    {  0.0, -1.0,  0.0 }, // +Z
+    {  0.0, -1.0,  0.0 }  // -Z
+};
+
+static struct RLG_Frustum rlgGetFrustum(Matrix viewProj)
+{
+    struct RLG_Frustum frustum = { 0 };
+    const Matrix m = viewProj;
+
+    // Extract the clipping planes from the rows of the view-projection matrix (Gribb/Hartmann)
+    frustum.planes[0] = (Vector4){ m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8, m.m15 + m.m12 };     // Left
+    frustum.planes[1] = (Vector4){ m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8, m.m15 - m.m12 };     // Right
+    frustum.planes[2] = (Vector4){ m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9, m.m15 + m.m13 };     // Bottom
+    frustum.planes[3] = (Vector4){ m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9, m.m15 - m.m13 };     // Top
+    frustum.planes[4] = (Vector4){ m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14 };    // Near
+    frustum.planes[5] = (Vector4){ m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14 };    // Far
+
+    for (int i = 0; i < 6; i++)
     {
-        // Bind mesh VBO data: vertex position (shader-location = 0)
-        rlEnableVertexBuffer(mesh.vboId[0]);
-        rlSetVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION]);
-
-        // If vertex indices exist, bine the VBO containing the indices
-        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+        Vector4 *p = &frustum.planes[i];
+        float len = sqrtf(p->x*p->x + p->y*p->y + p->z*p->z);
+        if (len > 0.0f) *p = (Vector4){ p->x/len, p->y/len, p->z/len, p->w/len };
     }
 
-    int eyeCount = rlIsStereoRenderEnabled() ? 2 : 1;
+    return frustum;
+}
 
-    for (int eye = 0; eye < eyeCount; eye++)
+static bool rlgFrustumHasBox(const struct RLG_Frustum *frustum, BoundingBox box)
+{
+    for (int i = 0; i < 6; i++)
     {
-        // Calculate model-view-projection matrix (MVP)
-        Matrix matModelViewProjection = MatrixIdentity();
-        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
-        else
-        {
-            // Setup current eye viewport (half screen width)
-            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
-            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
-        }
+        const Vector4 *p = &frustum->planes[i];
 
-        // Send combined model-view-projection matrix to shader
-        rlSetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+        // Test the corner of the box which is the furthest along the plane normal
+        float x = (p->x >= 0.0f) ? box.max.x : box.min.x;
+        float y = (p->y >= 0.0f) ? box.max.y : box.min.y;
+        float z = (p->z >= 0.0f) ? box.max.z : box.min.z;
 
-        // Draw mesh
-        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
-        else rlDrawVertexArray(0, mesh.vertexCount);
+        if (p->x*x + p->y*y + p->z*z + p->w < 0.0f) return false;
     }
 
-    // Disable all possible vertex array objects (or VBOs)
-    rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
+    return true;
+}
 
-    // Disable shader program
-    rlDisableShader();
+static BoundingBox rlgTransformBoundingBox(BoundingBox box, Matrix transform)
+{
+    const Matrix m = transform;
 
-    // Restore rlgl internal modelview and projection matrices
-    rlSetMatrixModelview(matView);
-    rlSetMatrixProjection(matProjection);
+    Vector3 center = Vector3Scale(Vector3Add(box.min, box.max), 0.5f);
+    Vector3 extents = Vector3Scale(Vector3Subtract(box.max, box.min), 0.5f);
+
+    // Transform the center and project the extents onto the world axes (Arvo)
+    center = Vector3Transform(center, m);
+    extents = (Vector3) {
+        fabsf(m.m0)*extents.x + fabsf(m.m4)*extents.y + fabsf(m.m8)*extents.z,
+        fabsf(m.m1)*extents.x + fabsf(m.m5)*extents.y + fabsf(m.m9)*extents.z,
+        fabsf(m.m2)*extents.x + fabsf(m.m6)*extents.y + fabsf(m.m10)*extents.z
+    };
+
+    return (BoundingBox) { Vector3Subtract(center, extents), Vector3Add(center, extents) };
 }
 
-void RLG_CastModel(Shader shader, Model model, Vector3 position, float scale)
+static bool rlgReadsPositionOnly(Shader shader)
 {
-    Vector3 vScale = { scale, scale, scale };
-    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+    // Shaders reading any other vertex attribute need the vertex array of the mesh
+    for (int i = RLG_LOC_VERTEX_TEXCOORD01; i <= RLG_LOC_VERTEX_COLOR; i++)
+    {
+        if (shader.locs[i] != -1) return false;
+    }
 
-    RLG_CastModelEx(shader, model, position, rotationAxis, 0.0f, vScale);
+    return true;
 }
 
-void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale)
+static unsigned int rlgFindPositionStream(unsigned int meshVboId)
 {
-    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
-    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
-    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+    // Binary search of the first stream whose mesh buffer is not below the given one
+    unsigned int lo = 0, hi = rlgCtx->positionStreams.count;
 
-    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-    model.transform = MatrixMultiply(model.transform, matTransform);
-
-    for (int i = 0; i < model.meshCount; i++)
+    while (lo < hi)
     {
-        RLG_CastMesh(shader, model.meshes[i], model.transform);
+        unsigned int mid = (lo + hi)/2;
+        if (rlgCtx->positionStreams.streams[mid].meshVboId < meshVboId) lo = mid + 1;
+        else hi = mid;
     }
+
+    return lo;
 }
 
-void RLG_DrawMesh(Mesh mesh, Material material, Matrix transform)
+static void rlgSetPositionAttribute(const struct RLG_PositionStream *stream, int location, Mesh mesh)
 {
-    const Shader *shader = &rlgCtx->shaders[RLG_SHADER_LIGHTING];
+    rlEnableVertexBuffer(stream->vboId);
 
-    // Bind shader program
-    rlEnableShader(shader->id);
+    // Quantized positions are normalized, they are read in [0, 1] by the shader
+    if (stream->quantized) rlSetVertexAttribute(location, 3, GL_UNSIGNED_SHORT, true, 4*sizeof(unsigned short), 0);
+    else rlSetVertexAttribute(location, 3, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(location);
 
-    // Send required data to shader (matrices, values)
-    //-----------------------------------------------------
-    // Upload to shader material.data.colDiffuse
-    if (shader->locs[RLG_LOC_COLOR_DIFFUSE] != -1)
+    if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+}
+
+static void rlgUnloadPositionStream(struct RLG_PositionStream *stream)
+{
+    if (stream->vaoId > 0) rlUnloadVertexArray(stream->vaoId);
+    if (stream->quantized) rlUnloadVertexBuffer(stream->vboId);
+}
+
+static const struct RLG_PositionStream *rlgGetPositionStream(Mesh mesh)
+{
+    // The stream is built from the CPU copy of the vertices, which animated meshes do not match
+    if (mesh.vboId == NULL || mesh.vboId[0] == 0 || mesh.vertices == NULL) return NULL;
+    if (mesh.animVertices != NULL) return NULL;
+
+    unsigned int index = rlgFindPositionStream(mesh.vboId[0]);
+    struct RLG_PositionStream *streams = rlgCtx->positionStreams.streams;
+
+    if (index < rlgCtx->positionStreams.count && streams[index].meshVboId == mesh.vboId[0])
     {
-        float values[4];
+        if (streams[index].vertexCount == mesh.vertexCount) return &streams[index];
 
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_ALBEDO])
-        {
-            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.r/255.0f;
-            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.g/255.0f;
-            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.b/255.0f;
-            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.a/255.0f;
-        }
-        else
+        // The buffer belongs to another mesh now, the stream is rebuilt
+        rlgUnloadPositionStream(&streams[index]);
+        rlgCtx->positionStreams.count--;
+        memmove(&streams[index], &streams[index + 1],
+            (rlgCtx->positionStreams.count - index)*sizeof(struct RLG_PositionStream));
+    }
+
+    // Grow the stream array if it is full
+    if (rlgCtx->positionStreams.count == rlgCtx->positionStreams.capacity)
+    {
+        unsigned int capacity = (rlgCtx->positionStreams.capacity == 0) ? 16 : 2*rlgCtx->positionStreams.capacity;
+        streams = (struct RLG_PositionStream*)realloc(streams, capacity*sizeof(struct RLG_PositionStream));
+
+        if (!streams)
         {
-            values[0] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.r/255.0f;
-            values[1] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.g/255.0f;
-            values[2] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.b/255.0f;
-            values[3] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.a/255.0f;
+            TraceLog(LOG_ERROR, "Heap allocation for position streams failed!");
+            return NULL;
         }
 
-        rlSetUniform(shader->locs[RLG_LOC_COLOR_DIFFUSE], values, SHADER_UNIFORM_VEC4, 1);
+        rlgCtx->positionStreams.streams = streams;
+        rlgCtx->positionStreams.capacity = capacity;
     }
 
-    // Upload to shader material.data.colSpecular (if location available)
-    if (shader->locs[RLG_LOC_COLOR_SPECULAR] != -1)
-    {
-        float values[4];
+    struct RLG_PositionStream stream = { 0 };
+    stream.meshVboId = mesh.vboId[0];
+    stream.vboId = mesh.vboId[0];
+    stream.vertexCount = mesh.vertexCount;
+    stream.dequantize = MatrixIdentity();
+    stream.quantized = rlgCtx->positionStreams.quantized;
 
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_METALNESS])
+    if (stream.quantized)
+    {
+        // Positions are stored relative to the bounds of the mesh, padded to 8 bytes per vertex
+        BoundingBox bounds = GetMeshBoundingBox(mesh);
+        Vector3 extent = Vector3Subtract(bounds.max, bounds.min);
+        if (extent.x <= 0.0f) extent.x = 1.0f;
+        if (extent.y <= 0.0f) extent.y = 1.0f;
+        if (extent.z <= 0.0f) extent.z = 1.0f;
+
+        unsigned short *positions = (unsigned short*)malloc(mesh.vertexCount*4*sizeof(unsigned short));
+        if (!positions)
         {
-            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.r/255.0f;
-            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.g/255.0f;
-            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.b/255.0f;
-            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.a/255.0f;
+            TraceLog(LOG_ERROR, "Heap allocation for position streams failed!");
+            return NULL;
         }
-        else
+
+        for (int i = 0; i < mesh.vertexCount; i++)
         {
-            values[0] = (float)material.maps[MATERIAL_MAP_METALNESS].color.r/255.0f;
-            values[1] = (float)material.maps[MATERIAL_MAP_METALNESS].color.g/255.0f;
-            values[2] = (float)material.maps[MATERIAL_MAP_METALNESS].color.b/255.0f;
-            values[3] = (float)material.maps[MATERIAL_MAP_METALNESS].color.a/255.0f;
+            const float *v = &mesh.vertices[3*i];
+            positions[4*i + 0] = (unsigned short)((v[0] - bounds.min.x)/extent.x*65535.0f + 0.5f);
+            positions[4*i + 1] = (unsigned short)((v[1] - bounds.min.y)/extent.y*65535.0f + 0.5f);
+            positions[4*i + 2] = (unsigned short)((v[2] - bounds.min.z)/extent.z*65535.0f + 0.5f);
+            positions[4*i + 3] = 0;
         }
 
-        rlSetUniform(shader->locs[RLG_LOC_COLOR_SPECULAR], values, SHADER_UNIFORM_VEC4, 1);
+        stream.vboId = rlLoadVertexBuffer(positions, mesh.vertexCount*4*sizeof(unsigned short), false);
+        free(positions);
+
+        stream.dequantize = MatrixMultiply(MatrixScale(extent.x, extent.y, extent.z),
+            MatrixTranslate(bounds.min.x, bounds.min.y, bounds.min.z));
     }
 
-    // Upload to shader material.data.colEmission (if location available)
-    if (shader->locs[RLG_LOC_COLOR_EMISSION] != -1)
+    // The vertex array only enables the position attribute, at its default location
+    stream.vaoId = rlLoadVertexArray();
+    if (rlEnableVertexArray(stream.vaoId))
     {
-        float values[4];
+        rlgSetPositionAttribute(&stream, 0, mesh);
+        rlDisableVertexArray();
+    }
 
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_EMISSION])
-        {
-            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.r/255.0f;
-            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.g/255.0f;
-            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.b/255.0f;
-            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.a/255.0f;
-        }
-        else
-        {
-            values[0] = (float)material.maps[MATERIAL_MAP_EMISSION].color.r/255.0f;
-            values[1] = (float)material.maps[MATERIAL_MAP_EMISSION].color.g/255.0f;
-            values[2] = (float)material.maps[MATERIAL_MAP_EMISSION].color.b/255.0f;
-            values[3] = (float)material.maps[MATERIAL_MAP_EMISSION].color.a/255.0f;
-        }
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
 
-        rlSetUniform(shader->locs[RLG_LOC_COLOR_EMISSION], values, SHADER_UNIFORM_VEC4, 1);
+    // Insert the stream so that the array remains sorted
+    memmove(&streams[index + 1], &streams[index],
+        (rlgCtx->positionStreams.count - index)*sizeof(struct RLG_PositionStream));
+    streams[index] = stream;
+    rlgCtx->positionStreams.count++;
+
+    return &streams[index];
+}
+
+// Binds the vertex data of a mesh read by a shader, returns the transform
+// to apply before the one of the mesh (not identity for quantized positions)
+static Matrix rlgEnableCastVertexArray(Shader shader, Mesh mesh)
+{
+    // NOTE: The depth pre-pass must give the exact depth of the lighting pass, so it does not
+    // use quantized positions which are transformed by a different matrix
+    bool quantized = rlgCtx->positionStreams.quantized;
+    const struct RLG_PositionStream *stream = NULL;
+
+    if (rlgCtx->positionStreams.active && !(quantized && rlgCtx->depthPrepass.drawing) &&
+        rlgReadsPositionOnly(shader))
+    {
+        stream = rlgGetPositionStream(mesh);
     }
 
-    // Upload to shader material.data.metalness (if location available)
-    if (shader->locs[RLG_LOC_METALNESS_SCALE] != -1)
+    if (stream != NULL)
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_METALNESS])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_METALNESS_SCALE],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-        else
+        if (!rlEnableVertexArray(stream->vaoId))
         {
-            rlSetUniform(shader->locs[RLG_LOC_METALNESS_SCALE],
-                &material.maps[MATERIAL_MAP_METALNESS].value, SHADER_UNIFORM_FLOAT, 1);
+            rlgSetPositionAttribute(stream, shader.locs[RLG_LOC_VERTEX_POSITION], mesh);
         }
+
+        return stream->dequantize;
     }
 
-    // Upload to shader material.data.roughness (if location available)
-    if (shader->locs[RLG_LOC_ROUGHNESS_SCALE] != -1)
+    // Try binding vertex array objects (VAO) or use VBOs if not possible
+    if (!rlEnableVertexArray(mesh.vaoId))
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_ROUGHNESS])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_ROUGHNESS_SCALE],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-        else
-        {
-            rlSetUniform(shader->locs[RLG_LOC_ROUGHNESS_SCALE],
-                &material.maps[MATERIAL_MAP_ROUGHNESS].value, SHADER_UNIFORM_FLOAT, 1);
-        }
+        // Bind mesh VBO data: vertex position (shader-location = 0)
+        rlEnableVertexBuffer(mesh.vboId[0]);
+        rlSetVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION]);
+
+        // If vertex indices exist, bine the VBO containing the indices
+        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
     }
 
-    // Upload to shader material.data.aoLightAffect (if location available)
-    if (shader->locs[RLG_LOC_AO_LIGHT_AFFECT] != -1)
+    return MatrixIdentity();
+}
+
+static void rlgCastShadowCasters(Shader shader, unsigned int face)
+{
+    for (unsigned int i = 0; i < rlgCtx->casterCapacity; i++)
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_OCCLUSION])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_AO_LIGHT_AFFECT],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-        else
+        const struct RLG_ShadowCaster *caster = &rlgCtx->casters[i];
+
+        if (caster->used && (caster->faceMask & (1u << face)))
         {
-            rlSetUniform(shader->locs[RLG_LOC_AO_LIGHT_AFFECT],
-                &material.maps[MATERIAL_MAP_OCCLUSION].value, SHADER_UNIFORM_FLOAT, 1);
+            for (int j = 0; j < caster->model.meshCount; j++)
+            {
+                RLG_CastMesh(shader, caster->model.meshes[j], caster->transform);
+            }
         }
     }
+}
 
-    // Upload to shader material.data.heightScale (if location available)
-    if (shader->locs[RLG_LOC_HEIGHT_SCALE] != -1)
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+
+static bool rlgIsExtensionSupported(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; i++)
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_HEIGHT])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_HEIGHT_SCALE],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].value, SHADER_UNIFORM_FLOAT, 1);
+        if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0) return true;
+    }
+
+    return false;
+}
+
+static struct RLG_LayeredShader rlgLoadLayeredShader(const char *vsCode, const char *gsCode, const char *fsCode, const char *routingName)
+{
+    struct RLG_LayeredShader ls = { 0 };
+
+    unsigned int vsId = rlCompileShader(vsCode, GL_VERTEX_SHADER);
+    unsigned int gsId = (gsCode != NULL) ? rlCompileShader(gsCode, GL_GEOMETRY_SHADER) : 0;
+    unsigned int fsId = rlCompileShader(fsCode, GL_FRAGMENT_SHADER);
+
+    // NOTE: rlgl can only link vertex/fragment pairs, so the program is linked here
+    unsigned int id = glCreateProgram();
+    glAttachShader(id, vsId);
+    if (gsId != 0) glAttachShader(id, gsId);
+    glAttachShader(id, fsId);
+
+    glBindAttribLocation(id, 0, RLG_SHADER_LIGHTING_ATTRIB_POSITION);
+    glLinkProgram(id);
+
+    glDeleteShader(vsId);
+    if (gsId != 0) glDeleteShader(gsId);
+    glDeleteShader(fsId);
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+
+    if (success == GL_FALSE)
+    {
+        TraceLog(LOG_WARNING, "SHADER: [ID %i] Failed to link layered depth shader program", id);
+        glDeleteProgram(id);
+        return ls;
+    }
+
+    // Only the locations used by RLG_CastMesh are retrieved, the others are set to -1
+    ls.shader.id = id;
+    ls.shader.locs = (int*)malloc(RLG_COUNT_LOCS*sizeof(int));
+    for (int i = 0; i < RLG_COUNT_LOCS; i++) ls.shader.locs[i] = -1;
+
+    ls.shader.locs[RLG_LOC_VERTEX_POSITION] = 0;
+    ls.shader.locs[RLG_LOC_MATRIX_MODEL] = rlGetLocationUniform(id, RLG_SHADER_LIGHTING_UNIFORM_MATRIX_MODEL);
+
+    ls.locFaces = rlGetLocationUniform(id, "matFaces");
+    ls.locRouting = rlGetLocationUniform(id, routingName);
+
+    return ls;
+}
+
+static void rlgLoadLayeredShaders(void)
+{
+    rlgCtx->layered.geometry = rlgLoadLayeredShader(rlgDepthLayeredVS,
+        rlgDepthLayeredGS, rlgDepthFS, "faceMask");
+
+    // Routing by instance avoids the geometry shader stage, but writing gl_Layer
+    // from the vertex shader is only possible with this extension
+    if (rlgIsExtensionSupported("GL_ARB_shader_viewport_layer_array"))
+    {
+        rlgCtx->layered.instanced = rlgLoadLayeredShader(rlgDepthLayeredInstancedVS,
+            NULL, rlgDepthFS, "faceIndices");
+    }
+}
+
+static void rlgCastMeshLayered(const struct RLG_LayeredShader *ls, Mesh mesh, Matrix transform, unsigned int faceMask)
+{
+    rlEnableShader(ls->shader.id);
+
+    // Bind the vertex data, the position stream may need its own transform
+    transform = MatrixMultiply(rlgEnableCastVertexArray(ls->shader, mesh), transform);
+
+    // NOTE: The face matrices already contain the view and the projection
+    Matrix matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+    rlSetUniformMatrix(ls->shader.locs[RLG_LOC_MATRIX_MODEL], matModel);
+
+    // Send the faces to render, either as a mask or as one face index per instance
+    int instanceCount = 1;
+    if (ls == &rlgCtx->layered.instanced)
+    {
+        int faces[6] = { 0 };
+        instanceCount = 0;
+
+        for (int i = 0; i < 6; i++)
+        {
+            if (faceMask & (1u << i)) faces[instanceCount++] = i;
+        }
+
+        rlSetUniform(ls->locRouting, faces, RL_SHADER_UNIFORM_INT, instanceCount);
+    }
+    else
+    {
+        int mask = (int)faceMask;
+        rlSetUniform(ls->locRouting, &mask, RL_SHADER_UNIFORM_INT, 1);
+    }
+
+    // Draw the mesh once for all the faces
+    if (mesh.indices != NULL) rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount*3, 0, instanceCount);
+    else rlDrawVertexArrayInstanced(0, mesh.vertexCount, instanceCount);
+
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+
+    rlDisableShader();
+}
+
+static void rlgRenderShadowCubemapLayered(struct RLG_Light *l, RLG_DrawFunc drawFunc, const Matrix *matViews, Matrix matProj, unsigned int usedFaces)
+{
+    struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+    // Registered casters are drawn with the instanced path when it is available
+    struct RLG_LayeredShader *gsShader = &rlgCtx->layered.geometry;
+    struct RLG_LayeredShader *casterShader = (rlgCtx->layered.instanced.shader.id > 0)
+        ? &rlgCtx->layered.instanced : gsShader;
+
+    float matFaces[6*16] = { 0 };
+    for (int i = 0; i < 6; i++)
+    {
+        Matrix viewProj = MatrixMultiply(matViews[i], matProj);
+        memcpy(&matFaces[16*i], MatrixToFloat(viewProj), 16*sizeof(float));
+    }
+
+    // Send the per-face matrices to the layered shaders
+    struct RLG_LayeredShader *shaders[2] = { gsShader, casterShader };
+    for (int i = 0; i < ((casterShader != gsShader) ? 2 : 1); i++)
+    {
+        rlEnableShader(shaders[i]->shader.id);
+        glUniformMatrix4fv(shaders[i]->locFaces, 6, GL_FALSE, matFaces);
+    }
+    rlDisableShader();
+
+    // Attach all the faces of the cubemap at once and clear them
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, sm->depth.id, 0);
+    rlLoadIdentity();
+    rlClearScreenBuffers();
+
+    // The draw function can only be routed by the geometry shader,
+    // each of its triangles is sent to all the faces
+    if (drawFunc != NULL)
+    {
+        int mask = 0x3F;
+        rlEnableShader(gsShader->shader.id);
+        rlSetUniform(gsShader->locRouting, &mask, RL_SHADER_UNIFORM_INT, 1);
+        rlDisableShader();
+
+        drawFunc(gsShader->shader);
+    }
+
+    // Each registered caster is submitted once, only to the faces it overlaps
+    for (unsigned int i = 0; i < rlgCtx->casterCapacity; i++)
+    {
+        const struct RLG_ShadowCaster *caster = &rlgCtx->casters[i];
+
+        if (caster->used && caster->faceMask != 0)
+        {
+            for (int j = 0; j < caster->model.meshCount; j++)
+            {
+                rlgCastMeshLayered(casterShader, caster->model.meshes[j], caster->transform, caster->faceMask);
+            }
+        }
+    }
+
+    rlDrawRenderBatchActive();
+
+    // All the faces have been cleared, those without casters are now empty
+    sm->emptyFaces = (drawFunc != NULL) ? 0 : (~usedFaces & 0x3F);
+}
+
+static void rlgLoadParaboloidShader(void)
+{
+    struct RLG_ParaboloidShadows *ps = &rlgCtx->paraboloid;
+
+    ps->shader = LoadShaderFromMemory(rlgDepthParaboloidVS, rlgDepthFS);
+
+    // NOTE: raylib falls back to its default shader when the compilation fails
+    if (ps->shader.id == rlGetShaderIdDefault())
+    {
+        ps->shader = (Shader){ 0 };
+        return;
+    }
+
+    ps->locLightPos = rlGetLocationUniform(ps->shader.id, "lightPos");
+    ps->locHemisphere = rlGetLocationUniform(ps->shader.id, "hemisphere");
+    ps->locDepthParams = rlGetLocationUniform(ps->shader.id, "depthParams");
+}
+
+static void rlgLoadMomentsShaders(void)
+{
+    struct RLG_MomentsShadows *ms = &rlgCtx->moments;
+
+    ms->depth = LoadShaderFromMemory(rlgDepthVS, rlgDepthMomentsFS);
+    ms->blur = LoadShaderFromMemory(rlgFullscreenVS, rlgMomentsBlurFS);
+
+    // NOTE: raylib falls back to its default shader when the compilation fails
+    if (ms->depth.id == rlGetShaderIdDefault() || ms->blur.id == rlGetShaderIdDefault())
+    {
+        UnloadShader(ms->depth);
+        UnloadShader(ms->blur);
+        ms->depth = ms->blur = (Shader){ 0 };
+        return;
+    }
+
+    ms->locExponent = rlGetLocationUniform(ms->depth.id, "exponent");
+    ms->locDirection = rlGetLocationUniform(ms->blur.id, "direction");
+
+    // The fullscreen triangle is generated from gl_VertexID, but a vertex array must still be bound
+    ms->vaoId = rlLoadVertexArray();
+}
+
+static void rlgBlurShadowMoments(struct RLG_ShadowMap *sm)
+{
+    struct RLG_MomentsShadows *ms = &rlgCtx->moments;
+    int resolution = sm->moments.width;
+
+    // The horizontal pass goes to a temporary target borrowed from the pool
+    Texture2D temp = { 0 };
+    unsigned int tempId = 0;
+    if (!rlgTakePooledShadowStorage(RLG_SHADOW_STORAGE_MOMENTS, resolution, &temp, &tempId))
+    {
+        rlgLoadMomentsMap(&temp, &tempId, resolution);
+    }
+
+    rlDisableDepthTest();
+    rlEnableShader(ms->blur.id);
+    rlEnableVertexArray(ms->vaoId);
+    rlActiveTextureSlot(0);
+
+    Vector2 direction = { 1.0f/resolution, 0.0f };
+    rlEnableFramebuffer(tempId);
+    rlSetUniform(ms->locDirection, &direction, SHADER_UNIFORM_VEC2, 1);
+    rlEnableTexture(sm->moments.id);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // The vertical pass writes back into the first level of the moments texture
+    direction = (Vector2){ 0.0f, 1.0f/resolution };
+    rlEnableFramebuffer(sm->momentsId);
+    rlSetUniform(ms->locDirection, &direction, SHADER_UNIFORM_VEC2, 1);
+    rlEnableTexture(temp.id);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    rlDisableTexture();
+    rlDisableVertexArray();
+    rlDisableShader();
+    rlEnableDepthTest();
+
+    // Rebuild the mip chain from the blurred moments
+    glBindTexture(GL_TEXTURE_2D, sm->moments.id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    rlgPutPooledShadowStorage(RLG_SHADOW_STORAGE_MOMENTS, temp, tempId);
+}
+
+// Texture units of the shadow mask shader, the light of channel i uses unit 1 + i
+#define RLG_SHADOW_MASK_UNIT_DEPTH          0
+#define RLG_SHADOW_MASK_PARK_UNIT_2D        5
+#define RLG_SHADOW_MASK_PARK_UNIT_CUBE      6
+#define RLG_SHADOW_MASK_PARK_UNIT_MOMENTS   RLG_SHADOW_MASK_UNIT_DEPTH  // Same sampler type as the scene depth
+
+static void rlgLoadShadowMaskShader(void)
+{
+    struct RLG_ShadowMask *sm = &rlgCtx->shadowMask;
+
+    // The mask is computed by the lighting shader itself, built with one light per channel
+    static const char define[] = "#define SHADOW_MASK\n";
+    char *fs = (char*)malloc(sizeof(rlgLightingFS) + sizeof(define));
+    snprintf(fs, sizeof(rlgLightingFS) + sizeof(define), rlgLightingFS, 4, define);
+
+    sm->shader = LoadShaderFromMemory(rlgFullscreenVS, fs);
+    free(fs);
+
+    // NOTE: raylib falls back to its default shader when the compilation fails
+    if (sm->shader.id == rlGetShaderIdDefault())
+    {
+        sm->shader = (Shader){ 0 };
+        return;
+    }
+
+    unsigned int id = sm->shader.id;
+    sm->locInvViewProj = rlGetLocationUniform(id, "sceneInvViewProj");
+    sm->locViewPos = rlGetLocationUniform(id, RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION);
+    sm->locSceneDepth = rlGetLocationUniform(id, "sceneDepth");
+
+    int depthUnit = RLG_SHADOW_MASK_UNIT_DEPTH;
+    SetShaderValue(sm->shader, sm->locSceneDepth, &depthUnit, SHADER_UNIFORM_INT);
+
+    for (int i = 0; i < 4; i++)
+    {
+        struct RLG_ShadowMaskLight *locs = &sm->locs[i];
+
+        locs->vpMatrix          = rlGetLocationUniform(id, TextFormat("matLights[%i]", i));
+        locs->shadowCubemap     = rlGetLocationUniform(id, TextFormat("lights[%i].shadowCubemap", i));
+        locs->shadowMap         = rlGetLocationUniform(id, TextFormat("lights[%i].shadowMap", i));
+        locs->shadowMoments     = rlGetLocationUniform(id, TextFormat("lights[%i].shadowMoments", i));
+        locs->position          = rlGetLocationUniform(id, TextFormat("lights[%i].position", i));
+        locs->direction         = rlGetLocationUniform(id, TextFormat("lights[%i].direction", i));
+        locs->shadowMapTxlSz    = rlGetLocationUniform(id, TextFormat("lights[%i].shadowMapTxlSz", i));
+        locs->depthBias         = rlGetLocationUniform(id, TextFormat("lights[%i].depthBias", i));
+        locs->shadowDepthParams = rlGetLocationUniform(id, TextFormat("lights[%i].shadowDepthParams", i));
+        locs->type              = rlGetLocationUniform(id, TextFormat("lights[%i].type", i));
+        locs->shadowTechnique   = rlGetLocationUniform(id, TextFormat("lights[%i].shadowTechnique", i));
+        locs->omniShadowMode    = rlGetLocationUniform(id, TextFormat("lights[%i].omniShadowMode", i));
+        locs->enabled           = rlGetLocationUniform(id, TextFormat("lights[%i].enabled", i));
+
+        // NOTE: Two samplers of different types referring to the same unit make draws fail
+        int parkMap = RLG_SHADOW_MASK_PARK_UNIT_2D, parkCubemap = RLG_SHADOW_MASK_PARK_UNIT_CUBE;
+        int parkMoments = RLG_SHADOW_MASK_PARK_UNIT_MOMENTS;
+        SetShaderValue(sm->shader, locs->shadowMap, &parkMap, SHADER_UNIFORM_INT);
+        SetShaderValue(sm->shader, locs->shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT);
+        SetShaderValue(sm->shader, locs->shadowMoments, &parkMoments, SHADER_UNIFORM_INT);
+    }
+
+    // The fullscreen triangle is generated from gl_VertexID, but a vertex array must still be bound
+    sm->vaoId = rlLoadVertexArray();
+}
+
+static void rlgLoadShadowMaskTargets(int width, int height, int maskWidth, int maskHeight)
+{
+    struct RLG_ShadowMask *sm = &rlgCtx->shadowMask;
+
+    if (sm->depthId != 0)
+    {
+        rlUnloadTexture(sm->depth.id);
+        rlUnloadFramebuffer(sm->depthId);
+    }
+
+    if (sm->maskId != 0)
+    {
+        rlUnloadTexture(sm->mask.id);
+        rlUnloadFramebuffer(sm->maskId);
+    }
+
+    // Depth-only target of the pre-pass, sampled with nearest filtering
+    sm->depthId = rlLoadFramebuffer(width, height);
+    sm->depth.id = rlLoadTextureDepth(width, height, false);
+    sm->depth.width = width;
+    sm->depth.height = height;
+    sm->depth.format = 19, sm->depth.mipmaps = 1;
+    rlFramebufferAttach(sm->depthId, sm->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    // One channel per light, the lighting shader fetches its texels directly
+    sm->maskId = rlLoadFramebuffer(maskWidth, maskHeight);
+    sm->mask.id = rlLoadTexture(NULL, maskWidth, maskHeight, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    sm->mask.width = maskWidth;
+    sm->mask.height = maskHeight;
+    sm->mask.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, sm->mask.mipmaps = 1;
+    rlFramebufferAttach(sm->maskId, sm->mask.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    if (!rlFramebufferComplete(sm->depthId) || !rlFramebufferComplete(sm->maskId))
+    {
+        TraceLog(LOG_ERROR, "Framebuffer is not complete for shadow mask");
+    }
+}
+
+// Texture units of the deferred light pass, the shadow map of the light uses its own unit
+#define RLG_DEFERRED_UNIT_ALBEDO            0
+#define RLG_DEFERRED_UNIT_NORMAL            1
+#define RLG_DEFERRED_UNIT_LIGHTING          2
+#define RLG_DEFERRED_UNIT_DEPTH             3
+#define RLG_DEFERRED_UNIT_SHADOW            4
+#define RLG_DEFERRED_PARK_UNIT_2D           5
+#define RLG_DEFERRED_PARK_UNIT_CUBE         6
+#define RLG_DEFERRED_PARK_UNIT_MOMENTS      RLG_DEFERRED_UNIT_ALBEDO    // Same sampler type as the G-buffer
+
+// Subdivisions of the light volumes
+#define RLG_DEFERRED_VOLUME_RINGS           8
+#define RLG_DEFERRED_VOLUME_SLICES          16
+
+static int rlgPushVolumeTriangle(Vector3 *vertices, int count, Vector3 a, Vector3 b, Vector3 c, Vector3 inside)
+{
+    // Counter-clockwise when seen from outside the volume
+    Vector3 normal = Vector3CrossProduct(Vector3Subtract(b, a), Vector3Subtract(c, a));
+    if (Vector3DotProduct(normal, Vector3Subtract(a, inside)) < 0.0f)
+    {
+        Vector3 temp = b;
+        b = c, c = temp;
+    }
+
+    vertices[count] = a;
+    vertices[count + 1] = b;
+    vertices[count + 2] = c;
+
+    return count + 3;
+}
+
+static void rlgLoadDeferredVolumes(void)
+{
+    struct RLG_Deferred *d = &rlgCtx->deferred;
+
+    const int rings = RLG_DEFERRED_VOLUME_RINGS;
+    const int slices = RLG_DEFERRED_VOLUME_SLICES;
+
+    Vector3 vertices[3*(RLG_DEFERRED_VOLUME_SLICES*(2*RLG_DEFERRED_VOLUME_RINGS - 2) + 2*RLG_DEFERRED_VOLUME_SLICES)];
+    int count = 0;
+
+    // Unit sphere, its vertices are pushed outward so that its flat faces enclose the sphere
+    float sphereScale = 1.0f/(cosf(0.5f*PI/rings)*cosf(PI/slices));
+
+    for (int r = 0; r < rings; r++)
+    {
+        for (int s = 0; s < slices; s++)
+        {
+            Vector3 p[4];
+            for (int k = 0; k < 4; k++)
+            {
+                float theta = PI*(r + (k >> 1))/rings;
+                float phi = 2.0f*PI*(s + (k & 1))/slices;
+                p[k] = (Vector3){ sinf(theta)*cosf(phi), cosf(theta), sinf(theta)*sinf(phi) };
+                p[k] = Vector3Scale(p[k], sphereScale);
+            }
+
+            // The quads touching the poles are triangles
+            if (r > 0) count = rlgPushVolumeTriangle(vertices, count, p[0], p[1], p[3], Vector3Zero());
+            if (r < rings - 1) count = rlgPushVolumeTriangle(vertices, count, p[0], p[3], p[2], Vector3Zero());
+        }
+    }
+
+    d->sphereVertexCount = count;
+
+    // Unit cone with its apex at the origin, opening toward +Z up to a base of radius 1 at Z = 1
+    float coneScale = 1.0f/cosf(PI/slices);
+    Vector3 apex = Vector3Zero(), center = { 0.0f, 0.0f, 1.0f }, inside = { 0.0f, 0.0f, 0.5f };
+
+    for (int s = 0; s < slices; s++)
+    {
+        float phi0 = 2.0f*PI*s/slices, phi1 = 2.0f*PI*(s + 1)/slices;
+        Vector3 b0 = { coneScale*cosf(phi0), coneScale*sinf(phi0), 1.0f };
+        Vector3 b1 = { coneScale*cosf(phi1), coneScale*sinf(phi1), 1.0f };
+
+        count = rlgPushVolumeTriangle(vertices, count, apex, b0, b1, inside);
+        count = rlgPushVolumeTriangle(vertices, count, center, b1, b0, inside);
+    }
+
+    d->coneVertexCount = count - d->sphereVertexCount;
+
+    d->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(d->vaoId);
+    d->vboId = rlLoadVertexBuffer(vertices, count*sizeof(Vector3), false);
+    rlSetVertexAttribute(0, 3, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(0);
+    rlDisableVertexArray();
+}
+
+static void rlgLoadDeferredShaders(void)
+{
+    struct RLG_Deferred *d = &rlgCtx->deferred;
+
+    // The G-buffer and light passes are built from the lighting shader, the light pass evaluates one light
+    static const char gbufferDefine[] = "#define GBUFFER\n";
+    static const char lightDefine[] = "#define DEFERRED_LIGHT\n";
+
+    char *vs = (char*)malloc(sizeof(rlgLightingVS));
+    snprintf(vs, sizeof(rlgLightingVS), rlgLightingVS, 1);
+
+    char *fs = (char*)malloc(sizeof(rlgLightingFS) + sizeof(lightDefine));
+    snprintf(fs, sizeof(rlgLightingFS) + sizeof(lightDefine), rlgLightingFS, 1, gbufferDefine);
+    d->gbuffer.id = rlLoadShaderCode(vs, fs);
+
+    snprintf(fs, sizeof(rlgLightingFS) + sizeof(lightDefine), rlgLightingFS, 1, lightDefine);
+    d->light = LoadShaderFromMemory(rlgDeferredLightVS, fs);
+
+    free(vs);
+    free(fs);
+
+    d->composite = LoadShaderFromMemory(rlgFullscreenVS, rlgDeferredCompositeFS);
+
+    // NOTE: raylib falls back to its default shader when the compilation fails
+    unsigned int defaultId = rlGetShaderIdDefault();
+    if (d->gbuffer.id == defaultId || d->light.id == defaultId || d->composite.id == defaultId)
+    {
+        if (d->gbuffer.id != defaultId) rlUnloadShaderProgram(d->gbuffer.id);
+        UnloadShader(d->light);
+        UnloadShader(d->composite);
+
+        d->gbuffer = d->light = d->composite = (Shader){ 0 };
+        return;
+    }
+
+    // Same locations as the lighting shader, so that RLG_DrawMesh can draw with both
+    rlgGetLightingLocations(&d->gbuffer);
+
+    for (int i = 0, mapID = 0, cubemapID = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
+    {
+        if (i == MATERIAL_MAP_CUBEMAP || i == MATERIAL_MAP_IRRADIANCE || i == MATERIAL_MAP_PREFILTER)
+        {
+            d->locUseMaps[i] = rlGetLocationUniform(d->gbuffer.id, TextFormat("cubemaps[%i].active", cubemapID));
+            cubemapID++;
         }
         else
         {
-            rlSetUniform(shader->locs[RLG_LOC_HEIGHT_SCALE],
-                &material.maps[MATERIAL_MAP_HEIGHT].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-    }
+            d->locUseMaps[i] = rlGetLocationUniform(d->gbuffer.id, TextFormat("maps[%i].active", mapID));
+            mapID++;
+        }
+    }
+
+    d->locParallaxMinLayers = rlGetLocationUniform(d->gbuffer.id, "parallaxMinLayers");
+    d->locParallaxMaxLayers = rlGetLocationUniform(d->gbuffer.id, "parallaxMaxLayers");
+
+    unsigned int id = d->light.id;
+    rlgGetLightLocations(id, 0, &d->lightLocs);
+    d->locInvViewProj = rlGetLocationUniform(id, "sceneInvViewProj");
+    d->locViewPos = rlGetLocationUniform(id, RLG_SHADER_LIGHTING_UNIFORM_VIEW_POSITION);
+    d->locMvp = rlGetLocationUniform(id, "mvp");
+    d->locFullscreen = rlGetLocationUniform(id, "fullscreen");
+
+    int units[4] = { RLG_DEFERRED_UNIT_ALBEDO, RLG_DEFERRED_UNIT_NORMAL, RLG_DEFERRED_UNIT_LIGHTING, RLG_DEFERRED_UNIT_DEPTH };
+    SetShaderValue(d->light, rlGetLocationUniform(id, "gbufferAlbedo"), &units[0], SHADER_UNIFORM_INT);
+    SetShaderValue(d->light, rlGetLocationUniform(id, "gbufferNormal"), &units[1], SHADER_UNIFORM_INT);
+    SetShaderValue(d->light, rlGetLocationUniform(id, "gbufferLighting"), &units[2], SHADER_UNIFORM_INT);
+    SetShaderValue(d->light, rlGetLocationUniform(id, "gbufferDepth"), &units[3], SHADER_UNIFORM_INT);
+
+    // NOTE: Two samplers of different types referring to the same unit make draws fail
+    int parkMap = RLG_DEFERRED_PARK_UNIT_2D, parkCubemap = RLG_DEFERRED_PARK_UNIT_CUBE;
+    int parkMoments = RLG_DEFERRED_PARK_UNIT_MOMENTS;
+    SetShaderValue(d->light, d->lightLocs.shadowMap, &parkMap, SHADER_UNIFORM_INT);
+    SetShaderValue(d->light, d->lightLocs.shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT);
+    SetShaderValue(d->light, d->lightLocs.shadowMoments, &parkMoments, SHADER_UNIFORM_INT);
+
+    // The light pass never reads the shadow mask
+    int shadowMaskChannel = -1;
+    SetShaderValue(d->light, d->lightLocs.shadowMaskChannel, &shadowMaskChannel, SHADER_UNIFORM_INT);
+
+    SetShaderValue(d->composite, rlGetLocationUniform(d->composite.id, "gbufferLighting"), &units[2], SHADER_UNIFORM_INT);
+    SetShaderValue(d->composite, rlGetLocationUniform(d->composite.id, "gbufferDepth"), &units[3], SHADER_UNIFORM_INT);
+
+    rlgLoadDeferredVolumes();
+}
+
+static void rlgLoadDeferredTexture(Texture2D *texture, int internalFormat, int format, int type, int width, int height)
+{
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+
+    // The passes reading the G-buffer fetch its texels directly
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    texture->width = width;
+    texture->height = height;
+    texture->mipmaps = 1;
+}
+
+static void rlgLoadDeferredTargets(int width, int height)
+{
+    struct RLG_Deferred *d = &rlgCtx->deferred;
+
+    if (d->framebufferId != 0)
+    {
+        rlUnloadTexture(d->albedo.id);
+        rlUnloadTexture(d->normal.id);
+        rlUnloadTexture(d->lighting.id);
+        rlUnloadTexture(d->depth.id);
+        rlUnloadFramebuffer(d->framebufferId);
+    }
+
+    d->framebufferId = rlLoadFramebuffer(width, height);
+
+    rlgLoadDeferredTexture(&d->albedo, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    rlgLoadDeferredTexture(&d->normal, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, width, height);
+    rlgLoadDeferredTexture(&d->lighting, GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+
+    // NOTE: Closest raylib formats, only informative
+    d->albedo.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    d->normal.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    d->lighting.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32A32;
+
+    d->depth.id = rlLoadTextureDepth(width, height, false);
+    d->depth.width = width;
+    d->depth.height = height;
+    d->depth.format = 19, d->depth.mipmaps = 1;
+
+    rlFramebufferAttach(d->framebufferId, d->albedo.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebufferId, d->normal.id, RL_ATTACHMENT_COLOR_CHANNEL1, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebufferId, d->lighting.id, RL_ATTACHMENT_COLOR_CHANNEL2, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebufferId, d->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    // The draw buffers are part of the state of the framebuffer
+    rlEnableFramebuffer(d->framebufferId);
+    rlActiveDrawBuffers(3);
+    rlDisableFramebuffer();
+
+    if (!rlFramebufferComplete(d->framebufferId))
+    {
+        TraceLog(LOG_ERROR, "Framebuffer is not complete for the G-buffer");
+    }
+}
+
+#endif
+
+static int rlgCountBits(unsigned int mask)
+{
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) count++;
+    return count;
+}
+
+static int rlgGetShadowFaceCount(const struct RLG_Light *l)
+{
+    if (l->data.type != RLG_OMNILIGHT) return 1;
+
+    // Cubemap faces or paraboloid hemispheres
+    return (l->data.omniShadowMode == RLG_OMNI_SHADOW_DUAL_PARABOLOID) ? 2 : 6;
+}
+
+static bool rlgIsShadowLayered(const struct RLG_Light *l)
+{
+    return (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_CUBE) && rlgCtx->layered.active;
+}
+
+static struct RLG_Frustum rlgGetHemisphereFrustum(Vector3 position, float hemisphere, float range)
+{
+    struct RLG_Frustum frustum = { 0 };
+
+    // Half-space in front of the hemisphere, bounded by the box enclosing the range of the light
+    frustum.planes[0] = (Vector4){ 0.0f, 0.0f, hemisphere, -hemisphere*position.z };
+    frustum.planes[1] = (Vector4){ 0.0f, 0.0f, -hemisphere, hemisphere*position.z + range };
+    frustum.planes[2] = (Vector4){ 1.0f, 0.0f, 0.0f, -position.x + range };
+    frustum.planes[3] = (Vector4){ -1.0f, 0.0f, 0.0f, position.x + range };
+    frustum.planes[4] = (Vector4){ 0.0f, 1.0f, 0.0f, -position.y + range };
+    frustum.planes[5] = (Vector4){ 0.0f, -1.0f, 0.0f, position.y + range };
+
+    return frustum;
+}
+
+static float rlgGetLightRange(const struct RLG_Light *l)
+{
+    // Distance at which the attenuated energy falls below 1/256,
+    // the attenuation being 1/(constant + linear*d + quadratic*d^2)
+    float c = l->data.constant, lin = l->data.linear, q = l->data.quadratic;
+    float k = c - 256.0f*l->data.energy;
+
+    if (k >= 0.0f) return 0.0f;
+    if (q > 0.0f) return (-lin + sqrtf(lin*lin - 4.0f*q*k))/(2.0f*q);
+    if (lin > 0.0f) return -k/lin;
+
+    return -1.0f;   // Unbounded range, no attenuation
+}
+
+static void rlgCheckShadowMotion(struct RLG_Light *l)
+{
+    struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+    // All the faces rendered before the light has moved are outdated
+    if (memcmp(&sm->lastPosition, &l->data.position, sizeof(Vector3)) != 0 ||
+        memcmp(&sm->lastDirection, &l->data.direction, sizeof(Vector3)) != 0)
+    {
+        sm->dirtyFaces = (1u << rlgGetShadowFaceCount(l)) - 1;
+        sm->lastPosition = l->data.position;
+        sm->lastDirection = l->data.direction;
+    }
+}
+
+static void rlgSelectShadowResolution(struct RLG_Light *l)
+{
+    struct RLG_ShadowMap *sm = &l->data.shadowMap;
+    int minRes = l->data.shadowMinResolution;
+    int maxRes = l->data.shadowMaxResolution;
+
+    if (maxRes <= 0) return;
+
+    // Estimate the screen footprint of the light, in pixels, from the angular size of its range
+    float footprint = (float)maxRes;
+    float range = rlgGetLightRange(l);
+
+    if (l->data.type != RLG_DIRLIGHT && range >= 0.0f)
+    {
+        float distance = Vector3Distance(rlgCtx->viewPos, l->data.position);
+        float angularSize = (distance > range) ? range/distance : 1.0f;
+        footprint = angularSize*rlgCtx->projScale*rlGetFramebufferHeight();
+    }
+
+    // Go up as soon as the footprint exceeds the resolution,
+    // but only go down once it is well below the lower resolution
+    int resolution = (sm->width > 0) ? sm->width : minRes;
+    while (resolution < maxRes && footprint > resolution) resolution *= 2;
+    while (resolution > minRes && footprint < 0.35f*resolution) resolution /= 2;
+
+    if (resolution < minRes) resolution = minRes;
+    if (resolution > maxRes) resolution = maxRes;
+
+    if (resolution == sm->width) return;
+
+    // Swap the shadow map with one of the new resolution, the previous one goes back to the pool
+    int storage = rlgGetShadowStorage(l);
+    rlgReleaseShadowMap(sm, storage);
+    rlgAcquireShadowMap(sm, storage, resolution);
+    rlgReleaseShadowMoments(sm);
+
+    sm->emptyFaces = 0;
+    sm->dirtyFaces = 0x3F;
+
+    float texelSize = 1.0f/resolution;
+    SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.shadowMapTxlSz,
+        &texelSize, SHADER_UNIFORM_FLOAT);
+}
+
+static void rlgUpdateShadowFaces(struct RLG_Light *l, RLG_DrawFunc drawFunc, unsigned int faceMask)
+{
+    struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+    // A new shadow map has to be fully rendered
+    int previousResolution = sm->width;
+    rlgSelectShadowResolution(l);
+    if (sm->width != previousResolution) faceMask = 0x3F;
+
+    // A layered cubemap can only be rendered as a whole
+    bool layered = rlgIsShadowLayered(l);
+    bool paraboloid = (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_PARABOLOID);
+    if (layered) faceMask = 0x3F;
+
+    // Near and far clipping planes for shadow map rendering
+    rlgCtx->zNear = 0.01f;      // TODO: replace with rlGetCullDistanceNear()
+    rlgCtx->zFar = 1000.0f;     // TODO: replace with rlGetCullDistanceFar()
+
+    // Omnilight faces end at the range of the light, so that no depth precision is wasted beyond it
+    float zFar = rlgCtx->zFar;
+    if (l->data.type == RLG_OMNILIGHT)
+    {
+        float range = rlgGetLightRange(l);
+        if (range > rlgCtx->zNear) zFar = range;
+
+        // The faces rendered with other planes are no longer comparable, all of them are rendered again
+        if (zFar != sm->zFar)
+        {
+            faceMask = 0x3F;
+            sm->zFar = zFar;
+
+            // Send the terms of the perspective depth, so that the lighting shader can compute
+            // the depth of a fragment from its distance to the light along the major axis,
+            // paraboloid maps store the distance to the light linearly instead
+            float zNear = rlgCtx->zNear;
+            Vector2 depthParams = paraboloid
+                ? (Vector2){ 1.0f/(zFar - zNear), zNear/(zFar - zNear) }
+                : (Vector2){ zFar/(zFar - zNear), zFar*zNear/(zFar - zNear) };
+
+            SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.shadowDepthParams,
+                &depthParams, SHADER_UNIFORM_VEC2);
+            sm->depthParams = depthParams;
+        }
+    }
+
+    // The requested faces will be up to date when leaving this function
+    rlgCheckShadowMotion(l);
+    sm->dirtyFaces &= ~faceMask;
+    for (int i = 0; i < 6; i++)
+    {
+        if (faceMask & (1u << i)) sm->faceAges[i] = 0;
+    }
+
+    // Set up projection matrix based on the light type
+    Matrix matProj = MatrixIdentity();
+    switch (l->data.type)
+    {
+        case RLG_DIRLIGHT:
+        case RLG_SPOTLIGHT:
+            // Orthographic projection for directional and spotlight
+            matProj = MatrixOrtho(-10.0, 10.0, -10.0, 10.0, rlgCtx->zNear, rlgCtx->zFar);
+            break;
+
+        case RLG_OMNILIGHT:
+            // Perspective projection for omnidirectional light
+            matProj = MatrixPerspective(90*DEG2RAD, 1.0, rlgCtx->zNear, zFar);
+            break;
+    }
+
+    // Determine the number of faces to render and their view matrices
+    int faceCount = rlgGetShadowFaceCount(l);
+    Matrix matViews[6] = { 0 };
+    struct RLG_Frustum frustums[6] = { 0 };
+
+    for (int i = 0; i < faceCount; i++)
+    {
+        // The paraboloid projection is done by the depth shader, hemisphere 0 faces +Z
+        if (paraboloid)
+        {
+            matViews[i] = MatrixIdentity();
+            frustums[i] = rlgGetHemisphereFrustum(l->data.position, (i == 0) ? 1.0f : -1.0f, zFar);
+            continue;
+        }
+
+        matViews[i] = (l->data.type == RLG_OMNILIGHT)
+            ? MatrixLookAt(l->data.position, Vector3Add(l->data.position, rlgCubemapDirs[i]), rlgCubemapUps[i])
+            : MatrixLookAt(l->data.position, Vector3Add(l->data.position, l->data.direction), (Vector3){ 0, 1, 0});
+
+        frustums[i] = rlgGetFrustum(MatrixMultiply(matViews[i], matProj));
+    }
+
+    // Cull the registered casters against the frustum of each face
+    unsigned int usedFaces = 0;
+    for (unsigned int i = 0; i < rlgCtx->casterCapacity; i++)
+    {
+        struct RLG_ShadowCaster *caster = &rlgCtx->casters[i];
+        caster->faceMask = 0;
+
+        if (!caster->used || !(caster->flags & (1u << l->data.type)))
+        {
+            continue;
+        }
+
+        for (int j = 0; j < faceCount; j++)
+        {
+            if ((caster->flags & RLG_CAST_NO_CULL) || rlgFrustumHasBox(&frustums[j], caster->bounds))
+            {
+                caster->faceMask |= 1u << j;
+            }
+        }
+
+        usedFaces |= caster->faceMask;
+    }
+
+    // Calculate and send the view-projection matrix to the lighting shader for later rendering
+    if (l->data.type != RLG_OMNILIGHT)
+    {
+        Matrix viewProj = MatrixMultiply(matViews[0], matProj);
+        SetShaderValueMatrix(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.vpMatrix, viewProj);
+        sm->viewProj = viewProj;
+    }
+
+    // Variance shadow maps need their moments texture, a new one has to be fully rendered
+    bool moments = (l->data.type != RLG_OMNILIGHT) && (l->data.shadowTechnique != RLG_SHADOW_TECHNIQUE_PCF);
+    if (moments && sm->momentsId == 0)
+    {
+        rlgAcquireShadowMoments(sm, sm->width);
+        sm->emptyFaces = 0;
+    }
+
+    // Nothing to do if all requested faces are known to be empty and are still empty
+    faceMask &= (1u << faceCount) - 1;
+    if (drawFunc == NULL && (usedFaces & faceMask) == 0 && (sm->emptyFaces & faceMask) == faceMask)
+    {
+        return;
+    }
+
+    // Flush the rendering batch and enable the shadow map framebuffer
+    rlDrawRenderBatchActive();
+    rlEnableFramebuffer(sm->id);
+
+    // Configure the projection for the shadow map
+    rlViewport(0, 0, sm->width, sm->height);
+    rlMatrixMode(RL_PROJECTION);
+    rlPushMatrix();
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(matProj));
+
+    // Switch to modelview matrix mode
+    rlMatrixMode(RL_MODELVIEW);
+
+    // Enable depth test and disable color blending
+    rlEnableDepthTest();
+    rlDisableColorBlend();
+
+    // Select the appropriate depth shader
+    Shader shader = { 0 };
+    if (l->data.type == RLG_OMNILIGHT)
+    {
+        // NOTE: Only the hardware depth is written, the lighting shader reconstructs it
+        shader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP];
+    }
+    else
+    {
+        shader = rlgCtx->shaders[RLG_SHADER_DEPTH];
+    }
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    float clearColor[4] = { 0 };
+
+    // Render the depth moments into a color target sharing the depth buffer of the shadow map
+    if (moments)
+    {
+        float exponent = (l->data.shadowTechnique == RLG_SHADOW_TECHNIQUE_EVSM) ? RLG_SHADOW_EVSM_EXPONENT : 0.0f;
+        shader = rlgCtx->moments.depth;
+        SetShaderValue(shader, rlgCtx->moments.locExponent, &exponent, SHADER_UNIFORM_FLOAT);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sm->moments.id, 0);
+
+        // Cleared texels are at the far plane
+        float far = (exponent > 0.0f) ? expf(exponent) : 1.0f;
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        glClearColor(far, far*far, 0.0f, 0.0f);
+    }
+
+    // Render all the faces of an omnilight in a single pass if layered rendering is enabled
+    if (layered)
+    {
+        rlgRenderShadowCubemapLayered(l, drawFunc, matViews, matProj, usedFaces);
+        faceCount = 0;  // Nothing left to render face by face
+    }
+
+    // Each hemisphere is rendered in its half of the map, the other one is kept by the scissor
+    if (paraboloid)
+    {
+        struct RLG_ParaboloidShadows *ps = &rlgCtx->paraboloid;
+        Vector2 depthParams = { 1.0f/(zFar - rlgCtx->zNear), rlgCtx->zNear/(zFar - rlgCtx->zNear) };
+
+        shader = ps->shader;
+        SetShaderValue(shader, ps->locLightPos, &l->data.position, SHADER_UNIFORM_VEC3);
+        SetShaderValue(shader, ps->locDepthParams, &depthParams, SHADER_UNIFORM_VEC2);
+
+        glEnable(GL_CLIP_DISTANCE0);
+        rlEnableScissorTest();
+    }
+#endif
+
+    bool rendered = false;
+    for (int i = 0; i < faceCount; i++)
+    {
+        // Skip faces which have not been requested
+        if (!(faceMask & (1u << i)))
+        {
+            continue;
+        }
+
+        // Skip faces which have nothing to draw and have already been cleared
+        bool hasCasters = (drawFunc != NULL) || (usedFaces & (1u << i));
+        if (!hasCasters && (sm->emptyFaces & (1u << i)))
+        {
+            continue;
+        }
+
+        // Attach the depth texture of the i-th face
+        if (paraboloid)
+        {
+            float hemisphere = (i == 0) ? 1.0f : -1.0f;
+            SetShaderValue(shader, rlgCtx->paraboloid.locHemisphere, &hemisphere, SHADER_UNIFORM_FLOAT);
+
+            rlViewport(i*sm->width, 0, sm->width, sm->height);
+            rlScissor(i*sm->width, 0, sm->width, sm->height);
+        }
+        else if (l->data.type == RLG_OMNILIGHT)
+        {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                sm->depth.id, 0);
+        }
+
+        // Apply the view matrix for rendering into the depth texture
+        rlLoadIdentity();
+        rlMultMatrixf(MatrixToFloat(matViews[i]));
+
+        // Clear the previous state of the depth texture
+        rlClearScreenBuffers();
+
+        // Render objects in the light's context
+        if (drawFunc != NULL) drawFunc(shader);
+        rlgCastShadowCasters(shader, i);
+
+        // Flush the rendering batch
+        rlDrawRenderBatchActive();
+
+        // Remember if the face has been left empty, so that we can skip it next time
+        if (hasCasters) sm->emptyFaces &= ~(1u << i);
+        else sm->emptyFaces |= 1u << i;
+
+        rendered = true;
+    }
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    if (paraboloid)
+    {
+        rlDisableScissorTest();
+        glDisable(GL_CLIP_DISTANCE0);
+    }
+
+    if (moments)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+        // Filter the new moments at the shadow map resolution
+        if (rendered) rlgBlurShadowMoments(sm);
+    }
+#else
+    (void)rendered;
+#endif
+
+    // End rendering
+    rlEnableColorBlend();
+    rlDisableFramebuffer();
+
+    // Reset the viewport and projection matrix to the screen settings
+    rlViewport(0, 0, GetScreenWidth(), GetScreenHeight());
+    rlMatrixMode(RL_PROJECTION);
+    rlPopMatrix();
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+}
+
+void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc)
+{
+    // Safety checks
+    if (light >= rlgCtx->lightCount)
+    {
+        // Log an error if the light ID exceeds the number of allocated lights
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_UpdateShadowMap' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return;
+    }
+
+    // Get a pointer to the specified light structure
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    if (!l->data.shadow)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] does not support shadow casting", light);
+        return;
+    }
+
+    // The shadow is not visible beyond its fade distance
+    rlgUpdateShadowFade(l);
+    if (l->data.shadowFadedOut) return;
+
+    rlgUpdateShadowFaces(l, drawFunc, 0x3F);
+}
+
+static float rlgGetShadowPriority(const struct RLG_Light *l)
+{
+    const struct RLG_ShadowMap *sm = &l->data.shadowMap;
+    int faceCount = rlgGetShadowFaceCount(l);
+
+    // Screen-space influence, approximated by the apparent size of the area lit by the light
+    float influence = 1.0f;
+    float range = rlgGetLightRange(l);
+    if (l->data.type != RLG_DIRLIGHT && range >= 0.0f)
+    {
+        float distance = Vector3Distance(rlgCtx->viewPos, l->data.position);
+        if (distance > range) influence = range/distance;
+    }
+
+    // A fading shadow matters less
+    influence *= l->data.shadowFade;
+
+    // Staleness, given by the oldest face
+    unsigned int age = 0;
+    for (int i = 0; i < faceCount; i++)
+    {
+        if (sm->faceAges[i] > age) age = sm->faceAges[i];
+    }
+
+    // Motion, given by the proportion of faces rendered before the light has moved
+    float motion = (float)rlgCountBits(sm->dirtyFaces)/faceCount;
+
+    return influence*(1.0f + age)*(1.0f + 4.0f*motion);
+}
+
+void RLG_UpdateShadows(RLG_DrawFunc drawFunc, int budget)
+{
+    // NOTE: The number of lights is limited to 99 by RLG_CreateContext
+    float priorities[99] = { 0 };
+
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        struct RLG_Light *l = &rlgCtx->lights[i];
+        struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+        priorities[i] = -1.0f;
+        if (!l->data.enabled || !l->data.shadow) continue;
+
+        // The lights beyond their shadow fade distance are left out of the updates
+        rlgUpdateShadowFade(l);
+        if (l->data.shadowFadedOut) continue;
+
+        // Every face gets older, the rendered ones will be reset
+        for (int j = 0; j < 6; j++) sm->faceAges[j]++;
+
+        rlgCheckShadowMotion(l);
+        priorities[i] = rlgGetShadowPriority(l);
+    }
+
+    // Update the lights by decreasing priority until the budget is spent
+    int remaining = budget;
+    while (budget <= 0 || remaining > 0)
+    {
+        int best = -1;
+        for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+        {
+            if (priorities[i] >= 0.0f && (best < 0 || priorities[i] > priorities[best])) best = i;
+        }
+
+        if (best < 0) break;
+        priorities[best] = -1.0f;
+
+        struct RLG_Light *l = &rlgCtx->lights[best];
+        struct RLG_ShadowMap *sm = &l->data.shadowMap;
+        int faceCount = rlgGetShadowFaceCount(l);
+        unsigned int faceMask = (1u << faceCount) - 1;
+
+        if (budget > 0 && remaining < faceCount)
+        {
+            // A layered cubemap cannot be split, it is delayed unless nothing has been rendered yet
+            if (rlgIsShadowLayered(l))
+            {
+                if (remaining < budget) continue;
+            }
+            else
+            {
+                // Select the outdated faces first, then the oldest ones
+                faceMask = 0;
+                for (int n = 0; n < remaining; n++)
+                {
+                    int face = -1;
+                    for (int i = 0; i < faceCount; i++)
+                    {
+                        if (faceMask & (1u << i)) continue;
+
+                        bool dirty = sm->dirtyFaces & (1u << i);
+                        bool bestDirty = (face >= 0) && (sm->dirtyFaces & (1u << face));
+
+                        if (face < 0 || (dirty && !bestDirty) ||
+                            (dirty == bestDirty && sm->faceAges[i] > sm->faceAges[face])) face = i;
+                    }
+
+                    faceMask |= 1u << face;
+                }
+            }
+        }
+
+        rlgUpdateShadowFaces(l, drawFunc, faceMask);
+
+        remaining -= rlgIsShadowLayered(l) ? 6 : rlgCountBits(faceMask);
+    }
+}
+
+unsigned int RLG_GetShadowUpdateAge(unsigned int light)
+{
+    if (light >= rlgCtx->lightCount)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowUpdateAge' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return 0;
+    }
+
+    const struct RLG_Light *l = &rlgCtx->lights[light];
+    int faceCount = rlgGetShadowFaceCount(l);
+
+    unsigned int age = 0;
+    for (int i = 0; i < faceCount; i++)
+    {
+        if (l->data.shadowMap.faceAges[i] > age) age = l->data.shadowMap.faceAges[i];
+    }
+
+    return age;
+}
+
+void RLG_UseLayeredShadowMaps(bool active)
+{
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    // Layered shaders are only loaded the first time they are requested
+    if (active && !rlgCtx->layered.loaded)
+    {
+        rlgLoadLayeredShaders();
+        rlgCtx->layered.loaded = true;
+    }
+
+    rlgCtx->layered.active = active && (rlgCtx->layered.geometry.shader.id > 0);
+#endif
+
+    if (active && !rlgCtx->layered.active)
+    {
+        TraceLog(LOG_WARNING, "Layered shadow maps are not supported, omnilight shadow faces will be rendered separately");
+    }
+}
+
+bool RLG_IsLayeredShadowMapsUsed(void)
+{
+    return rlgCtx->layered.active;
+}
+
+void RLG_SetShadowTechnique(unsigned int light, RLG_ShadowTechnique technique)
+{
+    if (light >= rlgCtx->lightCount)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetShadowTechnique' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    if (technique != RLG_SHADOW_TECHNIQUE_PCF)
+    {
+        bool supported = false;
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+        // Moments shaders are only loaded the first time they are requested
+        if (!rlgCtx->moments.loaded)
+        {
+            rlgLoadMomentsShaders();
+            rlgCtx->moments.loaded = true;
+        }
+
+        supported = (rlgCtx->moments.blur.id > 0);
+#endif
+
+        if (!supported)
+        {
+            TraceLog(LOG_WARNING, "Variance shadow maps are not supported, light [ID %i] keeps using PCF", light);
+            technique = RLG_SHADOW_TECHNIQUE_PCF;
+        }
+    }
+
+    if ((int)technique == l->data.shadowTechnique)
+    {
+        return;
+    }
+
+    // The moments of the previous technique are no longer valid
+    rlgReleaseShadowMoments(&l->data.shadowMap);
+    l->data.shadowMap.dirtyFaces = 0x3F;
+
+    l->data.shadowTechnique = technique;
+    SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.shadowTechnique,
+        &l->data.shadowTechnique, SHADER_UNIFORM_INT);
+}
+
+RLG_ShadowTechnique RLG_GetShadowTechnique(unsigned int light)
+{
+    if (light >= rlgCtx->lightCount)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowTechnique' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return RLG_SHADOW_TECHNIQUE_PCF;
+    }
+
+    return rlgCtx->lights[light].data.shadowTechnique;
+}
+
+void RLG_SetOmniShadowMode(unsigned int light, RLG_OmniShadowMode mode)
+{
+    if (light >= rlgCtx->lightCount)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetOmniShadowMode' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    if (mode == RLG_OMNI_SHADOW_DUAL_PARABOLOID)
+    {
+        bool supported = false;
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+        // The paraboloid shader is only loaded the first time it is requested
+        if (!rlgCtx->paraboloid.loaded)
+        {
+            rlgLoadParaboloidShader();
+            rlgCtx->paraboloid.loaded = true;
+        }
+
+        supported = (rlgCtx->paraboloid.shader.id > 0);
+#endif
+
+        if (!supported)
+        {
+            TraceLog(LOG_WARNING, "Dual-paraboloid shadow maps are not supported, light [ID %i] keeps using a cubemap", light);
+            mode = RLG_OMNI_SHADOW_CUBEMAP;
+        }
+    }
+
+    if ((int)mode == l->data.omniShadowMode)
+    {
+        return;
+    }
+
+    // Swap the shadow map of an omnilight with one of the new kind, the previous one goes back to the pool
+    struct RLG_ShadowMap *sm = &l->data.shadowMap;
+    int previousStorage = rlgGetShadowStorage(l);
+    l->data.omniShadowMode = mode;
+
+    if (sm->id != 0 && rlgGetShadowStorage(l) != previousStorage)
+    {
+        int resolution = sm->width;
+        rlgReleaseShadowMap(sm, previousStorage);
+        rlgAcquireShadowMap(sm, rlgGetShadowStorage(l), resolution);
+
+        sm->emptyFaces = 0;
+        sm->dirtyFaces = 0x3F;
+        sm->zFar = 0.0f;    // Forces the depth terms of the new projection to be sent
+    }
+
+    SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING], l->locs.omniShadowMode,
+        &l->data.omniShadowMode, SHADER_UNIFORM_INT);
+}
+
+RLG_OmniShadowMode RLG_GetOmniShadowMode(unsigned int light)
+{
+    if (light >= rlgCtx->lightCount)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetOmniShadowMode' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return RLG_OMNI_SHADOW_CUBEMAP;
+    }
+
+    return rlgCtx->lights[light].data.omniShadowMode;
+}
+
+void RLG_UseShadowMask(bool active)
+{
+    struct RLG_ShadowMask *sm = &rlgCtx->shadowMask;
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    // The shadow mask shader is only loaded the first time it is requested
+    if (active && !sm->loaded)
+    {
+        rlgLoadShadowMaskShader();
+        sm->loaded = true;
+    }
+#endif
+
+    // NOTE: A custom lighting shader may not read the shadow mask
+    bool supported = (sm->shader.id > 0) && (sm->locLightingUse != -1);
+    if (active && !supported)
+    {
+        TraceLog(LOG_WARNING, "The shadow mask is not supported, shadows will be evaluated per fragment");
+    }
+
+    sm->active = active && supported;
+
+    // Every light goes back to its shadow map until the next update of the mask
+    if (!sm->active)
+    {
+        Shader lightShader = rlgCtx->shaders[RLG_SHADER_LIGHTING];
+
+        for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+        {
+            struct RLG_Light *l = &rlgCtx->lights[i];
+
+            if (l->data.shadowMaskChannel >= 0)
+            {
+                l->data.shadowMaskChannel = -1;
+                SetShaderValue(lightShader, l->locs.shadowMaskChannel, &l->data.shadowMaskChannel, SHADER_UNIFORM_INT);
+            }
+        }
+
+        int useShadowMask = 0;
+        SetShaderValue(lightShader, sm->locLightingUse, &useShadowMask, SHADER_UNIFORM_INT);
+        for (int i = 0; i < 4; i++) sm->lights[i] = -1;
+    }
+}
+
+bool RLG_IsShadowMaskUsed(void)
+{
+    return rlgCtx->shadowMask.active;
+}
+
+void RLG_SetShadowMaskScale(float scale)
+{
+    rlgCtx->shadowMask.scale = Clamp(scale, 0.25f, 1.0f);
+}
+
+float RLG_GetShadowMaskScale(void)
+{
+    return rlgCtx->shadowMask.scale;
+}
+
+void RLG_UpdateShadowMask(Camera3D camera, RLG_DrawFunc drawFunc)
+{
+    struct RLG_ShadowMask *sm = &rlgCtx->shadowMask;
+
+    if (!sm->active)
+    {
+        return;
+    }
+
+    if (drawFunc == NULL)
+    {
+        TraceLog(LOG_ERROR, "A draw function must be specified to 'RLG_UpdateShadowMask'");
+        return;
+    }
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    Shader lightShader = rlgCtx->shaders[RLG_SHADER_LIGHTING];
+
+    // The mask covers the current render target
+    int width = rlGetFramebufferWidth();
+    int height = rlGetFramebufferHeight();
+    int maskWidth = (int)fmaxf(1.0f, width*sm->scale);
+    int maskHeight = (int)fmaxf(1.0f, height*sm->scale);
+
+    if (sm->depth.width != width || sm->depth.height != height ||
+        sm->mask.width != maskWidth || sm->mask.height != maskHeight)
+    {
+        rlgLoadShadowMaskTargets(width, height, maskWidth, maskHeight);
+    }
+
+    // Same camera matrices as BeginMode3D
+    double aspect = (double)width/(double)height;
+    Matrix matView = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix matProj = MatrixIdentity();
+
+    if (camera.projection == CAMERA_PERSPECTIVE)
+    {
+        matProj = MatrixPerspective(camera.fovy*DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    else
+    {
+        double top = camera.fovy/2.0;
+        double right = top*aspect;
+        matProj = MatrixOrtho(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+
+    // The mask can be updated while a render texture is active
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    // Render the depth of the scene
+    rlDrawRenderBatchActive();
+    rlEnableFramebuffer(sm->depthId);
+    rlViewport(0, 0, width, height);
+
+    rlMatrixMode(RL_PROJECTION);
+    rlPushMatrix();
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(matProj));
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(matView));
+
+    rlEnableDepthTest();
+    rlClearScreenBuffers();
+    drawFunc(rlgCtx->shaders[RLG_SHADER_DEPTH]);
+    rlDrawRenderBatchActive();
+
+    // Give a channel to the first four shadow casting lights
+    int channelCount = 0;
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        struct RLG_Light *l = &rlgCtx->lights[i];
+
+        int channel = -1;
+        if (l->data.enabled && l->data.shadow && !l->data.shadowFadedOut && l->data.shadowMap.id != 0 && channelCount < 4)
+        {
+            channel = channelCount++;
+            sm->lights[channel] = (int)i;
+        }
+
+        if (channel != l->data.shadowMaskChannel)
+        {
+            l->data.shadowMaskChannel = channel;
+            SetShaderValue(lightShader, l->locs.shadowMaskChannel, &channel, SHADER_UNIFORM_INT);
+        }
+    }
+
+    for (int i = channelCount; i < 4; i++) sm->lights[i] = -1;
+
+    // Evaluate the shadows of these lights once per texel of the mask
+    rlEnableFramebuffer(sm->maskId);
+    rlViewport(0, 0, maskWidth, maskHeight);
+    rlDisableDepthTest();
+    rlDisableColorBlend();
+
+    rlEnableShader(sm->shader.id);
+    rlSetUniformMatrix(sm->locInvViewProj, MatrixInvert(MatrixMultiply(matView, matProj)));
+    rlSetUniform(sm->locViewPos, &camera.position, SHADER_UNIFORM_VEC3, 1);
+
+    rlActiveTextureSlot(RLG_SHADOW_MASK_UNIT_DEPTH);
+    rlEnableTexture(sm->depth.id);
+
+    for (int i = 0; i < 4; i++)
+    {
+        const struct RLG_ShadowMaskLight *locs = &sm->locs[i];
+        int enabled = (sm->lights[i] >= 0);
+        rlSetUniform(locs->enabled, &enabled, SHADER_UNIFORM_INT, 1);
+
+        if (!enabled)
+        {
+            continue;
+        }
+
+        const struct RLG_Light *l = &rlgCtx->lights[sm->lights[i]];
+        const struct RLG_ShadowMap *shadowMap = &l->data.shadowMap;
+
+        rlSetUniformMatrix(locs->vpMatrix, shadowMap->viewProj);
+        rlSetUniform(locs->position, &l->data.position, SHADER_UNIFORM_VEC3, 1);
+        rlSetUniform(locs->direction, &l->data.direction, SHADER_UNIFORM_VEC3, 1);
+        rlSetUniform(locs->shadowMapTxlSz, &l->data.shadowMapTxlSz, SHADER_UNIFORM_FLOAT, 1);
+        rlSetUniform(locs->depthBias, &l->data.depthBias, SHADER_UNIFORM_FLOAT, 1);
+        rlSetUniform(locs->shadowDepthParams, &shadowMap->depthParams, SHADER_UNIFORM_VEC2, 1);
+        rlSetUniform(locs->type, &l->data.type, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowTechnique, &l->data.shadowTechnique, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->omniShadowMode, &l->data.omniShadowMode, SHADER_UNIFORM_INT, 1);
+
+        // Same binding as RLG_DrawMesh, the samplers of the other types stay parked
+        int unit = 1 + i;
+        int parkMap = RLG_SHADOW_MASK_PARK_UNIT_2D, parkCubemap = RLG_SHADOW_MASK_PARK_UNIT_CUBE;
+        int parkMoments = RLG_SHADOW_MASK_PARK_UNIT_MOMENTS;
+        rlActiveTextureSlot(unit);
+
+        if (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_CUBE)
+        {
+            rlEnableTextureCubemap(shadowMap->depth.id);
+            rlSetUniform(locs->shadowCubemap, &unit, SHADER_UNIFORM_INT, 1);
+            rlSetUniform(locs->shadowMap, &parkMap, SHADER_UNIFORM_INT, 1);
+            rlSetUniform(locs->shadowMoments, &parkMoments, SHADER_UNIFORM_INT, 1);
+        }
+        else if (l->data.shadowTechnique != RLG_SHADOW_TECHNIQUE_PCF && shadowMap->momentsId != 0)
+        {
+            rlEnableTexture(shadowMap->moments.id);
+            rlSetUniform(locs->shadowMoments, &unit, SHADER_UNIFORM_INT, 1);
+            rlSetUniform(locs->shadowMap, &parkMap, SHADER_UNIFORM_INT, 1);
+            rlSetUniform(locs->shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT, 1);
+        }
+        else
+        {
+            rlEnableTexture(shadowMap->depth.id);
+            rlSetUniform(locs->shadowMap, &unit, SHADER_UNIFORM_INT, 1);
+            rlSetUniform(locs->shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT, 1);
+            rlSetUniform(locs->shadowMoments, &parkMoments, SHADER_UNIFORM_INT, 1);
+        }
+    }
+
+    rlEnableVertexArray(sm->vaoId);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    rlDisableVertexArray();
+
+    // Unbind the textures of the mask pass
+    for (int i = 0; i < 4; i++)
+    {
+        if (sm->lights[i] < 0) continue;
+
+        rlActiveTextureSlot(1 + i);
+        if (rlgGetShadowStorage(&rlgCtx->lights[sm->lights[i]]) == RLG_SHADOW_STORAGE_DEPTH_CUBE) rlDisableTextureCubemap();
+        else rlDisableTexture();
+    }
+
+    rlActiveTextureSlot(RLG_SHADOW_MASK_UNIT_DEPTH);
+    rlDisableTexture();
+    rlDisableShader();
+
+    // The lighting shader compares the depth of its fragments with the depth of the mask texels,
+    // it only needs the terms of the inverse projection giving the view depth from the NDC depth
+    Matrix invProj = MatrixInvert(matProj);
+    Vector4 depthParams = { invProj.m10, invProj.m14, invProj.m11, invProj.m15 };
+    int useShadowMask = (channelCount > 0);
+
+    SetShaderValue(lightShader, sm->locLightingDepthParams, &depthParams, SHADER_UNIFORM_VEC4);
+    SetShaderValue(lightShader, sm->locLightingUse, &useShadowMask, SHADER_UNIFORM_INT);
+
+    // Restore the previous render target and projection
+    rlEnableColorBlend();
+    rlEnableDepthTest();
+    rlEnableFramebuffer((unsigned int)previousFramebuffer);
+    rlViewport(0, 0, width, height);
+    rlMatrixMode(RL_PROJECTION);
+    rlPopMatrix();
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+#else
+    (void)camera;
+#endif
+}
+
+Texture RLG_GetShadowMask(void)
+{
+    return rlgCtx->shadowMask.mask;
+}
+
+Texture RLG_GetShadowMap(unsigned int light)
+{
+    if (light >= rlgCtx->lightCount)
+    {
+        // Log an error if the light ID exceeds the number of allocated lights
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowMap' exceeds allocated number [MAX %i]", light, rlgCtx->lightCount);
+        return (Texture){0};
+    }
+
+    return rlgCtx->lights[light].data.shadowMap.depth;
+}
+
+unsigned int RLG_AddShadowCaster(Model model, Matrix transform, unsigned int flags)
+{
+    // Look for a free slot in the caster array
+    unsigned int index = 0;
+    while (index < rlgCtx->casterCapacity && rlgCtx->casters[index].used) index++;
+
+    // Grow the caster array if it is full
+    if (index == rlgCtx->casterCapacity)
+    {
+        unsigned int capacity = (rlgCtx->casterCapacity == 0) ? 16 : 2*rlgCtx->casterCapacity;
+        struct RLG_ShadowCaster *casters = (struct RLG_ShadowCaster*)realloc(
+            rlgCtx->casters, capacity*sizeof(struct RLG_ShadowCaster));
+
+        if (!casters)
+        {
+            TraceLog(LOG_ERROR, "Heap allocation for shadow casters failed!");
+            return 0;
+        }
+
+        memset(casters + rlgCtx->casterCapacity, 0,
+            (capacity - rlgCtx->casterCapacity)*sizeof(struct RLG_ShadowCaster));
+
+        rlgCtx->casters = casters;
+        rlgCtx->casterCapacity = capacity;
+    }
+
+    struct RLG_ShadowCaster *caster = &rlgCtx->casters[index];
+
+    // Compute the bounds of all meshes in model space
+    caster->localBounds = (BoundingBox){ 0 };
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        BoundingBox box = GetMeshBoundingBox(model.meshes[i]);
+
+        if (i == 0) caster->localBounds = box;
+        else
+        {
+            caster->localBounds.min = Vector3Min(caster->localBounds.min, box.min);
+            caster->localBounds.max = Vector3Max(caster->localBounds.max, box.max);
+        }
+    }
+
+    caster->model = model;
+    caster->flags = (flags & RLG_CAST_ALL) ? flags : (flags | RLG_CAST_ALL);
+    caster->faceMask = 0;
+    caster->used = true;
+
+    RLG_SetShadowCasterTransform(index + 1, transform);
+
+    return index + 1;
+}
+
+void RLG_RemoveShadowCaster(unsigned int caster)
+{
+    if (caster == 0 || caster > rlgCtx->casterCapacity || !rlgCtx->casters[caster - 1].used)
+    {
+        TraceLog(LOG_ERROR, "Shadow caster [ID %i] specified to 'RLG_RemoveShadowCaster' is not valid", caster);
+        return;
+    }
+
+    rlgCtx->casters[caster - 1] = (struct RLG_ShadowCaster){ 0 };
+}
+
+void RLG_SetShadowCasterTransform(unsigned int caster, Matrix transform)
+{
+    if (caster == 0 || caster > rlgCtx->casterCapacity || !rlgCtx->casters[caster - 1].used)
+    {
+        TraceLog(LOG_ERROR, "Shadow caster [ID %i] specified to 'RLG_SetShadowCasterTransform' is not valid", caster);
+        return;
+    }
+
+    struct RLG_ShadowCaster *c = &rlgCtx->casters[caster - 1];
+
+    // Same combination as RLG_CastModelEx, the model transform is applied first
+    c->transform = MatrixMultiply(c->model.transform, transform);
+    c->bounds = rlgTransformBoundingBox(c->localBounds, c->transform);
+}
+
+void RLG_UsePositionStreams(bool active)
+{
+    rlgCtx->positionStreams.active = active;
+}
+
+bool RLG_IsPositionStreamsUsed(void)
+{
+    return rlgCtx->positionStreams.active;
+}
+
+void RLG_UseQuantizedPositions(bool active)
+{
+    if (rlgCtx->positionStreams.quantized == active) return;
+
+    // The streams already built have the other format, they are rebuilt when needed
+    for (unsigned int i = 0; i < rlgCtx->positionStreams.count; i++)
+    {
+        rlgUnloadPositionStream(&rlgCtx->positionStreams.streams[i]);
+    }
+
+    rlgCtx->positionStreams.count = 0;
+    rlgCtx->positionStreams.quantized = active;
+}
+
+bool RLG_IsQuantizedPositionsUsed(void)
+{
+    return rlgCtx->positionStreams.quantized;
+}
+
+void RLG_UnloadPositionStream(Mesh mesh)
+{
+    if (mesh.vboId == NULL) return;
+
+    unsigned int index = rlgFindPositionStream(mesh.vboId[0]);
+    struct RLG_PositionStream *streams = rlgCtx->positionStreams.streams;
+
+    if (index < rlgCtx->positionStreams.count && streams[index].meshVboId == mesh.vboId[0])
+    {
+        rlgUnloadPositionStream(&streams[index]);
+        rlgCtx->positionStreams.count--;
+        memmove(&streams[index], &streams[index + 1],
+            (rlgCtx->positionStreams.count - index)*sizeof(struct RLG_PositionStream));
+    }
+}
+
+void RLG_CastMesh(Shader shader, Mesh mesh, Matrix transform)
+{
+    // Bind shader program
+    rlEnableShader(shader.id);
+
+    // Bind the vertex data, the position stream may need its own transform
+    transform = MatrixMultiply(rlgEnableCastVertexArray(shader, mesh), transform);
+
+    // Get a copy of current matrices to work with,
+    // just in case stereo render is required, and we need to modify them
+    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
+    // That's because BeginMode3D() sets it and there is no model-drawing function
+    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
+    Matrix matModel = MatrixIdentity();
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matModelView = MatrixIdentity();
+    Matrix matProjection = rlGetMatrixProjection();
+
+    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
+    if (shader.locs[RLG_LOC_MATRIX_MODEL] != -1)
+        rlSetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MODEL], transform);
+
+    // Accumulate several model transformations:
+    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
+    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
+    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+
+    // Get model-view matrix
+    matModelView = MatrixMultiply(matModel, matView);
+
+    int eyeCount = rlIsStereoRenderEnabled() ? 2 : 1;
+
+    for (int eye = 0; eye < eyeCount; eye++)
+    {
+        // Calculate model-view-projection matrix (MVP)
+        Matrix matModelViewProjection = MatrixIdentity();
+        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
+        else
+        {
+            // Setup current eye viewport (half screen width)
+            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
+            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+        }
+
+        // Send combined model-view-projection matrix to shader
+        rlSetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+
+        // Draw mesh
+        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
+        else rlDrawVertexArray(0, mesh.vertexCount);
+    }
+
+    // Disable all possible vertex array objects (or VBOs)
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+
+    // Disable shader program
+    rlDisableShader();
+
+    // Restore rlgl internal modelview and projection matrices
+    rlSetMatrixModelview(matView);
+    rlSetMatrixProjection(matProjection);
+}
+
+void RLG_CastModel(Shader shader, Model model, Vector3 position, float scale)
+{
+    Vector3 vScale = { scale, scale, scale };
+    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+
+    RLG_CastModelEx(shader, model, position, rotationAxis, 0.0f, vScale);
+}
+
+void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale)
+{
+    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
+    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
+    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+
+    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
+    model.transform = MatrixMultiply(model.transform, matTransform);
+
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        RLG_CastMesh(shader, model.meshes[i], model.transform);
+    }
+}
+
+void RLG_UseDepthPrepass(bool active)
+{
+    rlgCtx->depthPrepass.active = active;
+    if (!active) rlgCtx->depthPrepass.filled = false;
+}
+
+bool RLG_IsDepthPrepassUsed(void)
+{
+    return rlgCtx->depthPrepass.active;
+}
+
+void RLG_DrawDepthPrepass(RLG_DrawFunc drawFunc)
+{
+    rlgCtx->depthPrepass.filled = false;
+    if (!rlgCtx->depthPrepass.active) return;
+
+    // Draw the pending batch with the current state
+    rlDrawRenderBatchActive();
+
+    // Only the depth is written, the depth shader has no color output
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    rlgCtx->depthPrepass.drawing = true;
+    drawFunc(rlgCtx->shaders[RLG_SHADER_DEPTH]);
+    rlgCtx->depthPrepass.drawing = false;
+
+    rlDrawRenderBatchActive();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // Only the draws into this framebuffer rely on the pre-pass, a render texture keeps its own depth
+    GLint framebufferId = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferId);
+
+    rlgCtx->depthPrepass.filled = true;
+    rlgCtx->depthPrepass.framebufferId = framebufferId;
+}
+
+void RLG_EndDepthPrepass(void)
+{
+    rlgCtx->depthPrepass.filled = false;
+}
+
+static float rlgGetCutOffCosine(float angle)
+{
+    // Same value as the one sent to the lighting shader, the initial -1 is already a cosine
+    return (angle == -1.0f) ? angle : cosf(angle*DEG2RAD);
+}
+
+static bool rlgSetLightUniforms(const struct RLG_LightLocs *locs, const struct RLG_Light *l,
+    int unit, int parkMap, int parkCubemap, int parkMoments)
+{
+    // Sends a light to the slot of a shader evaluating one light, its shadow map is bound to 'unit'
+    // NOTE: The cutoffs are stored in degrees but sent as cosines
+    float innerCutOff = rlgGetCutOffCosine(l->data.innerCutOff);
+    float outerCutOff = rlgGetCutOffCosine(l->data.outerCutOff);
+
+    rlSetUniform(locs->position, &l->data.position, SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(locs->direction, &l->data.direction, SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(locs->color, &l->data.color, SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(locs->energy, &l->data.energy, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->specular, &l->data.specular, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->size, &l->data.size, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->innerCutOff, &innerCutOff, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->outerCutOff, &outerCutOff, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->constant, &l->data.constant, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->linear, &l->data.linear, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->quadratic, &l->data.quadratic, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->type, &l->data.type, SHADER_UNIFORM_INT, 1);
+
+    // Same shadow state as the one sent to the lighting shader
+    const struct RLG_ShadowMap *shadowMap = &l->data.shadowMap;
+    int shadow = l->data.shadow && !l->data.shadowFadedOut && shadowMap->id != 0;
+    rlSetUniform(locs->shadow, &shadow, SHADER_UNIFORM_INT, 1);
+
+    if (!shadow)
+    {
+        return false;
+    }
+
+    rlSetUniformMatrix(locs->vpMatrix, shadowMap->viewProj);
+    rlSetUniform(locs->shadowMapTxlSz, &l->data.shadowMapTxlSz, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->depthBias, &l->data.depthBias, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->shadowDepthParams, &shadowMap->depthParams, SHADER_UNIFORM_VEC2, 1);
+    rlSetUniform(locs->shadowFade, &l->data.shadowFade, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(locs->shadowTechnique, &l->data.shadowTechnique, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(locs->omniShadowMode, &l->data.omniShadowMode, SHADER_UNIFORM_INT, 1);
+
+    // The samplers of the other types are parked, so that they never share the unit
+    rlActiveTextureSlot(unit);
+
+    if (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_CUBE)
+    {
+        rlEnableTextureCubemap(shadowMap->depth.id);
+        rlSetUniform(locs->shadowCubemap, &unit, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowMap, &parkMap, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowMoments, &parkMoments, SHADER_UNIFORM_INT, 1);
+    }
+    else if (l->data.shadowTechnique != RLG_SHADOW_TECHNIQUE_PCF && shadowMap->momentsId != 0)
+    {
+        rlEnableTexture(shadowMap->moments.id);
+        rlSetUniform(locs->shadowMoments, &unit, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowMap, &parkMap, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT, 1);
+    }
+    else
+    {
+        rlEnableTexture(shadowMap->depth.id);
+        rlSetUniform(locs->shadowMap, &unit, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(locs->shadowMoments, &parkMoments, SHADER_UNIFORM_INT, 1);
+    }
+
+    return true;
+}
+
+static void rlgUnbindLightShadow(const struct RLG_Light *l, int unit)
+{
+    rlActiveTextureSlot(unit);
+
+    if (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_CUBE) rlDisableTextureCubemap();
+    else rlDisableTexture();
+}
+
+static void rlgSyncMaterialState(Shader shader, const int *locUseMaps, int locParallaxMinLayers, int locParallaxMaxLayers)
+{
+    // The uniforms of the material and of the view are only sent to the lighting shader by their setters
+    rlEnableShader(shader.id);
+
+    for (int i = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
+    {
+        rlSetUniform(locUseMaps[i], &rlgCtx->material.data.useMaps[i], SHADER_UNIFORM_INT, 1);
+    }
+
+    rlSetUniform(locParallaxMinLayers, &rlgCtx->material.data.parallaxMinLayers, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(locParallaxMaxLayers, &rlgCtx->material.data.parallaxMaxLayers, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(shader.locs[RLG_LOC_COLOR_AMBIENT], &rlgCtx->colAmbient, SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(shader.locs[RLG_LOC_VECTOR_VIEW], &rlgCtx->viewPos, SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(shader.locs[RLG_LOC_IRRADIANCE_SH], rlgCtx->irradianceSH, SHADER_UNIFORM_VEC3, 9);
+    rlSetUniform(shader.locs[RLG_LOC_USE_IRRADIANCE_SH], &rlgCtx->useIrradianceSH, SHADER_UNIFORM_INT, 1);
+}
+
+void RLG_UseDeferred(bool active)
+{
+    struct RLG_Deferred *d = &rlgCtx->deferred;
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    // The deferred shaders are only loaded the first time they are requested
+    if (active && !d->loaded)
+    {
+        rlgLoadDeferredShaders();
+        d->loaded = true;
+    }
+#endif
+
+    bool supported = (d->light.id > 0);
+    if (active && !supported)
+    {
+        TraceLog(LOG_WARNING, "The deferred shading path is not supported, the scene will be drawn with the forward lighting shader");
+    }
+
+    d->active = active && supported;
+}
+
+bool RLG_IsDeferredUsed(void)
+{
+    return rlgCtx->deferred.active;
+}
+
+void RLG_BeginDeferred(void)
+{
+    struct RLG_Deferred *d = &rlgCtx->deferred;
+
+    if (!d->active || d->drawing)
+    {
+        return;
+    }
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    // Draw the pending batch into the render target of the scene
+    rlDrawRenderBatchActive();
+
+    // NOTE: Loading the targets unbinds the current framebuffer
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    d->previousFramebuffer = (unsigned int)previousFramebuffer;
+
+    // The G-buffer covers the current render target
+    int width = rlGetFramebufferWidth();
+    int height = rlGetFramebufferHeight();
+
+    if (d->depth.width != width || d->depth.height != height)
+    {
+        rlgLoadDeferredTargets(width, height);
+    }
+
+    rlEnableFramebuffer(d->framebufferId);
+    rlViewport(0, 0, width, height);
+
+    // The targets are cleared to zero whatever the clear color of rlgl
+    const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float one = 1.0f;
+    for (int i = 0; i < 3; i++) glClearBufferfv(GL_COLOR, i, zero);
+    glClearBufferfv(GL_DEPTH, 0, &one);
+
+    // The alpha channels hold attributes of the surfaces, they must not be blended
+    rlDisableColorBlend();
+
+    rlgSyncMaterialState(d->gbuffer, d->locUseMaps, d->locParallaxMinLayers, d->locParallaxMaxLayers);
+    rlDisableShader();
+
+    d->drawing = true;
+#endif
+}
+
+void RLG_EndDeferred(void)
+{
+    struct RLG_Deferred *d = &rlgCtx->deferred;
+
+    if (!d->drawing)
+    {
+        return;
+    }
+
+#if !defined(NO_EMBEDDED_SHADERS) && (GLSL_VERSION >= 330)
+    rlDrawRenderBatchActive();
+    d->drawing = false;
+
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matProj = rlGetMatrixProjection();
+    Matrix viewProj = MatrixMultiply(matView, matProj);
+
+    // Back to the render target of the scene
+    rlEnableFramebuffer(d->previousFramebuffer);
+    rlViewport(0, 0, d->depth.width, d->depth.height);
+
+    rlActiveTextureSlot(RLG_DEFERRED_UNIT_ALBEDO);
+    rlEnableTexture(d->albedo.id);
+    rlActiveTextureSlot(RLG_DEFERRED_UNIT_NORMAL);
+    rlEnableTexture(d->normal.id);
+    rlActiveTextureSlot(RLG_DEFERRED_UNIT_LIGHTING);
+    rlEnableTexture(d->lighting.id);
+    rlActiveTextureSlot(RLG_DEFERRED_UNIT_DEPTH);
+    rlEnableTexture(d->depth.id);
+
+    // Copy the lighting of the G-buffer pass along with its depth
+    rlEnableDepthTest();
+    glDepthFunc(GL_ALWAYS);
+
+    rlEnableShader(d->composite.id);
+    rlEnableVertexArray(d->vaoId);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Then add the light of each light, the depth test keeps the surfaces within its volume:
+    // the back faces of the volume are drawn where they are behind the surface, clamped to the far plane
+    GLint blendSrcRGB = 0, blendDstRGB = 0, blendSrcAlpha = 0, blendDstAlpha = 0;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRGB);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRGB);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+
+    rlEnableColorBlend();
+    glBlendFunc(GL_ONE, GL_ONE);
+    rlDisableDepthMask();
+    glEnable(GL_DEPTH_CLAMP);
+    rlEnableBackfaceCulling();
+    glCullFace(GL_FRONT);
+
+    rlEnableShader(d->light.id);
+    rlSetUniformMatrix(d->locInvViewProj, MatrixInvert(viewProj));
+    rlSetUniform(d->locViewPos, &rlgCtx->viewPos, SHADER_UNIFORM_VEC3, 1);
+
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+
+        if (!l->data.enabled)
+        {
+            continue;
+        }
+
+        // Lights whose energy is too low to be seen anywhere are skipped
+        float range = rlgGetLightRange(l);
+        bool fullscreen = (l->data.type == RLG_DIRLIGHT) || (range < 0.0f);
+
+        if (!fullscreen && range == 0.0f)
+        {
+            continue;
+        }
+
+        // Same binding as RLG_DrawMesh, the samplers of the other types stay parked
+        bool shadow = rlgSetLightUniforms(&d->lightLocs, l, RLG_DEFERRED_UNIT_SHADOW,
+            RLG_DEFERRED_PARK_UNIT_2D, RLG_DEFERRED_PARK_UNIT_CUBE, RLG_DEFERRED_PARK_UNIT_MOMENTS);
+
+        int fullscreenValue = fullscreen;
+        rlSetUniform(d->locFullscreen, &fullscreenValue, SHADER_UNIFORM_INT, 1);
+
+        if (fullscreen)
+        {
+            // Directional and unattenuated lights reach every surface,
+            // the fullscreen triangle faces the camera so it must not be culled
+            rlDisableDepthTest();
+            rlDisableBackfaceCulling();
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            rlEnableBackfaceCulling();
+            rlEnableDepthTest();
+        }
+        else
+        {
+            Vector3 position = l->data.position;
+            float cosAngle = rlgGetCutOffCosine(l->data.outerCutOff);
+            Matrix transform = { 0 };
+            int first = 0, count = d->sphereVertexCount;
+
+            // A cone is only tighter than the sphere for the narrow spotlights
+            if (l->data.type == RLG_SPOTLIGHT && cosAngle > 0.5f)
+            {
+                float radius = range*sqrtf(1.0f - cosAngle*cosAngle)/cosAngle;
+                Vector3 z = Vector3Normalize(l->data.direction);
+                Vector3 up = (fabsf(z.y) < 0.99f) ? (Vector3){ 0.0f, 1.0f, 0.0f } : (Vector3){ 1.0f, 0.0f, 0.0f };
+                Vector3 x = Vector3Normalize(Vector3CrossProduct(up, z));
+                Vector3 y = Vector3CrossProduct(z, x);
+
+                transform = (Matrix){
+                    x.x*radius, y.x*radius, z.x*range, position.x,
+                    x.y*radius, y.y*radius, z.y*range, position.y,
+                    x.z*radius, y.z*radius, z.z*range, position.z,
+                    0.0f, 0.0f, 0.0f, 1.0f
+                };
+
+                first = d->sphereVertexCount;
+                count = d->coneVertexCount;
+            }
+            else
+            {
+                transform = MatrixMultiply(MatrixScale(range, range, range), MatrixTranslate(position.x, position.y, position.z));
+            }
+
+            glDepthFunc(GL_GEQUAL);
+            rlSetUniformMatrix(d->locMvp, MatrixMultiply(transform, viewProj));
+            glDrawArrays(GL_TRIANGLES, first, count);
+        }
+
+        if (shadow) rlgUnbindLightShadow(l, RLG_DEFERRED_UNIT_SHADOW);
+    }
+
+    rlDisableVertexArray();
+    rlDisableShader();
+
+    for (int i = RLG_DEFERRED_UNIT_ALBEDO; i <= RLG_DEFERRED_UNIT_DEPTH; i++)
+    {
+        rlActiveTextureSlot(i);
+        rlDisableTexture();
+    }
+
+    // Restore the state of rlgl
+    glBlendFuncSeparate(blendSrcRGB, blendDstRGB, blendSrcAlpha, blendDstAlpha);
+    glDisable(GL_DEPTH_CLAMP);
+    glCullFace(GL_BACK);
+    if (!cullFace) rlDisableBackfaceCulling();
+    glDepthFunc(GL_LEQUAL);
+    rlEnableDepthMask();
+#endif
+}
+
+// Texture unit of the shadow map of the light drawn by a pass, the one of the first light of the lighting shader
+#define RLG_MULTI_PASS_UNIT_SHADOW  11
+
+static void rlgLoadMultiPassShader(void)
+{
+#ifndef NO_EMBEDDED_SHADERS
+    struct RLG_MultiPass *mp = &rlgCtx->multiPass;
+
+    // The lighting shader is built for one light, its slot receives each light in turn
+    static const char multiPassDefine[] = "#define MULTI_PASS\n";
+
+    char *fs = (char*)malloc(sizeof(rlgLightingFS) + sizeof(multiPassDefine));
+    snprintf(fs, sizeof(rlgLightingFS) + sizeof(multiPassDefine), rlgLightingFS, 1, multiPassDefine);
+
+#   if GLSL_VERSION > 100
+    char *vs = (char*)malloc(sizeof(rlgLightingVS));
+    snprintf(vs, sizeof(rlgLightingVS), rlgLightingVS, 1);
+    mp->shader.id = rlLoadShaderCode(vs, fs);
+    free(vs);
+#   else
+    mp->shader.id = rlLoadShaderCode(rlgLightingVS, fs);
+#   endif
+
+    free(fs);
+
+    // NOTE: rlgl falls back to the default shader when the compilation fails
+    if (mp->shader.id == rlGetShaderIdDefault())
+    {
+        mp->shader.id = 0;
+        return;
+    }
+
+    // Same locations as the lighting shader, so that RLG_DrawMesh can draw with both
+    rlgGetLightingLocations(&mp->shader);
+
+    unsigned int id = mp->shader.id;
+    for (int i = 0, mapID = 0, cubemapID = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
+    {
+        if (i == MATERIAL_MAP_CUBEMAP || i == MATERIAL_MAP_IRRADIANCE || i == MATERIAL_MAP_PREFILTER)
+        {
+            mp->locUseMaps[i] = rlGetLocationUniform(id, TextFormat("cubemaps[%i].active", cubemapID));
+            cubemapID++;
+        }
+        else
+        {
+            mp->locUseMaps[i] = rlGetLocationUniform(id, TextFormat("maps[%i].active", mapID));
+            mapID++;
+        }
+    }
+
+    mp->locParallaxMinLayers = rlGetLocationUniform(id, "parallaxMinLayers");
+    mp->locParallaxMaxLayers = rlGetLocationUniform(id, "parallaxMaxLayers");
+    mp->locLightPass = rlGetLocationUniform(id, "lightPass");
+
+    rlgGetLightLocations(id, 0, &mp->lightLocs);
+
+    // NOTE: Two samplers of different types referring to the same unit make draws fail
+    int parkMap = RLG_SHADOW_PARK_UNIT_2D, parkCubemap = RLG_SHADOW_PARK_UNIT_CUBE;
+    int parkMoments = RLG_SHADOW_PARK_UNIT_MOMENTS;
+    SetShaderValue(mp->shader, mp->lightLocs.shadowMap, &parkMap, SHADER_UNIFORM_INT);
+    SetShaderValue(mp->shader, mp->lightLocs.shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT);
+    SetShaderValue(mp->shader, mp->lightLocs.shadowMoments, &parkMoments, SHADER_UNIFORM_INT);
+
+    // The passes of the lights never read the shadow mask
+    int shadowMaskChannel = -1;
+    SetShaderValue(mp->shader, mp->lightLocs.shadowMaskChannel, &shadowMaskChannel, SHADER_UNIFORM_INT);
+#endif
+}
+
+void RLG_UseMultiPass(bool active)
+{
+    struct RLG_MultiPass *mp = &rlgCtx->multiPass;
+
+    // The shader is only loaded the first time it is requested
+    if (active && !mp->loaded)
+    {
+        rlgLoadMultiPassShader();
+        mp->loaded = true;
+    }
+
+    bool supported = (mp->shader.id > 0);
+    if (active && !supported)
+    {
+        TraceLog(LOG_WARNING, "The multi-pass lighting is not supported, the scene will be drawn with the lighting shader");
+    }
+
+    mp->active = active && supported;
+}
+
+bool RLG_IsMultiPassUsed(void)
+{
+    return rlgCtx->multiPass.active;
+}
+
+static bool rlgGetScreenRect(BoundingBox box, Matrix viewProj, int width, int height, int rect[4])
+{
+    // Bounds of the projected corners of the box, in normalized device coordinates
+    Vector2 min = { 1.0f, 1.0f };
+    Vector2 max = { -1.0f, -1.0f };
+    const Matrix m = viewProj;
+
+    for (int i = 0; i < 8; i++)
+    {
+        float x = (i & 1) ? box.max.x : box.min.x;
+        float y = (i & 2) ? box.max.y : box.min.y;
+        float z = (i & 4) ? box.max.z : box.min.z;
+
+        float w = m.m3*x + m.m7*y + m.m11*z + m.m15;
+
+        // A box reaching behind the camera may cover any part of the screen
+        if (w <= 0.0f)
+        {
+            rect[0] = 0, rect[1] = 0;
+            rect[2] = width, rect[3] = height;
+            return true;
+        }
+
+        float cx = (m.m0*x + m.m4*y + m.m8*z + m.m12)/w;
+        float cy = (m.m1*x + m.m5*y + m.m9*z + m.m13)/w;
+
+        min.x = fminf(min.x, cx), min.y = fminf(min.y, cy);
+        max.x = fmaxf(max.x, cx), max.y = fmaxf(max.y, cy);
+    }
+
+    min.x = fmaxf(min.x, -1.0f), min.y = fmaxf(min.y, -1.0f);
+    max.x = fminf(max.x, 1.0f), max.y = fminf(max.y, 1.0f);
+
+    // Pixels covered by the rectangle, empty when the box is off screen
+    int x0 = (int)floorf((min.x*0.5f + 0.5f)*width);
+    int y0 = (int)floorf((min.y*0.5f + 0.5f)*height);
+    int x1 = (int)ceilf((max.x*0.5f + 0.5f)*width);
+    int y1 = (int)ceilf((max.y*0.5f + 0.5f)*height);
+
+    if (x1 <= x0 || y1 <= y0)
+    {
+        return false;
+    }
+
+    rect[0] = x0, rect[1] = y0;
+    rect[2] = x1 - x0, rect[3] = y1 - y0;
+
+    return true;
+}
+
+static void rlgDrawMeshLightPasses(Mesh mesh, BoundingBox bounds, bool bounded, Matrix viewProj, bool scissor)
+{
+    const struct RLG_MultiPass *mp = &rlgCtx->multiPass;
+
+    // The lights are added to the base pass, on its visible fragments only
+    GLint blendSrcRGB = 0, blendDstRGB = 0, blendSrcAlpha = 0, blendDstAlpha = 0;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRGB);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRGB);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+
+    GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    GLint scissorBox[4] = { 0 };
+    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+
+    rlEnableColorBlend();
+    glBlendFunc(GL_ONE, GL_ONE);
+    glDepthFunc(GL_EQUAL);
+    rlDisableDepthMask();
+    if (scissor) rlEnableScissorTest();
+
+    int lightPass = 1;
+    rlSetUniform(mp->locLightPass, &lightPass, SHADER_UNIFORM_INT, 1);
+
+    int width = rlGetFramebufferWidth();
+    int height = rlGetFramebufferHeight();
+
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+
+        if (!l->data.enabled)
+        {
+            continue;
+        }
+
+        // Part of the mesh within the range of the light, directional and unattenuated lights reach all of it
+        BoundingBox box = bounds;
+        bool boxed = bounded;
+        float range = rlgGetLightRange(l);
+
+        if (l->data.type != RLG_DIRLIGHT && range >= 0.0f)
+        {
+            // Lights whose energy is too low to be seen anywhere are skipped
+            if (range == 0.0f) continue;
+
+            BoundingBox lightBox = {
+                Vector3SubtractValue(l->data.position, range),
+                Vector3AddValue(l->data.position, range)
+            };
+
+            if (boxed)
+            {
+                box.min = Vector3Max(box.min, lightBox.min);
+                box.max = Vector3Min(box.max, lightBox.max);
+
+                if (box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z) continue;
+            }
+            else
+            {
+                box = lightBox;
+                boxed = true;
+            }
+        }
+
+        if (scissor)
+        {
+            int rect[4] = { 0, 0, width, height };
+            if (boxed && !rlgGetScreenRect(box, viewProj, width, height, rect)) continue;
+            rlScissor(rect[0], rect[1], rect[2], rect[3]);
+        }
+
+        bool shadow = rlgSetLightUniforms(&mp->lightLocs, l, RLG_MULTI_PASS_UNIT_SHADOW,
+            RLG_SHADOW_PARK_UNIT_2D, RLG_SHADOW_PARK_UNIT_CUBE, RLG_SHADOW_PARK_UNIT_MOMENTS);
+
+        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
+        else rlDrawVertexArray(0, mesh.vertexCount);
+
+        if (shadow) rlgUnbindLightShadow(l, RLG_MULTI_PASS_UNIT_SHADOW);
+    }
+
+    // Restore the state of rlgl, the caller restores the depth state
+    lightPass = 0;
+    rlSetUniform(mp->locLightPass, &lightPass, SHADER_UNIFORM_INT, 1);
+
+    glBlendFuncSeparate(blendSrcRGB, blendDstRGB, blendSrcAlpha, blendDstAlpha);
+    glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    if (!scissorTest) rlDisableScissorTest();
+}
+
+// Find the smallest complete reflection probe whose box contains a point, NULL if there is none
+static const struct RLG_ReflectionProbe *rlgSelectReflectionProbe(Vector3 point)
+{
+    const struct RLG_ReflectionProbe *selected = NULL;
+    float selectedVolume = 0.0f;
+
+    for (unsigned int i = 0; i < rlgCtx->reflectionProbes.capacity; i++)
+    {
+        const struct RLG_ReflectionProbe *probe = &rlgCtx->reflectionProbes.probes[i];
+        if (!probe->used || !probe->complete) continue;
+
+        const BoundingBox *box = &probe->box;
+        if (point.x < box->min.x || point.y < box->min.y || point.z < box->min.z) continue;
+        if (point.x > box->max.x || point.y > box->max.y || point.z > box->max.z) continue;
+
+        Vector3 extent = Vector3Subtract(box->max, box->min);
+        float volume = extent.x*extent.y*extent.z;
+
+        if (selected == NULL || volume < selectedVolume)
+        {
+            selected = probe;
+            selectedVolume = volume;
+        }
+    }
+
+    return selected;
+}
+
+void RLG_DrawMesh(Mesh mesh, Material material, Matrix transform)
+{
+    // The captures of the reflection probes are lit by the forward lighting shader alone
+    bool capturing = rlgCtx->reflectionProbes.capturing;
+
+    // Between RLG_BeginDeferred and RLG_EndDeferred, the surfaces are written to the G-buffer
+    bool deferred = rlgCtx->deferred.drawing && !capturing;
+    const Shader *shader = deferred ? &rlgCtx->deferred.gbuffer : &rlgCtx->shaders[RLG_SHADER_LIGHTING];
+
+    // Otherwise the multi-pass lighting draws the base pass, then each light with its own pass
+    const struct RLG_MultiPass *mp = &rlgCtx->multiPass;
+    bool multiPass = mp->active && !deferred && !capturing;
+    if (multiPass)
+    {
+        shader = &mp->shader;
+        rlgSyncMaterialState(*shader, mp->locUseMaps, mp->locParallaxMinLayers, mp->locParallaxMaxLayers);
+    }
+
+    // The lights of the lighting shader are all evaluated by this draw
+    bool allLights = !deferred && !multiPass;
+
+    // Bind shader program
+    rlEnableShader(shader->id);
+
+    // Send required data to shader (matrices, values)
+    //-----------------------------------------------------
+    // Upload to shader material.data.colDiffuse
+    if (shader->locs[RLG_LOC_COLOR_DIFFUSE] != -1)
+    {
+        float values[4];
+
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_ALBEDO])
+        {
+            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.r/255.0f;
+            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.g/255.0f;
+            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.b/255.0f;
+            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.a/255.0f;
+        }
+        else
+        {
+            values[0] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.r/255.0f;
+            values[1] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.g/255.0f;
+            values[2] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.b/255.0f;
+            values[3] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.a/255.0f;
+        }
+
+        rlSetUniform(shader->locs[RLG_LOC_COLOR_DIFFUSE], values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    // Upload to shader material.data.colSpecular (if location available)
+    if (shader->locs[RLG_LOC_COLOR_SPECULAR] != -1)
+    {
+        float values[4];
+
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_METALNESS])
+        {
+            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.r/255.0f;
+            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.g/255.0f;
+            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.b/255.0f;
+            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.a/255.0f;
+        }
+        else
+        {
+            values[0] = (float)material.maps[MATERIAL_MAP_METALNESS].color.r/255.0f;
+            values[1] = (float)material.maps[MATERIAL_MAP_METALNESS].color.g/255.0f;
+            values[2] = (float)material.maps[MATERIAL_MAP_METALNESS].color.b/255.0f;
+            values[3] = (float)material.maps[MATERIAL_MAP_METALNESS].color.a/255.0f;
+        }
+
+        rlSetUniform(shader->locs[RLG_LOC_COLOR_SPECULAR], values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    // Upload to shader material.data.colEmission (if location available)
+    if (shader->locs[RLG_LOC_COLOR_EMISSION] != -1)
+    {
+        float values[4];
+
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_EMISSION])
+        {
+            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.r/255.0f;
+            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.g/255.0f;
+            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.b/255.0f;
+            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.a/255.0f;
+        }
+        else
+        {
+            values[0] = (float)material.maps[MATERIAL_MAP_EMISSION].color.r/255.0f;
+            values[1] = (float)material.maps[MATERIAL_MAP_EMISSION].color.g/255.0f;
+            values[2] = (float)material.maps[MATERIAL_MAP_EMISSION].color.b/255.0f;
+            values[3] = (float)material.maps[MATERIAL_MAP_EMISSION].color.a/255.0f;
+        }
+
+        rlSetUniform(shader->locs[RLG_LOC_COLOR_EMISSION], values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    // Upload to shader material.data.metalness (if location available)
+    if (shader->locs[RLG_LOC_METALNESS_SCALE] != -1)
+    {
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_METALNESS])
+        {
+            rlSetUniform(shader->locs[RLG_LOC_METALNESS_SCALE],
+                &rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+        else
+        {
+            rlSetUniform(shader->locs[RLG_LOC_METALNESS_SCALE],
+                &material.maps[MATERIAL_MAP_METALNESS].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+    }
+
+    // Upload to shader material.data.roughness (if location available)
+    if (shader->locs[RLG_LOC_ROUGHNESS_SCALE] != -1)
+    {
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_ROUGHNESS])
+        {
+            rlSetUniform(shader->locs[RLG_LOC_ROUGHNESS_SCALE],
+                &rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+        else
+        {
+            rlSetUniform(shader->locs[RLG_LOC_ROUGHNESS_SCALE],
+                &material.maps[MATERIAL_MAP_ROUGHNESS].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+    }
+
+    // Upload to shader material.data.aoLightAffect (if location available)
+    if (shader->locs[RLG_LOC_AO_LIGHT_AFFECT] != -1)
+    {
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_OCCLUSION])
+        {
+            rlSetUniform(shader->locs[RLG_LOC_AO_LIGHT_AFFECT],
+                &rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+        else
+        {
+            rlSetUniform(shader->locs[RLG_LOC_AO_LIGHT_AFFECT],
+                &material.maps[MATERIAL_MAP_OCCLUSION].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+    }
+
+    // Upload to shader material.data.heightScale (if location available)
+    if (shader->locs[RLG_LOC_HEIGHT_SCALE] != -1)
+    {
+        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_HEIGHT])
+        {
+            rlSetUniform(shader->locs[RLG_LOC_HEIGHT_SCALE],
+                &rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+        else
+        {
+            rlSetUniform(shader->locs[RLG_LOC_HEIGHT_SCALE],
+                &material.maps[MATERIAL_MAP_HEIGHT].value, SHADER_UNIFORM_FLOAT, 1);
+        }
+    }
+
+    // Get a copy of current matrices to work with,
+    // just in case stereo render is required, and we need to modify them
+    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
+    // That's because BeginMode3D() sets it and there is no model-drawing function
+    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
+    Matrix matModel = MatrixIdentity();
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matModelView = MatrixIdentity();
+    Matrix matProjection = rlGetMatrixProjection();
+
+    // Keep the projection scale to estimate the screen footprint of the lights
+    rlgCtx->projScale = 0.5f*matProjection.m5;
+
+    // Upload view matrix (if location available)
+    if (shader->locs[RLG_LOC_MATRIX_VIEW] != -1)
+        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_VIEW], matView);
+
+    // Upload projection matrix (if location available)
+    if (shader->locs[RLG_LOC_MATRIX_PROJECTION] != -1)
+        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_PROJECTION], matProjection);
+
+    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
+    if (shader->locs[RLG_LOC_MATRIX_MODEL] != -1)
+        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MODEL], transform);
+
+    // Accumulate several model transformations:
+    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
+    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
+    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+
+    // Get model-view matrix
+    matModelView = MatrixMultiply(matModel, matView);
+
+    // Upload model normal matrix (if locations available)
+    if (shader->locs[RLG_LOC_MATRIX_NORMAL] != -1)
+        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
+
+    // The reflection probe containing the origin of the mesh replaces the prefiltered radiance
+    const struct RLG_ReflectionProbe *probe = NULL;
+    if (!capturing && rlgCtx->material.data.useMaps[MATERIAL_MAP_PREFILTER])
+    {
+        probe = rlgSelectReflectionProbe((Vector3) { matModel.m12, matModel.m13, matModel.m14 });
+    }
+
+    if (shader->locs[RLG_LOC_USE_PROBE] != -1)
+    {
+        int useProbe = (probe != NULL);
+        rlSetUniform(shader->locs[RLG_LOC_USE_PROBE], &useProbe, SHADER_UNIFORM_INT, 1);
+
+        if (probe != NULL)
+        {
+            rlSetUniform(shader->locs[RLG_LOC_PROBE_POSITION], &probe->position, SHADER_UNIFORM_VEC3, 1);
+            rlSetUniform(shader->locs[RLG_LOC_PROBE_BOX_MIN], &probe->box.min, SHADER_UNIFORM_VEC3, 1);
+            rlSetUniform(shader->locs[RLG_LOC_PROBE_BOX_MAX], &probe->box.max, SHADER_UNIFORM_VEC3, 1);
+        }
+    }
+    //-----------------------------------------------------
+
+    // Bind active texture maps (if available)
+    for (int i = 0; i < 11; i++)
+    {
+        if (rlgCtx->material.data.useMaps[i])
+        {
+            int textureID = (rlgCtx->usedDefaultMaps[i])
+                ? rlgCtx->defaultMaps[i].texture.id
+                : material.maps[i].texture.id;
+
+            if ((i == MATERIAL_MAP_PREFILTER) && (probe != NULL)) textureID = probe->prefilter.id;
+
+            if (textureID > 0)
+            {
+                // Select current shader texture slot
+                rlActiveTextureSlot(i);
+
+                // Enable texture for active slot
+                if (i == MATERIAL_MAP_IRRADIANCE ||
+                    i == MATERIAL_MAP_PREFILTER ||
+                    i == MATERIAL_MAP_CUBEMAP)
+                {
+                    rlEnableTextureCubemap(textureID);
+                }
+                else
+                {
+                    rlEnableTexture(textureID);
+                }
+
+                rlSetUniform(shader->locs[RLG_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+            }
+        }
+    }
+
+    // Bind depth textures for shadow mapping
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+
+        if (l->data.enabled && l->data.shadow && allLights)
+        {
+            int j = 11 + i;
+            rlActiveTextureSlot(j);
+
+            // The samplers of the other types are parked, so that they never share the unit
+            int parkMap = RLG_SHADOW_PARK_UNIT_2D, parkCubemap = RLG_SHADOW_PARK_UNIT_CUBE;
+            int parkMoments = RLG_SHADOW_PARK_UNIT_MOMENTS;
+
+            if (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_CUBE)
+            {
+                rlEnableTextureCubemap(l->data.shadowMap.depth.id);
+                rlSetUniform(l->locs.shadowCubemap, &j, SHADER_UNIFORM_INT, 1);
+                rlSetUniform(l->locs.shadowMap, &parkMap, SHADER_UNIFORM_INT, 1);
+                rlSetUniform(l->locs.shadowMoments, &parkMoments, SHADER_UNIFORM_INT, 1);
+            }
+            else if (l->data.shadowTechnique != RLG_SHADOW_TECHNIQUE_PCF && l->data.shadowMap.momentsId != 0)
+            {
+                rlEnableTexture(l->data.shadowMap.moments.id);
+                rlSetUniform(l->locs.shadowMoments, &j, SHADER_UNIFORM_INT, 1);
+                rlSetUniform(l->locs.shadowMap, &parkMap, SHADER_UNIFORM_INT, 1);
+                rlSetUniform(l->locs.shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT, 1);
+            }
+            else
+            {
+                rlEnableTexture(l->data.shadowMap.depth.id);
+                rlSetUniform(l->locs.shadowMap, &j, SHADER_UNIFORM_INT, 1);
+                rlSetUniform(l->locs.shadowCubemap, &parkCubemap, SHADER_UNIFORM_INT, 1);
+                rlSetUniform(l->locs.shadowMoments, &parkMoments, SHADER_UNIFORM_INT, 1);
+            }
+        }
+    }
+
+    // Bind the shadow mask and the depth its texels were evaluated at, after the units of the lights
+    const struct RLG_ShadowMask *shadowMask = &rlgCtx->shadowMask;
+    bool useShadowMask = shadowMask->active && shadowMask->maskId != 0 && allLights && !capturing;
+
+    if (useShadowMask)
+    {
+        int maskUnit = 11 + rlgCtx->lightCount;
+        int depthUnit = maskUnit + 1;
+
+        rlActiveTextureSlot(maskUnit);
+        rlEnableTexture(shadowMask->mask.id);
+        rlSetUniform(shadowMask->locLightingMask, &maskUnit, SHADER_UNIFORM_INT, 1);
+
+        rlActiveTextureSlot(depthUnit);
+        rlEnableTexture(shadowMask->depth.id);
+        rlSetUniform(shadowMask->locLightingDepth, &depthUnit, SHADER_UNIFORM_INT, 1);
+    }
+
+    // Try binding vertex array objects (VAO) or use VBOs if not possible
+    // WARNING: UploadMesh() enables all vertex attributes available in mesh and sets default attribute values
+    // for shader expected vertex attributes that are not provided by the mesh (i.e. colors)
+    // This could be a dangerous approach because different meshes with different shaders can enable/disable some attributes
+    if (!rlEnableVertexArray(mesh.vaoId))
+    {
+        // Bind mesh VBO data: vertex position (shader-location = 0)
+        rlEnableVertexBuffer(mesh.vboId[0]);
+        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION]);
+
+        // Bind mesh VBO data: vertex texcoords (shader-location = 1)
+        rlEnableVertexBuffer(mesh.vboId[1]);
+        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01]);
+
+        if (shader->locs[RLG_LOC_VERTEX_NORMAL] != -1)
+        {
+            // Bind mesh VBO data: vertex normals (shader-location = 2)
+            rlEnableVertexBuffer(mesh.vboId[2]);
+            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL], 3, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL]);
+        }
+
+        // Bind mesh VBO data: vertex colors (shader-location = 3, if available)
+        if (shader->locs[RLG_LOC_VERTEX_COLOR] != -1)
+        {
+            if (mesh.vboId[3] != 0)
+            {
+                rlEnableVertexBuffer(mesh.vboId[3]);
+                rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, 1, 0, 0);
+                rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
+            }
+            else
+            {
+                // Set default value for defined vertex attribute in shader but not provided by mesh
+                // WARNING: It could result in GPU undefined behaviour
+                float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+                rlSetVertexAttributeDefault(shader->locs[RLG_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC4, 4);
+                rlDisableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
+            }
+        }
+
+        // Bind mesh VBO data: vertex tangents (shader-location = 4, if available)
+        if (shader->locs[RLG_LOC_VERTEX_TANGENT] != -1)
+        {
+            rlEnableVertexBuffer(mesh.vboId[4]);
+            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT], 4, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT]);
+        }
+
+        // Bind mesh VBO data: vertex texcoords2 (shader-location = 5, if available)
+        if (shader->locs[RLG_LOC_VERTEX_TEXCOORD02] != -1)
+        {
+            rlEnableVertexBuffer(mesh.vboId[5]);
+            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02], 2, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02]);
+        }
+
+        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+    }
+
+    // After the depth pre-pass, only the visible fragments are shaded
+    // NOTE: The G-buffer has its own depth, the pre-pass filled the one of the render target
+    bool depthEqual = rlgCtx->depthPrepass.filled && !deferred && !capturing;
+    if (depthEqual)
+    {
+        GLint framebufferId = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferId);
+        depthEqual = (framebufferId == rlgCtx->depthPrepass.framebufferId);
+    }
+
+    if (depthEqual)
+    {
+        glDepthFunc(GL_EQUAL);
+        rlDisableDepthMask();
+    }
+
+    // The light passes skip the lights out of reach of the mesh
+    // NOTE: The bounds are computed from the CPU vertices, which animated meshes do not match
+    BoundingBox bounds = { 0 };
+    bool bounded = multiPass && mesh.vertices != NULL && mesh.animVertices == NULL;
+    if (bounded) bounds = rlgTransformBoundingBox(GetMeshBoundingBox(mesh), matModel);
+
+    int eyeCount = 1;
+    if (rlIsStereoRenderEnabled()) eyeCount = 2;
+
+    for (int eye = 0; eye < eyeCount; eye++)
+    {
+        // Calculate model-view-projection matrix (MVP)
+        Matrix matModelViewProjection = MatrixIdentity();
+        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
+        else
+        {
+            // Setup current eye viewport (half screen width)
+            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
+            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+        }
+
+        // Send combined model-view-projection matrix to shader
+        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+
+        // Draw mesh
+        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
+        else rlDrawVertexArray(0, mesh.vertexCount);
+
+        // Add the lights, restricted to their screen rectangle outside of stereo rendering
+        if (multiPass)
+        {
+            rlgDrawMeshLightPasses(mesh, bounds, bounded, MatrixMultiply(matView, matProjection), (eyeCount == 1));
+        }
+    }
+
+    // Restore the depth state of rlgl
+    if (depthEqual || multiPass)
+    {
+        glDepthFunc(GL_LEQUAL);
+        rlEnableDepthMask();
+    }
+
+    // Unbind all bound texture maps
+    for (int i = 0; i < 11; i++)
+    {
+        if (rlgCtx->material.data.useMaps[i])
+        {
+            // Select current shader texture slot
+            rlActiveTextureSlot(i);
+
+            // Disable texture for active slot
+            if (i == MATERIAL_MAP_IRRADIANCE ||
+                i == MATERIAL_MAP_PREFILTER ||
+                i == MATERIAL_MAP_CUBEMAP)
+            {
+                rlDisableTextureCubemap();
+            }
+            else
+            {
+                rlDisableTexture();
+            }
+        }
+    }
+
+    // Unbind depth textures
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+
+        if (l->data.enabled && l->data.shadow && allLights)
+        {
+            rlActiveTextureSlot(11 + i);
+
+            if (rlgGetShadowStorage(l) == RLG_SHADOW_STORAGE_DEPTH_CUBE)
+            {
+                rlDisableTextureCubemap();
+            }
+            else
+            {
+                rlDisableTexture();
+            }
+        }
+    }
+
+    // Unbind the shadow mask
+    if (useShadowMask)
+    {
+        rlActiveTextureSlot(11 + rlgCtx->lightCount);
+        rlDisableTexture();
+        rlActiveTextureSlot(12 + rlgCtx->lightCount);
+        rlDisableTexture();
+    }
+
+    // Disable all possible vertex array objects (or VBOs)
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+
+    // Disable shader program
+    rlDisableShader();
+
+    // Restore rlgl internal modelview and projection matrices
+    rlSetMatrixModelview(matView);
+    rlSetMatrixProjection(matProjection);
+}
+
+void RLG_DrawModel(Model model, Vector3 position, float scale, Color tint)
+{
+    Vector3 vScale = { scale, scale, scale };
+    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+
+    RLG_DrawModelEx(model, position, rotationAxis, 0.0f, vScale, tint);
+}
+
+void RLG_DrawModelEx(Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale, Color tint)
+{
+    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
+    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
+    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+
+    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
+    model.transform = MatrixMultiply(model.transform, matTransform);
+
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        Color color = model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color;
+
+        Color colorTint = WHITE;
+        colorTint.r = (unsigned char)((color.r*tint.r)/255);
+        colorTint.g = (unsigned char)((color.g*tint.g)/255);
+        colorTint.b = (unsigned char)((color.b*tint.b)/255);
+        colorTint.a = (unsigned char)((color.a*tint.a)/255);
+
+        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = colorTint;
+        RLG_DrawMesh(model.meshes[i], model.materials[model.meshMaterial[i]], model.transform);
+        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = color;
+    }
+}
+
+// Rows of texels projected by each job of the SH9 projection
+#define RLG_SH_ROWS_PER_JOB 16
+
+struct rlgJobRange
+{
+    void (*func)(void *data, int job);
+    void *data;
+    int first, count, step;
+};
+
+static void *rlgRunJobRange(void *arg)
+{
+    struct rlgJobRange *range = (struct rlgJobRange*)arg;
+
+    for (int job = range->first; job < range->count; job += range->step)
+    {
+        range->func(range->data, job);
+    }
+
+    return NULL;
+}
+
+// Run the jobs [0, count) on up to RLG_WORKER_THREADS threads, the calling thread included.
+// The jobs must only write to their own results, which are then combined in order by the caller.
+static void rlgParallelFor(int count, void (*func)(void *data, int job), void *data)
+{
+    struct rlgJobRange ranges[RLG_WORKER_THREADS];
+
+    int threadCount = (count < RLG_WORKER_THREADS) ? count : RLG_WORKER_THREADS;
+    if (threadCount < 1) threadCount = 1;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        ranges[i] = (struct rlgJobRange) { func, data, i, count, threadCount };
+    }
+
+#   ifdef RLG_THREADS_SUPPORTED
+    pthread_t threads[RLG_WORKER_THREADS];
+    bool started[RLG_WORKER_THREADS] = { 0 };
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        started[i] = (pthread_create(&threads[i], NULL, rlgRunJobRange, &ranges[i]) == 0);
+        if (!started[i]) rlgRunJobRange(&ranges[i]);
+    }
+
+    rlgRunJobRange(&ranges[0]);
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+#   else
+    for (int i = 0; i < threadCount; i++)
+    {
+        rlgRunJobRange(&ranges[i]);
+    }
+#   endif
+}
+
+struct rlgSHSums
+{
+    double coeffs[9][3];
+    double weight;
+};
+
+struct rlgSHProjection
+{
+    const float *pixels;        ///< Float RGB(A) texels, an equirectangular panorama or the six faces of a cubemap
+    int width, height;          ///< Size of the panorama or of one face
+    int channels;               ///< Floats per texel
+    int faceCount;              ///< 1 for a panorama, 6 for a cubemap
+    struct rlgSHSums *sums;     ///< Partial sums of each job
+};
+
+static void rlgProjectSHJob(void *data, int job)
+{
+    const struct rlgSHProjection *p = (const struct rlgSHProjection*)data;
+    struct rlgSHSums *sums = &p->sums[job];
+
+    int rowCount = p->faceCount*p->height;
+    int rowEnd = (job + 1)*RLG_SH_ROWS_PER_JOB;
+    if (rowEnd > rowCount) rowEnd = rowCount;
+
+    for (int row = job*RLG_SH_ROWS_PER_JOB; row < rowEnd; row++)
+    {
+        int face = row/p->height;
+        int y = row%p->height;
+
+        const float *texels = p->pixels + (size_t)row*p->width*p->channels;
+
+        // Each row is summed in single precision before being added to the totals
+        float rowSums[9][3] = { 0 };
+        float rowWeight = 0.0f;
+
+        float tc = 2.0f*(y + 0.5f)/p->height - 1.0f;
+        float latitude = (0.5f - (y + 0.5f)/p->height)*PI;
+
+        for (int x = 0; x < p->width; x++)
+        {
+            Vector3 dir = { 0 };
+            float solidAngle = 0.0f;
+
+            if (p->faceCount == 1)
+            {
+                // Same mapping as 'rlgEquirectangularToCubemapFS'
+                float longitude = ((x + 0.5f)/p->width - 0.5f)*2.0f*PI;
+                float cosLatitude = cosf(latitude);
+
+                dir = (Vector3) { cosLatitude*cosf(longitude), sinf(latitude), cosLatitude*sinf(longitude) };
+                solidAngle = (2.0f*PI/p->width)*(PI/p->height)*cosLatitude;
+            }
+            else
+            {
+                // Direction of the texel center, following the OpenGL cubemap face orientations
+                float sc = 2.0f*(x + 0.5f)/p->width - 1.0f;
+
+                switch (face)
+                {
+                    case 0: dir = (Vector3) {  1.0f, -tc, -sc }; break;
+                    case 1: dir = (Vector3) { -1.0f, -tc,  sc }; break;
+                    case 2: dir = (Vector3) {  sc,  1.0f,  tc }; break;
+                    case 3: dir = (Vector3) {  sc, -1.0f, -tc }; break;
+                    case 4: dir = (Vector3) {  sc, -tc,  1.0f }; break;
+                    default: dir = (Vector3) { -sc, -tc, -1.0f }; break;
+                }
+
+                float d2 = 1.0f + sc*sc + tc*tc;
+                float invLength = 1.0f/sqrtf(d2);
+
+                dir.x *= invLength;
+                dir.y *= invLength;
+                dir.z *= invLength;
+                solidAngle = (4.0f/((float)p->width*p->height))*invLength/d2;
+            }
+
+            float basis[9] = {
+                1.0f,
+                dir.y, dir.z, dir.x,
+                dir.x*dir.y, dir.y*dir.z, 3.0f*dir.z*dir.z - 1.0f,
+                dir.x*dir.z, dir.x*dir.x - dir.y*dir.y
+            };
+
+            const float *texel = texels + x*p->channels;
+
+            for (int k = 0; k < 9; k++)
+            {
+                float w = basis[k]*solidAngle;
+                rowSums[k][0] += texel[0]*w;
+                rowSums[k][1] += texel[1]*w;
+                rowSums[k][2] += texel[2]*w;
+            }
+
+            rowWeight += solidAngle;
+        }
+
+        for (int k = 0; k < 9; k++)
+        {
+            sums->coeffs[k][0] += rowSums[k][0];
+            sums->coeffs[k][1] += rowSums[k][1];
+            sums->coeffs[k][2] += rowSums[k][2];
+        }
+
+        sums->weight += rowWeight;
+    }
+}
+
+// Project the texels onto the nine SH basis functions and convolve them with the cosine lobe,
+// the coefficients give the irradiance divided by PI, like the irradiance cubemap
+static void rlgProjectSH(const float *pixels, int width, int height, int channels, int faceCount, Vector3 coefficients[9])
+{
+    // Squared basis normalization constants times the cosine lobe bands (1, 2/3, 1/4)
+    static const double scales[9] = {
+        1.0/(4.0*PI),
+        1.0/(2.0*PI), 1.0/(2.0*PI), 1.0/(2.0*PI),
+        15.0/(16.0*PI), 15.0/(16.0*PI), 5.0/(64.0*PI),
+        15.0/(16.0*PI), 15.0/(64.0*PI)
+    };
+
+    int jobCount = (faceCount*height + RLG_SH_ROWS_PER_JOB - 1)/RLG_SH_ROWS_PER_JOB;
+
+    struct rlgSHProjection projection = {
+        pixels, width, height, channels, faceCount,
+        (struct rlgSHSums*)calloc(jobCount, sizeof(struct rlgSHSums))
+    };
+
+    if (projection.sums == NULL)
+    {
+        TraceLog(LOG_ERROR, "Heap allocation for the SH9 projection failed");
+        memset(coefficients, 0, 9*sizeof(Vector3));
+        return;
+    }
+
+    rlgParallelFor(jobCount, rlgProjectSHJob, &projection);
+
+    // Combined in job order so that the result does not depend on the number of threads
+    struct rlgSHSums total = { 0 };
+
+    for (int i = 0; i < jobCount; i++)
+    {
+        for (int k = 0; k < 9; k++)
+        {
+            total.coeffs[k][0] += projection.sums[i].coeffs[k][0];
+            total.coeffs[k][1] += projection.sums[i].coeffs[k][1];
+            total.coeffs[k][2] += projection.sums[i].coeffs[k][2];
+        }
+
+        total.weight += projection.sums[i].weight;
+    }
+
+    free(projection.sums);
+
+    // The texel solid angles are approximations, their sum is brought back to the whole sphere
+    double normalization = (total.weight > 0.0) ? 4.0*PI/total.weight : 0.0;
+
+    for (int k = 0; k < 9; k++)
+    {
+        double s = scales[k]*normalization;
+        coefficients[k] = (Vector3) {
+            (float)(total.coeffs[k][0]*s),
+            (float)(total.coeffs[k][1]*s),
+            (float)(total.coeffs[k][2]*s)
+        };
+    }
+}
+
+// Project an image loaded on the CPU, as an equirectangular panorama
+static void rlgProjectImageSH(Image image, Vector3 coefficients[9])
+{
+    if (image.format == PIXELFORMAT_UNCOMPRESSED_R32G32B32)
+    {
+        rlgProjectSH((const float*)image.data, image.width, image.height, 3, 1, coefficients);
+        return;
+    }
+
+    Image copy = ImageCopy(image);
+    ImageFormat(&copy, PIXELFORMAT_UNCOMPRESSED_R32G32B32);
+
+    rlgProjectSH((const float*)copy.data, copy.width, copy.height, 3, 1, coefficients);
+
+    UnloadImage(copy);
+}
+
+#if !defined(GRAPHICS_API_OPENGL_ES2)
+// Read back the faces of a cubemap texture to project them
+static bool rlgProjectCubemapSH(TextureCubemap cubemap, Vector3 coefficients[9])
+{
+    size_t faceSize = (size_t)cubemap.width*cubemap.width*4;
+    float *pixels = (float*)malloc(6*faceSize*sizeof(float));
+
+    if (pixels == NULL)
+    {
+        TraceLog(LOG_ERROR, "Heap allocation for the cubemap faces of the SH9 projection failed");
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    for (int i = 0; i < 6; i++)
+    {
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, GL_FLOAT, pixels + i*faceSize);
+    }
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    rlgProjectSH(pixels, cubemap.width, cubemap.width, 4, 6, coefficients);
+    free(pixels);
+
+    return true;
+}
+#endif
+
+void RLG_SetIrradianceMode(RLG_IrradianceMode mode)
+{
+    rlgCtx->irradianceMode = mode;
+}
+
+RLG_IrradianceMode RLG_GetIrradianceMode(void)
+{
+    return rlgCtx->irradianceMode;
+}
+
+void RLG_SetIrradianceSH(const Vector3 *coefficients)
+{
+    Shader shader = rlgCtx->shaders[RLG_SHADER_LIGHTING];
+
+    rlgCtx->useIrradianceSH = (coefficients != NULL);
+
+    if (coefficients != NULL)
+    {
+        memcpy(rlgCtx->irradianceSH, coefficients, sizeof(rlgCtx->irradianceSH));
+
+        SetShaderValueV(shader, shader.locs[RLG_LOC_IRRADIANCE_SH],
+            rlgCtx->irradianceSH, SHADER_UNIFORM_VEC3, 9);
+    }
+
+    SetShaderValue(shader, shader.locs[RLG_LOC_USE_IRRADIANCE_SH],
+        &rlgCtx->useIrradianceSH, SHADER_UNIFORM_INT);
+}
+
+// Check for the packed HDR pixel formats of rlights, unknown to raylib
+static bool rlgIsPackedFormat(int format)
+{
+    return (format == RLG_PIXELFORMAT_R11G11B10F) || (format == RLG_PIXELFORMAT_RGB9E5);
+}
+
+// Same as GetPixelDataSize, the packed formats included
+static size_t rlgGetPixelDataSize(int width, int height, int format)
+{
+    if (rlgIsPackedFormat(format)) return 4*(size_t)width*height;
+
+    return (size_t)GetPixelDataSize(width, height, format);
+}
+
+// Same as rlGetGlTextureFormats, the packed formats included
+static void rlgGetGlTextureFormats(int format, int *glInternalFormat, int *glFormat, int *glType)
+{
+#   if !defined(GRAPHICS_API_OPENGL_ES2)
+    if (format == RLG_PIXELFORMAT_R11G11B10F)
+    {
+        *glInternalFormat = GL_R11F_G11F_B10F;
+        *glFormat = GL_RGB;
+        *glType = GL_UNSIGNED_INT_10F_11F_11F_REV;
+        return;
+    }
+
+    if (format == RLG_PIXELFORMAT_RGB9E5)
+    {
+        *glInternalFormat = GL_RGB9_E5;
+        *glFormat = GL_RGB;
+        *glType = GL_UNSIGNED_INT_5_9_9_9_REV;
+        return;
+    }
+#   endif
+
+    rlGetGlTextureFormats(format, glInternalFormat, glFormat, glType);
+}
+
+// Load the first level of a cubemap, its content left undefined without data,
+// as raylib cannot create some empty float cubemaps nor the packed ones
+static unsigned int rlgLoadCubemap(const void *data, int size, int format)
+{
+    if ((data != NULL) && !rlgIsPackedFormat(format)) return rlLoadTextureCubemap((void*)data, size, format);
+
+    int glInternalFormat, glFormat, glType;
+    rlgGetGlTextureFormats(format, &glInternalFormat, &glFormat, &glType);
+
+    size_t faceSize = rlgGetPixelDataSize(size, size, format);
+    unsigned int id = 0;
+
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+
+    for (int i = 0; i < 6; i++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, glInternalFormat, size, size, 0, glFormat, glType,
+            (data != NULL) ? (const unsigned char*)data + i*faceSize : NULL);
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#   if !defined(GRAPHICS_API_OPENGL_ES2)
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+#   endif
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    return id;
+}
+
+#if !defined(GRAPHICS_API_OPENGL_ES2)
+// Check that the cubemaps of a packed format can be rendered to, which OpenGL never allows for RGB9E5
+static bool rlgIsCubemapFormatRenderable(int format)
+{
+    if (format == RLG_PIXELFORMAT_RGB9E5) return false;
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    unsigned int id = rlgLoadCubemap(NULL, 4, format);
+
+    unsigned int fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X, id, 0);
+
+    bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glDeleteFramebuffers(1, &fbo);
+    rlUnloadTexture(id);
+
+    return complete;
+}
+
+// Unsigned float with a 5 bits exponent, as stored in the channels of R11G11B10F
+static uint32_t rlgPackUnsignedFloat(float value, int mantissaBits)
+{
+    uint32_t maxValue = (30u << mantissaBits) | ((1u << mantissaBits) - 1);
+
+    if (!(value > 0.0f)) return 0;  // Negative values and NaNs
+
+    union { float value; uint32_t bits; } v = { value };
+    int exponent = (int)((v.bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = v.bits & 0x7FFFFF;
+
+    if (exponent >= 31) return maxValue;
+
+    if (exponent <= 0)
+    {
+        // Denormal, the implicit one becomes explicit
+        int shift = 24 - mantissaBits - exponent;
+        return (shift > 24) ? 0 : (mantissa | 0x800000) >> shift;
+    }
+
+    // Rounded to nearest, a carry into the exponent gives the next power of two
+    uint32_t packed = ((uint32_t)exponent << mantissaBits) | (mantissa >> (23 - mantissaBits));
+    if (mantissa & (1u << (22 - mantissaBits))) packed++;
+
+    return (packed > maxValue) ? maxValue : packed;
+}
+
+static uint32_t rlgPackR11G11B10F(const float *rgb)
+{
+    return rlgPackUnsignedFloat(rgb[0], 6) | (rlgPackUnsignedFloat(rgb[1], 6) << 11) | (rlgPackUnsignedFloat(rgb[2], 5) << 22);
+}
+
+// Shared exponent packing, as specified by EXT_texture_shared_exponent
+static uint32_t rlgPackRGB9E5(const float *rgb)
+{
+    const float maxValue = 511.0f/512.0f*65536.0f;
+
+    float r = Clamp(rgb[0], 0.0f, maxValue);
+    float g = Clamp(rgb[1], 0.0f, maxValue);
+    float b = Clamp(rgb[2], 0.0f, maxValue);
+
+    // Comparisons false for NaNs, which are stored as zeros
+    if (!(r == r)) r = 0.0f;
+    if (!(g == g)) g = 0.0f;
+    if (!(b == b)) b = 0.0f;
+
+    float maxComponent = fmaxf(r, fmaxf(g, b));
+    if (maxComponent <= 0.0f) return 0;
+
+    int exponent = (int)floorf(log2f(maxComponent));
+    if (exponent < -16) exponent = -16;
+    exponent += 16;
+
+    float scale = exp2f((float)(exponent - 15 - 9));
+    if ((int)floorf(maxComponent/scale + 0.5f) == 512)
+    {
+        exponent++;
+        scale *= 2.0f;
+    }
+
+    uint32_t rs = (uint32_t)floorf(r/scale + 0.5f);
+    uint32_t gs = (uint32_t)floorf(g/scale + 0.5f);
+    uint32_t bs = (uint32_t)floorf(b/scale + 0.5f);
+
+    return rs | (gs << 9) | (bs << 18) | ((uint32_t)exponent << 27);
+}
+
+// Copy the levels of a cubemap to another one of the same size, converting the texels to its format
+static void rlgBlitCubemapLevels(const unsigned int fbos[2], unsigned int sourceId, unsigned int destinationId, int size, int levels)
+{
+    for (int level = 0; level < levels; level++)
+    {
+        int levelSize = (size >> level);
+
+        for (int i = 0; i < 6; i++)
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, sourceId, level);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, destinationId, level);
+            glBlitFramebuffer(0, 0, levelSize, levelSize, 0, 0, levelSize, levelSize, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+    }
+}
+
+// Replace the levels of a float cubemap by their packed conversion, keeping its texture name so
+// that the materials which copied the cubemap keep sampling it. The conversion is blitted on the GPU
+// through a temporary cubemap when the packed format can be rendered to, or done on the CPU otherwise
+static void rlgPackCubemap(TextureCubemap *cubemap, int levels, int format, bool renderable)
+{
+    size_t texelCount = 0;
+    for (int level = 0; level < levels; level++) texelCount += 6*(size_t)(cubemap->width >> level)*(cubemap->width >> level);
+
+    float *pixels = NULL;
+    uint32_t *packed = NULL;
+
+    if (!renderable)
+    {
+        pixels = (float*)malloc(3*texelCount*sizeof(float));
+        packed = (uint32_t*)malloc(texelCount*sizeof(uint32_t));
+
+        if ((pixels == NULL) || (packed == NULL))
+        {
+            TraceLog(LOG_WARNING, "Heap allocation for the packing of a cubemap failed, it keeps its float format");
+            free(pixels);
+            free(packed);
+            return;
+        }
+    }
+
+    int glInternalFormat, glFormat, glType;
+    rlgGetGlTextureFormats(format, &glInternalFormat, &glFormat, &glType);
+
+    GLint previousFramebuffer = 0;
+    unsigned int fbos[2] = { 0 };
+    unsigned int temporaryId = 0;
+
+    if (renderable)
+    {
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGenFramebuffers(2, fbos);
+
+        // The packed levels are blitted to a temporary cubemap, the blit converting the float texels
+        temporaryId = rlgLoadCubemap(NULL, cubemap->width, format);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, temporaryId);
+
+        for (int level = 1; level < levels; level++)
+        {
+            int levelSize = (cubemap->width >> level);
+
+            for (int i = 0; i < 6; i++)
+            {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, glInternalFormat, levelSize, levelSize, 0, glFormat, glType, NULL);
+            }
+        }
+
+        rlgBlitCubemapLevels(fbos, cubemap->id, temporaryId, cubemap->width, levels);
+    }
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->id);
+
+    if (!renderable)
+    {
+        // All the levels are converted before any is specified again, some drivers
+        // dropping the content of the others when the format of a level changes
+        size_t offset = 0;
+
+        for (int level = 0; level < levels; level++)
+        {
+            int levelSize = (cubemap->width >> level);
+            size_t faceTexels = (size_t)levelSize*levelSize;
+
+            for (int i = 0; i < 6; i++)
+            {
+                glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB, GL_FLOAT, pixels + 3*(offset + i*faceTexels));
+            }
+
+            offset += 6*faceTexels;
+        }
+
+        for (size_t t = 0; t < texelCount; t++)
+        {
+            packed[t] = (format == RLG_PIXELFORMAT_RGB9E5) ? rlgPackRGB9E5(pixels + 3*t) : rlgPackR11G11B10F(pixels + 3*t);
+        }
+    }
+
+    // The storage of the levels is specified again in the packed format, with the converted
+    // texels or, for the blit back from the temporary cubemap, without data
+    size_t offset = 0;
+
+    for (int level = 0; level < levels; level++)
+    {
+        int levelSize = (cubemap->width >> level);
+        size_t faceTexels = (size_t)levelSize*levelSize;
+
+        for (int i = 0; i < 6; i++)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, glInternalFormat, levelSize, levelSize, 0, glFormat, glType,
+                renderable ? NULL : packed + offset + i*faceTexels);
+        }
+
+        offset += 6*faceTexels;
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    if (renderable)
+    {
+        rlgBlitCubemapLevels(fbos, temporaryId, cubemap->id, cubemap->width, levels);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glDeleteFramebuffers(2, fbos);
+        rlUnloadTexture(temporaryId);
+    }
+
+    free(pixels);
+    free(packed);
+
+    cubemap->format = format;
+}
+#endif
+
+size_t RLG_GetSkyboxMemory(RLG_Skybox skybox)
+{
+    TextureCubemap textures[3] = { skybox.cubemap, skybox.prefilter, skybox.irradiance };
+
+    // The prefilter cubemaps have all their levels allocated, past the roughness steps
+    int levels[3] = {
+        skybox.cubemap.mipmaps,
+        (skybox.prefilter.width > 0) ? 1 + (int)floorf(log2f((float)skybox.prefilter.width)) : 0,
+        skybox.irradiance.mipmaps
+    };
+
+    size_t size = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (textures[i].id == 0) continue;
+
+        for (int level = 0; level < levels[i]; level++)
+        {
+            int levelSize = (textures[i].width >> level);
+            size += 6*rlgGetPixelDataSize(levelSize, levelSize, textures[i].format);
+        }
+    }
+
+    return size;
+}
+
+// Size of the square tiles rendered by each step of the sampled irradiance convolution
+#define RLG_IRRADIANCE_TILE_SIZE 16
+
+// Size and sample count of the BRDF lookup table of the split-sum image based lighting
+#define RLG_BRDF_LUT_SIZE           64
+#define RLG_BRDF_LUT_SAMPLES        512
+
+// Samples per texel of the prefiltered radiance cubemaps
+#define RLG_PREFILTER_SAMPLES       256
+
+// Generate the mipmaps read by the importance sampled convolutions
+static void rlgGenEnvironmentMipmaps(RLG_Skybox *skybox)
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->cubemap.id);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    skybox->cubemap.mipmaps = 1 + (int)floorf(log2f((float)skybox->cubemap.width));
+}
+
+// View matrix of a cubemap face seen from its center, in the order of the OpenGL face targets
+static Matrix rlgGetCubemapFaceView(int face)
+{
+    static const Vector3 targets[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    static const Vector3 ups[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+
+    return MatrixLookAt((Vector3){ 0 }, targets[face], ups[face]);
+}
+
+// Render a face of a level of a cubemap by drawing the unit cube with a shader sampling
+// a texture or a cubemap, the viewport and the render states being left to the caller
+static void rlgRenderCubemapFace(Shader shader, unsigned int sourceId, bool sourceIsCubemap, TextureCubemap target, int face, int level)
+{
+    int size = (target.width >> level);
+
+    unsigned int fbo = rlLoadFramebuffer(size, size);
+    rlFramebufferAttach(fbo, target.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + face, level);
+    rlEnableFramebuffer(fbo);
+    rlViewport(0, 0, size, size);
+
+    rlEnableShader(shader.id);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION], MatrixPerspective(90.0*DEG2RAD, 1.0, 0.1, 10.0));
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], rlgGetCubemapFaceView(face));
+
+    rlActiveTextureSlot(0);
+    if (sourceIsCubemap) rlEnableTextureCubemap(sourceId);
+    else rlEnableTexture(sourceId);
+
+    rlDisableBackfaceCulling();
+    rlDisableDepthTest();
+
+    rlLoadDrawCube();
+
+    if (sourceIsCubemap) rlDisableTextureCubemap();
+    else rlDisableTexture();
+
+    rlDisableShader();
+    rlDisableFramebuffer();
+    rlUnloadFramebuffer(fbo);
+}
+
+// Allocate the prefiltered radiance cubemap of a skybox, rendered by rlgRenderPrefilterFace
+static void rlgLoadPrefilterCubemap(RLG_Skybox *skybox)
+{
+    int size = (skybox->cubemap.width < RLG_PREFILTER_SIZE) ? skybox->cubemap.width : RLG_PREFILTER_SIZE;
+    int format = skybox->cubemap.format;
+
+    // Cleared to black, as the levels past the roughness steps are never rendered,
+    // the levels below the first being allocated by the mipmap generation
+    void *black = calloc(6, rlgGetPixelDataSize(size, size, format));
+
+    skybox->prefilter.id = rlgLoadCubemap(black, size, format);
+    free(black);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->prefilter.id);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    skybox->prefilter.width = size;
+    skybox->prefilter.height = size;
+    skybox->prefilter.mipmaps = RLG_PREFILTER_MIP_LEVELS;
+    skybox->prefilter.format = format;
+}
+
+// Render a face of a level of the prefiltered radiance, its roughness growing linearly to 1 with the level
+static void rlgRenderPrefilterFace(RLG_Skybox *skybox, int mip, int face)
+{
+    Shader shader = rlgCtx->shaders[RLG_SHADER_PREFILTER];
+
+    int mipSize = (skybox->prefilter.width >> mip);
+    if (mipSize < 1) return;
+
+    float environmentSize = (float)skybox->cubemap.width;
+
+    // The first level is a copy of the environment, a single sample is enough
+    float roughness = (float)mip/(RLG_PREFILTER_MIP_LEVELS - 1);
+    int sampleCount = (mip == 0) ? 1 : RLG_PREFILTER_SAMPLES;
+
+#   if GLSL_VERSION > 100
+    float implicitLod = 0.0f;
+#   else
+    float implicitLod = log2f(environmentSize/mipSize);
+#   endif
+
+    rlEnableShader(shader.id);
+    rlSetUniform(rlgCtx->skybox.locPrefilterEnvironmentSize, &environmentSize, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(rlgCtx->skybox.locPrefilterRoughness, &roughness, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(rlgCtx->skybox.locPrefilterSampleCount, &sampleCount, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlgCtx->skybox.locPrefilterImplicitLod, &implicitLod, SHADER_UNIFORM_FLOAT, 1);
+
+    rlgRenderCubemapFace(shader, skybox->cubemap.id, true, skybox->prefilter, face, mip);
+}
+
+// Render the GGX prefiltered radiance of a skybox, the roughness of each mip level growing linearly to 1
+static void rlgGenPrefilterCubemap(RLG_Skybox *skybox)
+{
+    rlDrawRenderBatchActive();
+
+    rlgLoadPrefilterCubemap(skybox);
+
+    for (int mip = 0; mip < RLG_PREFILTER_MIP_LEVELS; mip++)
+    {
+        for (int i = 0; i < 6; i++) rlgRenderPrefilterFace(skybox, mip, i);
+    }
+
+    // Reset the viewport to default dimensions
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+    rlEnableDepthTest();
+    rlEnableBackfaceCulling();
+}
+
+static void rlgComputeBRDFLUTRow(void *data, int row)
+{
+    float *lut = (float*)data + row*RLG_BRDF_LUT_SIZE*3;
+
+    float roughness = (row + 0.5f)/RLG_BRDF_LUT_SIZE;
+    float alpha = roughness*roughness;
+    float a2 = alpha*alpha;
+
+    for (int x = 0; x < RLG_BRDF_LUT_SIZE; x++)
+    {
+        // View vector in the tangent space of a normal along Z
+        float NdotV = (x + 0.5f)/RLG_BRDF_LUT_SIZE;
+        Vector3 V = { sqrtf(1.0f - NdotV*NdotV), 0.0f, NdotV };
+
+        float scale = 0.0f, bias = 0.0f;
+
+        for (unsigned int i = 0; i < RLG_BRDF_LUT_SAMPLES; i++)
+        {
+            // Hammersley point with the radical inverse of the sample index
+            unsigned int bits = i;
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+            float u = (float)bits*2.3283064365386963e-10f;
+            float phi = 2.0f*PI*i/RLG_BRDF_LUT_SAMPLES;
+
+            // GGX importance sampling of the half vector
+            float cosTheta = sqrtf((1.0f - u)/(1.0f + (a2 - 1.0f)*u));
+            float sinTheta = sqrtf(1.0f - cosTheta*cosTheta);
+            Vector3 H = { sinTheta*cosf(phi), sinTheta*sinf(phi), cosTheta };
+
+            float VdotH = Vector3DotProduct(V, H);
+            float NdotL = 2.0f*VdotH*H.z - V.z;
+
+            if (NdotL > 0.0f && VdotH > 0.0f)
+            {
+                // Same visibility term as 'GeometrySmith' of the lighting shader,
+                // divided by the pdf of the sample: D*NdotH/(4*VdotH)
+                float vis = 0.5f/(2.0f*NdotL*NdotV*(1.0f - alpha) + (NdotL + NdotV)*alpha);
+                float w = 4.0f*vis*NdotL*VdotH/cosTheta;
+
+                float m = 1.0f - VdotH;
+                float fc = m*m*m*m*m;
+
+                scale += (1.0f - fc)*w;
+                bias += fc*w;
+            }
+        }
+
+        lut[x*3 + 0] = scale/RLG_BRDF_LUT_SAMPLES;
+        lut[x*3 + 1] = bias/RLG_BRDF_LUT_SAMPLES;
+        lut[x*3 + 2] = 0.0f;
+    }
+}
+
+Texture2D RLG_GetBRDFLUT(void)
+{
+    if (rlgCtx->skybox.brdfLUT.id != 0) return rlgCtx->skybox.brdfLUT;
+
+    Image lut = {
+        .data = calloc(RLG_BRDF_LUT_SIZE*RLG_BRDF_LUT_SIZE*3, sizeof(float)),
+        .width = RLG_BRDF_LUT_SIZE,
+        .height = RLG_BRDF_LUT_SIZE,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R32G32B32
+    };
+
+    if (lut.data == NULL)
+    {
+        TraceLog(LOG_ERROR, "Heap allocation for the BRDF lookup table failed");
+        return rlgCtx->skybox.brdfLUT;
+    }
+
+    // One row of roughness per job
+    rlgParallelFor(RLG_BRDF_LUT_SIZE, rlgComputeBRDFLUTRow, lut.data);
+
+    rlgCtx->skybox.brdfLUT = LoadTextureFromImage(lut);
+    SetTextureFilter(rlgCtx->skybox.brdfLUT, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(rlgCtx->skybox.brdfLUT, TEXTURE_WRAP_CLAMP);
+
+    UnloadImage(lut);
+
+    return rlgCtx->skybox.brdfLUT;
+}
+
+void RLG_SetIrradianceSampleCount(int count)
+{
+    if (count < 1) count = 1;
+    if (count > RLG_IRRADIANCE_MAX_SAMPLES) count = RLG_IRRADIANCE_MAX_SAMPLES;
+
+    rlgCtx->irradianceSamples = count;
+}
+
+int RLG_GetIrradianceSampleCount(void)
+{
+    return rlgCtx->irradianceSamples;
+}
+
+void RLG_UseIncrementalSkyboxBake(bool active)
+{
+    rlgCtx->incrementalBake = active;
+}
+
+bool RLG_IsIncrementalSkyboxBakeUsed(void)
+{
+    return rlgCtx->incrementalBake;
+}
+
+bool RLG_BakeSkyboxStep(RLG_Skybox *skybox, int tileCount)
+{
+    if (skybox->bakeTile >= skybox->bakeTileCount) return true;
+
+    Shader shader = rlgCtx->shaders[RLG_SHADER_IRRADIANCE_SAMPLING];
+
+    int size = skybox->irradiance.width;
+    int tilesPerRow = (size + RLG_IRRADIANCE_TILE_SIZE - 1)/RLG_IRRADIANCE_TILE_SIZE;
+    int tilesPerFace = tilesPerRow*tilesPerRow;
+
+    // The bake can happen between the draws of a frame, the state changed here is restored afterwards
+    rlDrawRenderBatchActive();
+
+    GLint previousFramebuffer = 0, viewport[4] = { 0 }, scissorBox[4] = { 0 };
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+
+    bool scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    unsigned int fbo = rlLoadFramebuffer(size, size);
+
+    rlEnableShader(shader.id);
+
+    Matrix matFboProjection = MatrixPerspective(90.0*DEG2RAD, 1.0, 0.1, 10.0);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+
+    float environmentSize = (float)skybox->cubemap.width;
+#   if GLSL_VERSION > 100
+    float implicitLod = 0.0f;
+#   else
+    float implicitLod = log2f(environmentSize/size);
+#   endif
+
+    rlSetUniform(rlgCtx->skybox.locSampleCount, &rlgCtx->irradianceSamples, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlgCtx->skybox.locEnvironmentSize, &environmentSize, SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(rlgCtx->skybox.locImplicitLod, &implicitLod, SHADER_UNIFORM_FLOAT, 1);
+
+    // Define view matrices for each cubemap face
+    Matrix fboViews[6] = {
+        MatrixLookAt((Vector3){0}, (Vector3){  1.0f,  0.0f,  0.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
+        MatrixLookAt((Vector3){0}, (Vector3){ -1.0f,  0.0f,  0.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
+        MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  1.0f,  0.0f}, (Vector3){ 0.0f,  0.0f,  1.0f}),
+        MatrixLookAt((Vector3){0}, (Vector3){  0.0f, -1.0f,  0.0f}, (Vector3){ 0.0f,  0.0f, -1.0f}),
+        MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f,  1.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
+        MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f, -1.0f}, (Vector3){ 0.0f, -1.0f,  0.0f})
+    };
+
+    rlActiveTextureSlot(0);
+    rlEnableTextureCubemap(skybox->cubemap.id);
+
+    rlDisableBackfaceCulling();
+    rlDisableDepthTest();
+    rlEnableScissorTest();
+
+    int attachedFace = -1;
+
+    for (int i = 0; i < tileCount && skybox->bakeTile < skybox->bakeTileCount; i++, skybox->bakeTile++)
+    {
+        int face = skybox->bakeTile/tilesPerFace;
+        int tile = skybox->bakeTile%tilesPerFace;
+
+        if (face != attachedFace)
+        {
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], fboViews[face]);
+            rlFramebufferAttach(fbo, skybox->irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + face, 0);
+            rlEnableFramebuffer(fbo);
+            rlViewport(0, 0, size, size);
+            attachedFace = face;
+        }
+
+        // The whole face is covered by the cube, the scissor keeps the texels of the tile
+        rlScissor((tile%tilesPerRow)*RLG_IRRADIANCE_TILE_SIZE, (tile/tilesPerRow)*RLG_IRRADIANCE_TILE_SIZE,
+            RLG_IRRADIANCE_TILE_SIZE, RLG_IRRADIANCE_TILE_SIZE);
+
+        rlLoadDrawCube();
+    }
+
+    rlDisableShader();
+    rlDisableTextureCubemap();
+    rlUnloadFramebuffer(fbo);
+
+    // Restore the previous state
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    rlViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    rlScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    if (!scissorTest) rlDisableScissorTest();
+    if (depthTest) rlEnableDepthTest();
+    rlEnableBackfaceCulling();
+
+#   if !defined(GRAPHICS_API_OPENGL_ES2)
+    // The irradiance of a packed skybox is rendered in float, then packed like its other cubemaps
+    if ((skybox->bakeTile >= skybox->bakeTileCount) && rlgIsPackedFormat(skybox->cubemap.format))
+    {
+        rlgPackCubemap(&skybox->irradiance, skybox->irradiance.mipmaps, skybox->cubemap.format,
+            rlgIsCubemapFormatRenderable(skybox->cubemap.format));
+    }
+#   endif
+
+    return (skybox->bakeTile >= skybox->bakeTileCount);
+}
+
+// Allocate the irradiance cubemap of a skybox, a sixteenth of the size of its environment
+static void rlgLoadIrradianceCubemap(RLG_Skybox *skybox)
+{
+    int size = skybox->cubemap.width/16;
+    size = (size < 8) ? 8 : size;
+
+    int format = skybox->cubemap.format;
+
+    // Cleared to black, as it is used before the end of an incremental bake
+    void *black = calloc(6, rlgGetPixelDataSize(size, size, format));
+
+    skybox->irradiance.id = rlgLoadCubemap(black, size, format);
+    free(black);
+    rlCubemapParameters(skybox->irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    rlCubemapParameters(skybox->irradiance.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+    skybox->irradiance.width = size;
+    skybox->irradiance.height = size;
+    skybox->irradiance.mipmaps = 1;
+    skybox->irradiance.format = format;
+}
+
+// Allocate the sampled irradiance cubemap of a skybox, its tiles then being rendered by RLG_BakeSkyboxStep
+static void rlgBeginIrradianceBake(RLG_Skybox *skybox)
+{
+    rlgLoadIrradianceCubemap(skybox);
+
+    int tilesPerRow = (skybox->irradiance.width + RLG_IRRADIANCE_TILE_SIZE - 1)/RLG_IRRADIANCE_TILE_SIZE;
+
+    skybox->bakeTile = 0;
+    skybox->bakeTileCount = 6*tilesPerRow*tilesPerRow;
+}
+
+// Map a file in memory, or read it where mapping is not supported
+static unsigned char *rlgMapFile(const char *fileName, size_t *size)
+{
+#   if defined(RLG_MMAP_SUPPORTED)
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    void *data = MAP_FAILED;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);  // The mapping stays valid
+
+    if (data == MAP_FAILED) return NULL;
+
+    *size = (size_t)st.st_size;
+    return (unsigned char*)data;
+#   else
+    unsigned int bytesRead = 0;
+    unsigned char *data = LoadFileData(fileName, &bytesRead);
+    *size = bytesRead;
+    return data;
+#   endif
+}
+
+static void rlgUnmapFile(unsigned char *data, size_t size)
+{
+#   if defined(RLG_MMAP_SUPPORTED)
+    munmap(data, size);
+#   else
+    UnloadFileData(data);
+#   endif
+}
+
+// Rows of a Radiance image decoded by each job of RLG_LoadImageHDR
+#define RLG_HDR_ROWS_PER_JOB 16
+
+struct rlgHDRDecode
+{
+    const unsigned char *data;
+    const size_t *rowOffsets;   ///< Offset of each scanline in the file data
+    const bool *rowEncoded;     ///< Scanlines in the new run-length encoding, the others are flat
+    float *pixels;
+    int width, height;
+};
+
+// Parse the header of a Radiance file, only the top to bottom and left to right orientation is supported
+static size_t rlgParseHDRHeader(const unsigned char *data, size_t size, int *width, int *height)
+{
+    if ((size < 11) || ((memcmp(data, "#?RADIANCE", 10) != 0) && (memcmp(data, "#?RGBE", 6) != 0))) return 0;
+
+    size_t p = 0;
+
+    // The variables end with an empty line
+    while (true)
+    {
+        size_t lineStart = p;
+        while ((p < size) && (data[p] != '\n')) p++;
+        if (p >= size) return 0;
+
+        size_t lineLength = p - lineStart;
+        p++;
+
+        if (lineLength == 0) break;
+
+        if ((lineLength >= 7) && (memcmp(data + lineStart, "FORMAT=", 7) == 0)
+            && ((lineLength != 7 + 15) || (memcmp(data + lineStart + 7, "32-bit_rle_rgbe", 15) != 0)))
+        {
+            return 0;
+        }
+    }
+
+    char resolution[64] = { 0 };
+    size_t lineLength = 0;
+    while ((p + lineLength < size) && (data[p + lineLength] != '\n') && (lineLength < sizeof(resolution) - 1))
+    {
+        resolution[lineLength] = (char)data[p + lineLength];
+        lineLength++;
+    }
+
+    if ((p + lineLength >= size) || (data[p + lineLength] != '\n')) return 0;
+    if (sscanf(resolution, "-Y %d +X %d", height, width) != 2) return 0;
+    if ((*width <= 0) || (*height <= 0)) return 0;
+
+    return p + lineLength + 1;
+}
+
+// Find the scanlines of a Radiance image, so that they can be decoded in parallel
+static bool rlgScanHDRRows(const unsigned char *data, size_t size, size_t p, int width, int height, size_t *rowOffsets, bool *rowEncoded)
+{
+    for (int y = 0; y < height; y++)
+    {
+        rowOffsets[y] = p;
+        rowEncoded[y] = (width >= 8) && (width < 32768) && (p + 4 <= size)
+            && (data[p] == 2) && (data[p + 1] == 2) && (((data[p + 2] << 8) | data[p + 3]) == width);
+
+        if (rowEncoded[y])
+        {
+            p += 4;
+
+            // Each of the four channels is a sequence of runs and of literal spans
+            for (int c = 0; c < 4; c++)
+            {
+                for (int x = 0; x < width; )
+                {
+                    if (p >= size) return false;
+
+                    int count = data[p++];
+                    bool run = (count > 128);
+                    if (run) count -= 128;
+
+                    if ((count == 0) || (x + count > width)) return false;
+
+                    p += run ? 1 : count;
+                    x += count;
+                }
+            }
+
+            if (p > size) return false;
+        }
+        else
+        {
+            if (p + 4*(size_t)width > size) return false;
+
+            // The old run-length encoding repeats the previous pixel, the rows then depend on each other
+            for (int x = 0; x < width; x++)
+            {
+                const unsigned char *rgbe = data + p + 4*x;
+                if ((rgbe[0] == 1) && (rgbe[1] == 1) && (rgbe[2] == 1)) return false;
+            }
+
+            p += 4*(size_t)width;
+        }
+    }
+
+    return true;
+}
+
+// Convert RGBE texels to floats, the channels being spaced by the given stride
+static void rlgConvertRGBE(const unsigned char *r, const unsigned char *g, const unsigned char *b, const unsigned char *e,
+    int stride, int count, float *rgb)
+{
+    int x = 0;
+
+#   if defined(__SSE2__)
+    // Four texels at a time from planar channels, each store writing one float past
+    // its texel, which is then overwritten, the last texel being left to the scalar loop
+    if (stride == 1)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi32(9);
+
+        for (; x + 4 < count; x += 4)
+        {
+            int r4, g4, b4, e4;
+            memcpy(&r4, r + x, 4); memcpy(&g4, g + x, 4);
+            memcpy(&b4, b + x, 4); memcpy(&e4, e + x, 4);
+
+            __m128i vr = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(r4), zero), zero);
+            __m128i vg = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(g4), zero), zero);
+            __m128i vb = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(b4), zero), zero);
+            __m128i ve = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(e4), zero), zero);
+
+            // 2^(e - 136) built from its exponent bits, the smallest exponents flushed to zero
+            __m128i bits = _mm_slli_epi32(_mm_sub_epi32(ve, bias), 23);
+            __m128 scale = _mm_castsi128_ps(_mm_and_si128(bits, _mm_cmpgt_epi32(ve, bias)));
+
+            __m128 fr = _mm_mul_ps(_mm_cvtepi32_ps(vr), scale);
+            __m128 fg = _mm_mul_ps(_mm_cvtepi32_ps(vg), scale);
+            __m128 fb = _mm_mul_ps(_mm_cvtepi32_ps(vb), scale);
+            __m128 fz = _mm_setzero_ps();
+
+            _MM_TRANSPOSE4_PS(fr, fg, fb, fz);
+
+            _mm_storeu_ps(rgb + 3*x + 0, fr);
+            _mm_storeu_ps(rgb + 3*x + 3, fg);
+            _mm_storeu_ps(rgb + 3*x + 6, fb);
+            _mm_storeu_ps(rgb + 3*x + 9, fz);
+        }
+    }
+#   endif
+
+    for (; x < count; x++)
+    {
+        int exponent = e[x*stride];
+
+        // Same scale as raylib, without the half unit rounding of the reference decoder
+        union { uint32_t bits; float value; } scale = { (exponent > 9) ? (uint32_t)(exponent - 9) << 23 : 0 };
+
+        rgb[3*x + 0] = r[x*stride]*scale.value;
+        rgb[3*x + 1] = g[x*stride]*scale.value;
+        rgb[3*x + 2] = b[x*stride]*scale.value;
+    }
+}
+
+static void rlgDecodeHDRRows(void *data, int job)
+{
+    const struct rlgHDRDecode *decode = (const struct rlgHDRDecode*)data;
+    int width = decode->width;
+
+    unsigned char *channels = (unsigned char*)malloc(4*(size_t)width);
+    if (channels == NULL) return;
+
+    int lastRow = (job + 1)*RLG_HDR_ROWS_PER_JOB;
+    if (lastRow > decode->height) lastRow = decode->height;
+
+    for (int y = job*RLG_HDR_ROWS_PER_JOB; y < lastRow; y++)
+    {
+        const unsigned char *p = decode->data + decode->rowOffsets[y];
+        float *rgb = decode->pixels + 3*(size_t)y*width;
+
+        if (decode->rowEncoded[y])
+        {
+            p += 4;
+
+            // The runs have been validated by rlgScanHDRRows
+            for (int c = 0; c < 4; c++)
+            {
+                unsigned char *channel = channels + c*width;
+
+                for (int x = 0; x < width; )
+                {
+                    int count = *p++;
+
+                    if (count > 128)
+                    {
+                        count -= 128;
+                        memset(channel + x, *p++, count);
+                    }
+                    else
+                    {
+                        memcpy(channel + x, p, count);
+                        p += count;
+                    }
+
+                    x += count;
+                }
+            }
+
+            rlgConvertRGBE(channels, channels + width, channels + 2*width, channels + 3*width, 1, width, rgb);
+        }
+        else
+        {
+            rlgConvertRGBE(p, p + 1, p + 2, p + 3, 4, width, rgb);
+        }
+    }
+
+    free(channels);
+}
+
+Image RLG_LoadImageHDR(const char *fileName)
+{
+    Image image = { 0 };
+
+    size_t size = 0;
+    unsigned char *data = rlgMapFile(fileName, &size);
+    if (data == NULL) return LoadImage(fileName);
+
+    int width = 0, height = 0;
+    size_t offset = rlgParseHDRHeader(data, size, &width, &height);
+
+    size_t *rowOffsets = NULL;
+    bool *rowEncoded = NULL;
+    float *pixels = NULL;
+
+    if (offset > 0)
+    {
+        rowOffsets = (size_t*)malloc(height*sizeof(size_t));
+        rowEncoded = (bool*)malloc(height*sizeof(bool));
+        pixels = (float*)malloc(3*(size_t)width*height*sizeof(float));
+    }
+
+    if ((offset == 0) || (rowOffsets == NULL) || (rowEncoded == NULL) || (pixels == NULL)
+        || !rlgScanHDRRows(data, size, offset, width, height, rowOffsets, rowEncoded))
+    {
+        // Left to raylib, which also reports the invalid files
+        free(rowOffsets);
+        free(rowEncoded);
+        free(pixels);
+        rlgUnmapFile(data, size);
+
+        return LoadImage(fileName);
+    }
+
+    struct rlgHDRDecode decode = { data, rowOffsets, rowEncoded, pixels, width, height };
+    rlgParallelFor((height + RLG_HDR_ROWS_PER_JOB - 1)/RLG_HDR_ROWS_PER_JOB, rlgDecodeHDRRows, &decode);
+
+    free(rowOffsets);
+    free(rowEncoded);
+    rlgUnmapFile(data, size);
+
+    image.data = pixels;
+    image.width = width;
+    image.height = height;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32;
+
+    TraceLog(LOG_INFO, "IMAGE: Radiance image decoded (%ix%i | R32G32B32)", width, height);
+
+    return image;
+}
+
+// Direction of a point of a cubemap face, with the face orientations of OpenGL, s and t going from -1 to 1
+static Vector3 rlgGetCubemapFaceDirection(int face, float s, float t)
+{
+    Vector3 directions[6] = {
+        {  1.0f,    -t,    -s },
+        { -1.0f,    -t,     s },
+        {     s,  1.0f,     t },
+        {     s, -1.0f,    -t },
+        {     s,    -t,  1.0f },
+        {    -s,    -t, -1.0f }
+    };
+
+    return directions[face];
+}
+
+static Vector3 rlgGetCubemapTexelDirection(int face, int x, int y, int size)
+{
+    return Vector3Normalize(rlgGetCubemapFaceDirection(face, 2.0f*(x + 0.5f)/size - 1.0f, 2.0f*(y + 0.5f)/size - 1.0f));
+}
+
+// Give a skybox the cube drawn by RLG_DrawSkybox, loaded once per context
+static void rlgLoadSkyboxGeometry(RLG_Skybox *skybox)
+{
+    struct RLG_SkyboxHandling *sh = &rlgCtx->skybox;
+
+    if (sh->vboPositionsId != 0)
+    {
+        skybox->vaoID = sh->vaoId;
+        skybox->vboPostionsID = sh->vboPositionsId;
+        skybox->vboIndicesID = sh->vboIndicesId;
+        return;
+    }
+
+    // Define the positions of the vertices for a cube
+    static const float positions[] =
+    {
+        // Front face
+        -0.5f, -0.5f,  0.5f,    // Vertex 0
+         0.5f, -0.5f,  0.5f,    // Vertex 1
+         0.5f,  0.5f,  0.5f,    // Vertex 2
+        -0.5f,  0.5f,  0.5f,    // Vertex 3
+
+        // Back face
+        -0.5f, -0.5f, -0.5f,    // Vertex 4
+         0.5f, -0.5f, -0.5f,    // Vertex 5
+         0.5f,  0.5f, -0.5f,    // Vertex 6
+        -0.5f,  0.5f, -0.5f     // Vertex 7
+    };
+
+    // Define the indices for drawing the cube faces
+    const unsigned short indices[] =
+    {
+        // Front face
+        0, 1, 2,
+        2, 3, 0,
+
+        // Right face
+        1, 5, 6,
+        6, 2, 1,
+
+        // Back face
+        5, 4, 7,
+        7, 6, 5,
+
+        // Left face
+        4, 0, 3,
+        3, 7, 4,
+
+        // Top face
+        3, 2, 6,
+        6, 7, 3,
+
+        // Bottom face
+        4, 5, 1,
+        1, 0, 4
+    };
+
+    // Load vertex array object (VAO) and bind it
+    sh->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(sh->vaoId);
+    {
+        // Load vertex buffer object (VBO) for positions and bind it
+        sh->vboPositionsId = rlLoadVertexBuffer(positions, sizeof(positions), false);
+        rlSetVertexAttribute(0, 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(0);
+
+        // Load element buffer object (EBO) for indices and bind it
+        sh->vboIndicesId = rlLoadVertexBufferElement(indices, sizeof(indices), false);
+    }
+    rlDisableVertexArray();
+
+    rlgLoadSkyboxGeometry(skybox);
+}
+
+RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName)
+{
+    RLG_Skybox skybox = { 0 };
+
+    rlgLoadSkyboxGeometry(&skybox);
+
+    // Load the cubemap texture from the image file
+    Image img = LoadImage(skyboxFileName);
+    skybox.cubemap = LoadTextureCubemap(img, CUBEMAP_LAYOUT_AUTO_DETECT);
+    if (skybox.cubemap.format == 0) skybox.cubemap.format = img.format;    // Not set by some raylib versions, the faces keep the image format
+    UnloadImage(img);
+
+    bool useSH = (rlgCtx->irradianceMode == RLG_IRRADIANCE_SH9);
+
+#   if defined(GRAPHICS_API_OPENGL_ES2)
+    if (useSH)
+    {
+        TraceLog(LOG_WARNING, "The SH9 irradiance of LDR skyboxes is not supported on OpenGL ES, generating an irradiance cubemap");
+        useSH = false;
+    }
+#   else
+    // The faces are read back after the layout of the image has been resolved by raylib
+    if (useSH) useSH = rlgProjectCubemapSH(skybox.cubemap, skybox.irradianceSH);
+#   endif
+
+    // Generate the prefiltered radiance, from the mipmaps of the environment
+    rlgGenEnvironmentMipmaps(&skybox);
+    rlgGenPrefilterCubemap(&skybox);
+
+    // Generate Irradiance Cubemap
+    if (rlgCtx->irradianceMode == RLG_IRRADIANCE_SAMPLED_CUBEMAP)
+    {
+        rlgBeginIrradianceBake(&skybox);
+        if (!rlgCtx->incrementalBake) RLG_BakeSkyboxStep(&skybox, skybox.bakeTileCount);
+    }
+    else if (!useSH)
+    {
+        int size = skybox.cubemap.width / 16;
+        size = (size < 8) ? 8 : size;
+
+        // Create a renderbuffer for depth attachment
+        unsigned int rbo = rlLoadTextureDepth(size, size, true);
+
+        // Create a cubemap texture to hold the HDR data
+        skybox.irradiance.id = rlgLoadCubemap(NULL, size, skybox.cubemap.format);
+        rlCubemapParameters(skybox.irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+        rlCubemapParameters(skybox.irradiance.id, GL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+        // Create and configure the framebuffer
+        unsigned int fbo = rlLoadFramebuffer(size, size);
+        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+        rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+
+        // Validate the framebuffer configuration
+        if (rlFramebufferComplete(fbo))
+        {
+            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
+        }  
+
+        // Enable the shader for converting HDR equirectangular environment map to cubemap faces
+        rlEnableShader(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].id);
+
+        // Set the projection matrix for the shader
+        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+
+        // Define view matrices for each cubemap face
+        Matrix fboViews[6] = {
+            MatrixLookAt((Vector3){0}, (Vector3){  1.0f,  0.0f,  0.0f}, (Vector3) {0.0f, -1.0f,  0.0f}),
+            MatrixLookAt((Vector3){0}, (Vector3){ -1.0f,  0.0f,  0.0f}, (Vector3) {0.0f, -1.0f,  0.0f}),
+            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  1.0f,  0.0f}, (Vector3) {0.0f,  0.0f,  1.0f}),
+            MatrixLookAt((Vector3){0}, (Vector3){  0.0f, -1.0f,  0.0f}, (Vector3) {0.0f,  0.0f, -1.0f}),
+            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f,  1.0f}, (Vector3) {0.0f, -1.0f,  0.0f}),
+            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f, -1.0f}, (Vector3) {0.0f, -1.0f,  0.0f})
+        };
+
+        // Set the viewport to match the framebuffer dimensions
+        rlViewport(0, 0, size, size);
+        rlDisableBackfaceCulling();
+
+        // Activate the panorama texture
+        rlActiveTextureSlot(0);
+        rlEnableTextureCubemap(skybox.cubemap.id);
+
+        for (int i = 0; i < 6; i++)
+        {
+            // Set the view matrix for the current cubemap face
+            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
+            
+            // Attach the current cubemap face to the framebuffer
+            rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
+            rlEnableFramebuffer(fbo);
+
+            // Clear the framebuffer and draw the cube face
+            rlClearScreenBuffers();
+            rlLoadDrawCube();
+        }
+
+        // Disable the shader and textures
+        rlDisableShader();
+        rlDisableTextureCubemap();
+        rlDisableFramebuffer();
+
+        // Unload the framebuffer and its attachments
+        rlUnloadFramebuffer(fbo);
+
+        // Reset the viewport to default dimensions
+        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+        rlEnableBackfaceCulling();
+
+        // Set the irradiance cubemap properties
+        skybox.irradiance.width = size;
+        skybox.irradiance.height = size;
+        skybox.irradiance.mipmaps = 1;
+        skybox.irradiance.format = skybox.cubemap.format;
+    }
+
+    return skybox;
+}
+
+// Bytes of the panorama uploaded by each poll of an asynchronous skybox load
+#define RLG_SKYBOX_UPLOAD_SIZE          (4*1024*1024)
+
+// Irradiance tiles rendered by each poll of an asynchronous skybox load (sampled cubemap mode only)
+#define RLG_SKYBOX_LOAD_TILES           4
+
+// Size of the faces of the irradiance cubemap evaluated from the SH9 projection of the panorama,
+// standing for the irradiance of an asynchronous load until it is rendered
+#define RLG_SKYBOX_PLACEHOLDER_SIZE     8
+
+// Stages of a skybox load, each step of a stage keeping the work of a poll bounded
+enum rlgSkyboxLoadStage
+{
+    RLG_SKYBOX_STAGE_DECODE = 0,            ///< Panorama decoded and projected to SH9 by the worker thread
+    RLG_SKYBOX_STAGE_UPLOAD,                ///< Rows of the panorama uploaded through a pixel buffer object
+    RLG_SKYBOX_STAGE_CUBEMAP,               ///< One face of the environment cubemap rendered per step
+    RLG_SKYBOX_STAGE_PREFILTER,             ///< One face of a level of the prefiltered radiance rendered per step
+    RLG_SKYBOX_STAGE_IRRADIANCE,            ///< One face, or a few tiles, of the irradiance cubemap rendered per step
+    RLG_SKYBOX_STAGE_PACK,                  ///< One cubemap converted to the packed format per step
+    RLG_SKYBOX_STAGE_DONE
+};
+
+struct rlgSkyboxLoad
+{
+    char *fileName;
+    int size;
+    int format;                             ///< Format of the bake, float for the packed formats
+    int packedFormat;                       ///< Format the cubemaps are converted to once baked, 0 if none
+    RLG_IrradianceMode irradianceMode;
+    bool async;                             ///< Work spread over the polls, false for RLG_LoadSkyboxHDR
+
+    /* Written by the worker thread until decoded is set */
+
+    Image image;
+    Vector3 irradianceSH[9];
+    bool decoded;
+
+#   ifdef RLG_ASYNC_LOAD_SUPPORTED
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    bool threadStarted;
+#   endif
+
+    /* Owned by the thread of the OpenGL context */
+
+    int stage;                              ///< One of the values of rlgSkyboxLoadStage
+    int step;
+    Texture2D panorama;
+    unsigned int pbo;
+    TextureCubemap placeholder;
+    RLG_Skybox skybox;
+};
+
+// Decode the panorama of a skybox and project it to SH9, on the worker thread of the load
+static void *rlgDecodeSkyboxSource(void *arg)
+{
+    struct rlgSkyboxLoad *load = (struct rlgSkyboxLoad*)arg;
+
+    Image image = RLG_LoadImageHDR(load->fileName);
+    Vector3 coefficients[9] = { 0 };
+
+    // The projection is the irradiance of the SH9 mode, and the placeholder of the asynchronous loads
+    if ((image.data != NULL) && (load->async || (load->irradianceMode == RLG_IRRADIANCE_SH9)))
+    {
+        rlgProjectImageSH(image, coefficients);
+    }
+
+#   ifdef RLG_ASYNC_LOAD_SUPPORTED
+    if (load->threadStarted) pthread_mutex_lock(&load->mutex);
+#   endif
+
+    load->image = image;
+    memcpy(load->irradianceSH, coefficients, sizeof(coefficients));
+    load->decoded = true;
+
+#   ifdef RLG_ASYNC_LOAD_SUPPORTED
+    if (load->threadStarted) pthread_mutex_unlock(&load->mutex);
+#   endif
+
+    return NULL;
+}
+
+// Check if the panorama of a load is decoded, decoding it on the calling thread when no worker thread runs
+static bool rlgIsSkyboxSourceDecoded(struct rlgSkyboxLoad *load)
+{
+#   ifdef RLG_ASYNC_LOAD_SUPPORTED
+    if (load->threadStarted)
+    {
+        pthread_mutex_lock(&load->mutex);
+        bool decoded = load->decoded;
+        pthread_mutex_unlock(&load->mutex);
+
+        if (!decoded) return false;
+
+        pthread_join(load->thread, NULL);
+        load->threadStarted = false;
+
+        return true;
+    }
+#   endif
+
+    if (!load->decoded) rlgDecodeSkyboxSource(load);
+
+    return true;
+}
+
+// Irradiance cubemap evaluated on the CPU from SH9 coefficients, as the lighting shader does
+static TextureCubemap rlgLoadIrradiancePlaceholder(const Vector3 coefficients[9], int format)
+{
+    const int size = RLG_SKYBOX_PLACEHOLDER_SIZE;
+
+    Image faces = {
+        .data = malloc(6*3*size*size*sizeof(float)),
+        .width = size,
+        .height = 6*size,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R32G32B32
+    };
+
+    if (faces.data == NULL) return (TextureCubemap) { 0 };
+
+    float *texel = (float*)faces.data;
+
+    for (int face = 0; face < 6; face++)
+    {
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++, texel += 3)
+            {
+                Vector3 n = rlgGetCubemapTexelDirection(face, x, y, size);
+                const Vector3 *c = coefficients;
+
+                Vector3 e = c[0];
+                e = Vector3Add(e, Vector3Scale(c[1], n.y));
+                e = Vector3Add(e, Vector3Scale(c[2], n.z));
+                e = Vector3Add(e, Vector3Scale(c[3], n.x));
+                e = Vector3Add(e, Vector3Scale(c[4], n.x*n.y));
+                e = Vector3Add(e, Vector3Scale(c[5], n.y*n.z));
+                e = Vector3Add(e, Vector3Scale(c[6], 3.0f*n.z*n.z - 1.0f));
+                e = Vector3Add(e, Vector3Scale(c[7], n.x*n.z));
+                e = Vector3Add(e, Vector3Scale(c[8], n.x*n.x - n.y*n.y));
+
+                texel[0] = fmaxf(e.x, 0.0f);
+                texel[1] = fmaxf(e.y, 0.0f);
+                texel[2] = fmaxf(e.z, 0.0f);
+            }
+        }
+    }
+
+    if (format != PIXELFORMAT_UNCOMPRESSED_R32G32B32) ImageFormat(&faces, format);
+
+    TextureCubemap placeholder = { 0 };
+
+    placeholder.id = rlgLoadCubemap(faces.data, size, format);
+    rlCubemapParameters(placeholder.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    rlCubemapParameters(placeholder.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+    placeholder.width = size;
+    placeholder.height = size;
+    placeholder.mipmaps = 1;
+    placeholder.format = format;
+
+    UnloadImage(faces);
+
+    return placeholder;
+}
+
+// Upload rows of the decoded panorama, through the pixel buffer object of the load when there is one
+static void rlgUploadPanoramaRows(struct rlgSkyboxLoad *load, int firstRow, int rowCount)
+{
+    int glInternalFormat, glFormat, glType;
+    rlGetGlTextureFormats(load->image.format, &glInternalFormat, &glFormat, &glType);
+
+    size_t rowSize = (size_t)GetPixelDataSize(load->image.width, 1, load->image.format);
+    const unsigned char *rows = (const unsigned char*)load->image.data + firstRow*rowSize;
+
+    glBindTexture(GL_TEXTURE_2D, load->panorama.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+#   if !defined(GRAPHICS_API_OPENGL_ES2)
+    if (load->pbo != 0)
+    {
+        size_t size = rowCount*rowSize;
+
+        // Orphaned, so that the driver can still be reading the previous rows
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, load->pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        if (mapped != NULL)
+        {
+            memcpy(mapped, rows, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+            // The copy to the texture is done by the driver, without stalling the calling thread
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, load->image.width, rowCount, glFormat, glType, NULL);
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (mapped != NULL)
+        {
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return;
+        }
+    }
+#   endif
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, load->image.width, rowCount, glFormat, glType, rows);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static struct rlgSkyboxLoad *rlgCreateSkyboxLoad(const char *skyboxFileName, int size, int format, bool async)
+{
+    struct rlgSkyboxLoad *load = (struct rlgSkyboxLoad*)calloc(1, sizeof(struct rlgSkyboxLoad));
+    if (load == NULL) return NULL;
+
+    load->fileName = (char*)malloc(strlen(skyboxFileName) + 1);
+
+    if (load->fileName == NULL)
+    {
+        free(load);
+        return NULL;
+    }
+
+    strcpy(load->fileName, skyboxFileName);
+
+    // The packed formats are converted once the float bake is done, as their
+    // rounding would accumulate through the mipmaps and the convolutions
+    if (rlgIsPackedFormat(format))
+    {
+#   if defined(GRAPHICS_API_OPENGL_ES2)
+        TraceLog(LOG_WARNING, "Packed skybox formats are not supported on OpenGL ES 2.0, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 is used instead");
+        format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+#   else
+        load->packedFormat = format;
+        format = PIXELFORMAT_UNCOMPRESSED_R32G32B32;
+#   endif
+    }
+
+    load->size = size;
+    load->format = format;
+    load->irradianceMode = rlgCtx->irradianceMode;
+    load->async = async;
+
+    return load;
+}
+
+// Free a load and the textures it still owns, the skybox included unless it was handed to the application
+static void rlgUnloadSkyboxLoad(struct rlgSkyboxLoad *load, bool unloadSkybox)
+{
+#   ifdef RLG_ASYNC_LOAD_SUPPORTED
+    if (load->threadStarted) pthread_join(load->thread, NULL);
+    if (load->async) pthread_mutex_destroy(&load->mutex);
+#   endif
+
+    UnloadImage(load->image);
+    UnloadTexture(load->panorama);
+    UnloadTexture(load->placeholder);
+
+#   if !defined(GRAPHICS_API_OPENGL_ES2)
+    if (load->pbo != 0) glDeleteBuffers(1, &load->pbo);
+#   endif
+
+    if (unloadSkybox) RLG_UnloadSkybox(load->skybox);
+
+    free(load->fileName);
+    free(load);
+}
+
+// Run the next step of a load, returning true once the skybox is complete
+static bool rlgStepSkyboxLoad(struct rlgSkyboxLoad *load)
+{
+    RLG_Skybox *skybox = &load->skybox;
+
+    if (load->stage == RLG_SKYBOX_STAGE_DECODE)
+    {
+        if (!rlgIsSkyboxSourceDecoded(load)) return false;
+
+        if (load->image.data == NULL)
+        {
+            TraceLog(LOG_WARNING, "SKYBOX: [%s] Failed to load the panorama", load->fileName);
+            load->stage = RLG_SKYBOX_STAGE_DONE;
+            return true;
+        }
+
+        rlgLoadSkyboxGeometry(skybox);
+        skybox->isHDR = true;
+
+        if (load->irradianceMode == RLG_IRRADIANCE_SH9)
+        {
+            memcpy(skybox->irradianceSH, load->irradianceSH, sizeof(skybox->irradianceSH));
+        }
+        else if (load->async)
+        {
+            load->placeholder = rlgLoadIrradiancePlaceholder(load->irradianceSH, load->format);
+        }
+
+        load->stage = RLG_SKYBOX_STAGE_UPLOAD;
+        load->step = 0;
+
+        return false;
+    }
+
+    // The steps can happen between the draws of a frame, the state changed here is restored afterwards
+    rlDrawRenderBatchActive();
+
+    GLint previousFramebuffer = 0, viewport[4] = { 0 };
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    switch (load->stage)
+    {
+        case RLG_SKYBOX_STAGE_UPLOAD:
+        {
+            Image *image = &load->image;
+
+            if (load->step == 0)
+            {
+                load->panorama.id = rlLoadTexture(NULL, image->width, image->height, image->format, 1);
+                load->panorama.width = image->width;
+                load->panorama.height = image->height;
+                load->panorama.mipmaps = 1;
+                load->panorama.format = image->format;
+
+#           if !defined(GRAPHICS_API_OPENGL_ES2)
+                if (load->async) glGenBuffers(1, &load->pbo);
+#           endif
+            }
+
+            int rowCount = image->height - load->step;
+
+            if (load->async)
+            {
+                int budget = RLG_SKYBOX_UPLOAD_SIZE/GetPixelDataSize(image->width, 1, image->format);
+                budget = (budget < 1) ? 1 : budget;
+                rowCount = (rowCount < budget) ? rowCount : budget;
+            }
+
+            rlgUploadPanoramaRows(load, load->step, rowCount);
+            load->step += rowCount;
+
+            if (load->step >= image->height)
+            {
+                UnloadImage(*image);
+                *image = (Image) { 0 };
+
+                load->stage = RLG_SKYBOX_STAGE_CUBEMAP;
+                load->step = 0;
+            }
+        } break;
+        case RLG_SKYBOX_STAGE_CUBEMAP:
+        {
+            if (load->step == 0)
+            {
+                skybox->cubemap.id = rlgLoadCubemap(NULL, load->size, load->format);
+                skybox->cubemap.width = load->size;
+                skybox->cubemap.height = load->size;
+                skybox->cubemap.mipmaps = 1;
+                skybox->cubemap.format = load->format;
+            }
 
-    // Get a copy of current matrices to work with,
-    // just in case stereo render is required, and we need to modify them
-    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
-    // That's because BeginMode3D() sets it and there is no model-drawing function
-    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
-    Matrix matModel = MatrixIdentity();
-    Matrix matView = rlGetMatrixModelview();
-    Matrix matModelView = MatrixIdentity();
-    Matrix matProjection = rlGetMatrixProjection();
+            for (int i = 0; i < (load->async ? 1 : 6); i++, load->step++)
+            {
+                rlgRenderCubemapFace(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP],
+                    load->panorama.id, false, skybox->cubemap, load->step, 0);
+            }
 
-    // Upload view matrix (if location available)
-    if (shader->locs[RLG_LOC_MATRIX_VIEW] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_VIEW], matView);
+            if (load->step >= 6)
+            {
+                UnloadTexture(load->panorama);
+                load->panorama = (Texture2D) { 0 };
 
-    // Upload projection matrix (if location available)
-    if (shader->locs[RLG_LOC_MATRIX_PROJECTION] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_PROJECTION], matProjection);
+                load->stage = RLG_SKYBOX_STAGE_PREFILTER;
+                load->step = 0;
+            }
+        } break;
+        case RLG_SKYBOX_STAGE_PREFILTER:
+        {
+            // The prefiltered radiance is sampled from the mipmaps of the environment
+            if (load->step == 0)
+            {
+                rlgGenEnvironmentMipmaps(skybox);
+                rlgLoadPrefilterCubemap(skybox);
+            }
 
-    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
-    if (shader->locs[RLG_LOC_MATRIX_MODEL] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MODEL], transform);
+            for (int i = 0; i < (load->async ? 1 : 6*RLG_PREFILTER_MIP_LEVELS); i++, load->step++)
+            {
+                rlgRenderPrefilterFace(skybox, load->step/6, load->step%6);
+            }
 
-    // Accumulate several model transformations:
-    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
-    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
-    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+            if (load->step >= 6*RLG_PREFILTER_MIP_LEVELS)
+            {
+                load->stage = RLG_SKYBOX_STAGE_IRRADIANCE;
+                load->step = 0;
+            }
+        } break;
+        case RLG_SKYBOX_STAGE_IRRADIANCE:
+        {
+            bool complete = true;
 
-    // Get model-view matrix
-    matModelView = MatrixMultiply(matModel, matView);
+            if (load->irradianceMode == RLG_IRRADIANCE_SAMPLED_CUBEMAP)
+            {
+                if (load->step == 0) rlgBeginIrradianceBake(skybox);
 
-    // Upload model normal matrix (if locations available)
-    if (shader->locs[RLG_LOC_MATRIX_NORMAL] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
-    //-----------------------------------------------------
+                // Left to RLG_BakeSkyboxStep by RLG_LoadSkyboxHDR in the incremental mode
+                if (load->async) complete = RLG_BakeSkyboxStep(skybox, RLG_SKYBOX_LOAD_TILES);
+                else if (!rlgCtx->incrementalBake) RLG_BakeSkyboxStep(skybox, skybox->bakeTileCount);
 
-    // Bind active texture maps (if available)
-    for (int i = 0; i < 11; i++)
-    {
-        if (rlgCtx->material.data.useMaps[i])
+                load->step++;
+            }
+            else if (load->irradianceMode != RLG_IRRADIANCE_SH9)
+            {
+                if (load->step == 0) rlgLoadIrradianceCubemap(skybox);
+
+                for (int i = 0; i < (load->async ? 1 : 6); i++, load->step++)
+                {
+                    rlgRenderCubemapFace(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION],
+                        skybox->cubemap.id, true, skybox->irradiance, load->step, 0);
+                }
+
+                complete = (load->step >= 6);
+            }
+
+            if (complete)
+            {
+                load->stage = (load->packedFormat != 0) ? RLG_SKYBOX_STAGE_PACK : RLG_SKYBOX_STAGE_DONE;
+                load->step = 0;
+            }
+        } break;
+#   if !defined(GRAPHICS_API_OPENGL_ES2)
+        case RLG_SKYBOX_STAGE_PACK:
         {
-            int textureID = (rlgCtx->usedDefaultMaps[i])
-                ? rlgCtx->defaultMaps[i].texture.id
-                : material.maps[i].texture.id;
+            bool renderable = rlgIsCubemapFormatRenderable(load->packedFormat);
 
-            if (textureID > 0)
+            if ((load->step == 0) && !renderable)
             {
-                // Select current shader texture slot
-                rlActiveTextureSlot(i);
+                TraceLog(LOG_INFO, "SKYBOX: Packed format not renderable, the skybox is converted on the CPU");
+            }
 
-                // Enable texture for active slot
-                if (i == MATERIAL_MAP_IRRADIANCE ||
-                    i == MATERIAL_MAP_PREFILTER ||
-                    i == MATERIAL_MAP_CUBEMAP)
+            for (int i = 0; i < (load->async ? 1 : 3); i++, load->step++)
+            {
+                if (load->step == 0)
                 {
-                    rlEnableTextureCubemap(textureID);
+                    rlgPackCubemap(&skybox->cubemap, skybox->cubemap.mipmaps, load->packedFormat, renderable);
                 }
-                else
+                else if (load->step == 1)
                 {
-                    rlEnableTexture(textureID);
+                    rlgPackCubemap(&skybox->prefilter, 1 + (int)floorf(log2f((float)skybox->prefilter.width)), load->packedFormat, renderable);
                 }
+                else if ((skybox->irradiance.id != 0) && (skybox->bakeTile >= skybox->bakeTileCount))
+                {
+                    // An irradiance still baked by RLG_BakeSkyboxStep stays in float, as it is rendered to
+                    rlgPackCubemap(&skybox->irradiance, skybox->irradiance.mipmaps, load->packedFormat, renderable);
+                }
+            }
 
-                rlSetUniform(shader->locs[RLG_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+            if (load->step >= 3)
+            {
+                load->stage = RLG_SKYBOX_STAGE_DONE;
+                load->step = 0;
             }
-        }
+        } break;
+#   endif
+        default: break;
     }
 
-    // Bind depth textures for shadow mapping
-    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    // Restore the previous state
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    rlViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (depthTest) rlEnableDepthTest();
+    rlEnableBackfaceCulling();
+
+    if (load->stage != RLG_SKYBOX_STAGE_DONE) return false;
+
+    TraceLog(LOG_INFO, "SKYBOX: [%s] Loaded, %.2f MB of video memory", load->fileName, RLG_GetSkyboxMemory(*skybox)/(1024.0f*1024.0f));
+
+    return true;
+}
+
+RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format)
+{
+    RLG_Skybox skybox = { 0 };
+
+    // Same stages as an asynchronous load, all run by the calling thread
+    struct rlgSkyboxLoad *load = rlgCreateSkyboxLoad(skyboxFileName, size, format, false);
+
+    if (load == NULL)
     {
-        const struct RLG_Light *l = &rlgCtx->lights[i];
+        TraceLog(LOG_ERROR, "Heap allocation for the loading of the skybox [%s] failed", skyboxFileName);
+        return skybox;
+    }
 
-        if (l->data.enabled && l->data.shadow)
-        {
-            int j = 11 + i;
-            rlActiveTextureSlot(j);
+    while (!rlgStepSkyboxLoad(load)) { }
 
-            if (l->data.type == RLG_OMNILIGHT)
-            {
-                rlEnableTextureCubemap(l->data.shadowMap.depth.id);
-                rlSetUniform(l->locs.shadowCubemap, &j, SHADER_UNIFORM_INT, 1);
-            }
-            else
-            {
-                rlEnableTexture(l->data.shadowMap.depth.id);
-                rlSetUniform(l->locs.shadowMap, &j, SHADER_UNIFORM_INT, 1);
-            }
-        }
+    skybox = load->skybox;
+    rlgUnloadSkyboxLoad(load, false);
+
+    return skybox;
+}
+
+RLG_SkyboxLoad RLG_LoadSkyboxHDRAsync(const char* skyboxFileName, int size, int format)
+{
+    struct rlgSkyboxLoad *load = rlgCreateSkyboxLoad(skyboxFileName, size, format, true);
+
+    if (load == NULL)
+    {
+        TraceLog(LOG_ERROR, "Heap allocation for the loading of the skybox [%s] failed", skyboxFileName);
+        return NULL;
     }
 
-    // Try binding vertex array objects (VAO) or use VBOs if not possible
-    // WARNING: UploadMesh() enables all vertex attributes available in mesh and sets default attribute values
-    // for shader expected vertex attributes that are not provided by the mesh (i.e. colors)
-    // This could be a dangerous approach because different meshes with different shaders can enable/disable some attributes
-    if (!rlEnableVertexArray(mesh.vaoId))
+    // Without a worker thread, the panorama is decoded by the first poll
+#   ifdef RLG_ASYNC_LOAD_SUPPORTED
+    pthread_mutex_init(&load->mutex, NULL);
+    load->threadStarted = true;
+
+    if (pthread_create(&load->thread, NULL, rlgDecodeSkyboxSource, load) != 0)
     {
-        // Bind mesh VBO data: vertex position (shader-location = 0)
-        rlEnableVertexBuffer(mesh.vboId[0]);
-        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION]);
+        TraceLog(LOG_WARNING, "SKYBOX: [%s] Failed to start the decoding thread, the first poll decodes the panorama", skyboxFileName);
+        load->threadStarted = false;
+    }
+#   endif
 
-        // Bind mesh VBO data: vertex texcoords (shader-location = 1)
-        rlEnableVertexBuffer(mesh.vboId[1]);
-        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01]);
+    return (RLG_SkyboxLoad)load;
+}
 
-        if (shader->locs[RLG_LOC_VERTEX_NORMAL] != -1)
-        {
-            // Bind mesh VBO data: vertex normals (shader-location = 2)
-            rlEnableVertexBuffer(mesh.vboId[2]);
-            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL], 3, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL]);
-        }
+bool RLG_PollSkybox(RLG_SkyboxLoad handle, RLG_Skybox *skybox)
+{
+    struct rlgSkyboxLoad *load = (struct rlgSkyboxLoad*)handle;
 
-        // Bind mesh VBO data: vertex colors (shader-location = 3, if available)
-        if (shader->locs[RLG_LOC_VERTEX_COLOR] != -1)
-        {
-            if (mesh.vboId[3] != 0)
-            {
-                rlEnableVertexBuffer(mesh.vboId[3]);
-                rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, 1, 0, 0);
-                rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
-            }
-            else
-            {
-                // Set default value for defined vertex attribute in shader but not provided by mesh
-                // WARNING: It could result in GPU undefined behaviour
-                float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-                rlSetVertexAttributeDefault(shader->locs[RLG_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC4, 4);
-                rlDisableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
-            }
-        }
+    if (load == NULL)
+    {
+        *skybox = (RLG_Skybox) { 0 };
+        return true;
+    }
 
-        // Bind mesh VBO data: vertex tangents (shader-location = 4, if available)
-        if (shader->locs[RLG_LOC_VERTEX_TANGENT] != -1)
-        {
-            rlEnableVertexBuffer(mesh.vboId[4]);
-            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT], 4, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT]);
-        }
+    if (rlgStepSkyboxLoad(load))
+    {
+        *skybox = load->skybox;
+        rlgUnloadSkyboxLoad(load, false);
+        return true;
+    }
 
-        // Bind mesh VBO data: vertex texcoords2 (shader-location = 5, if available)
-        if (shader->locs[RLG_LOC_VERTEX_TEXCOORD02] != -1)
-        {
-            rlEnableVertexBuffer(mesh.vboId[5]);
-            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02], 2, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02]);
-        }
+    // The textures still being rendered are left out, the irradiance being replaced by the placeholder
+    *skybox = load->skybox;
 
-        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+    if (load->stage <= RLG_SKYBOX_STAGE_CUBEMAP) skybox->cubemap = (TextureCubemap) { 0 };
+    if (load->stage <= RLG_SKYBOX_STAGE_PREFILTER) skybox->prefilter = (TextureCubemap) { 0 };
+    if (load->stage <= RLG_SKYBOX_STAGE_IRRADIANCE) skybox->irradiance = load->placeholder;
+
+    return false;
+}
+
+void RLG_CancelSkyboxLoad(RLG_SkyboxLoad handle)
+{
+    if (handle != NULL) rlgUnloadSkyboxLoad((struct rlgSkyboxLoad*)handle, true);
+}
+
+// Identifier and version of the skybox bake files
+#define RLG_SKYBOX_BAKE_MAGIC       "RLGSKYBX"
+#define RLG_SKYBOX_BAKE_VERSION     1
+
+// Header of the skybox bake files, followed by the levels of the cubemap,
+// of the prefiltered radiance and of the irradiance cubemap, each level holding its six faces
+struct RLG_SkyboxBakeHeader
+{
+    /* Key of the bake, compared as a whole by RLG_LoadSkyboxBake */
+
+    char magic[8];
+    uint32_t version;               ///< Also rejects the files written with another byte order
+    int32_t irradianceMode;
+    int32_t irradianceSamples;      ///< Only set in the sampled cubemap mode
+    int32_t prefilterSamples;
+    int32_t prefilterMaxSize;
+    int32_t prefilterMipLevels;
+    uint64_t sourceHash;            ///< FNV-1a hash of the source file, 0 if it was not given
+
+    /* Content of the bake */
+
+    int32_t format;
+    int32_t isHDR;
+    int32_t cubemapSize, cubemapLevels;
+    int32_t prefilterSize, prefilterLevels;
+    int32_t irradianceSize;         ///< 0 when the irradiance is only stored as SH9
+    float irradianceSH[27];
+};
+
+// FNV-1a hash of the content of a file, identifying the source of a skybox bake
+static bool rlgHashFile(const char *fileName, uint64_t *hash)
+{
+    size_t size = 0;
+    unsigned char *data = rlgMapFile(fileName, &size);
+
+    if (data == NULL)
+    {
+        TraceLog(LOG_WARNING, "Failed to read the skybox source file [%s] to hash it", fileName);
+        return false;
     }
 
-    int eyeCount = 1;
-    if (rlIsStereoRenderEnabled()) eyeCount = 2;
+    uint64_t h = 14695981039346656037ULL;
 
-    for (int eye = 0; eye < eyeCount; eye++)
+    for (size_t i = 0; i < size; i++)
     {
-        // Calculate model-view-projection matrix (MVP)
-        Matrix matModelViewProjection = MatrixIdentity();
-        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
-        else
-        {
-            // Setup current eye viewport (half screen width)
-            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
-            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
-        }
+        h = (h ^ data[i])*1099511628211ULL;
+    }
 
-        // Send combined model-view-projection matrix to shader
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+    rlgUnmapFile(data, size);
 
-        // Draw mesh
-        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
-        else rlDrawVertexArray(0, mesh.vertexCount);
+    *hash = h;
+    return true;
+}
+
+// Fill the key of a skybox bake with its bake parameters
+static bool rlgInitSkyboxBakeHeader(struct RLG_SkyboxBakeHeader *header, RLG_IrradianceMode irradianceMode, int irradianceSamples, const char *skyboxFileName)
+{
+    memcpy(header->magic, RLG_SKYBOX_BAKE_MAGIC, sizeof(header->magic));
+    header->version = RLG_SKYBOX_BAKE_VERSION;
+    header->irradianceMode = irradianceMode;
+    header->irradianceSamples = (irradianceMode == RLG_IRRADIANCE_SAMPLED_CUBEMAP) ? irradianceSamples : 0;
+    header->prefilterSamples = RLG_PREFILTER_SAMPLES;
+    header->prefilterMaxSize = RLG_PREFILTER_SIZE;
+    header->prefilterMipLevels = RLG_PREFILTER_MIP_LEVELS;
+
+    return (skyboxFileName == NULL) || rlgHashFile(skyboxFileName, &header->sourceHash);
+}
+
+// Size of the data of the first levels of a cubemap, 0 if the levels are not valid
+static size_t rlgGetCubemapLevelsSize(int size, int levels, int format)
+{
+    if ((size <= 0) || (levels <= 0) || (levels > 1 + (int)floorf(log2f((float)size)))) return 0;
+    if (!rlgIsPackedFormat(format) && ((format < PIXELFORMAT_UNCOMPRESSED_GRAYSCALE) || (format >= PIXELFORMAT_COMPRESSED_DXT1_RGB))) return 0;
+
+    size_t dataSize = 0;
+
+    for (int level = 0; level < levels; level++)
+    {
+        int levelSize = (size >> level);
+        dataSize += 6*rlgGetPixelDataSize(levelSize, levelSize, format);
     }
 
-    // Unbind all bound texture maps
-    for (int i = 0; i < 11; i++)
+    return dataSize;
+}
+
+#if !defined(GRAPHICS_API_OPENGL_ES2)
+// Read back the faces of the first levels of a cubemap into a bake file
+static bool rlgWriteCubemapLevels(FILE *file, TextureCubemap cubemap, int levels)
+{
+    int glInternalFormat, glFormat, glType;
+    rlgGetGlTextureFormats(cubemap.format, &glInternalFormat, &glFormat, &glType);
+
+    unsigned char *pixels = (unsigned char*)malloc(rlgGetPixelDataSize(cubemap.width, cubemap.width, cubemap.format));
+    if (pixels == NULL) return false;
+
+    bool success = true;
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id);
+
+    for (int level = 0; (level < levels) && success; level++)
     {
-        if (rlgCtx->material.data.useMaps[i])
-        {
-            // Select current shader texture slot
-            rlActiveTextureSlot(i);
+        int levelSize = (cubemap.width >> level);
+        size_t faceSize = rlgGetPixelDataSize(levelSize, levelSize, cubemap.format);
 
-            // Disable texture for active slot
-            if (i == MATERIAL_MAP_IRRADIANCE ||
-                i == MATERIAL_MAP_PREFILTER ||
-                i == MATERIAL_MAP_CUBEMAP)
-            {
-                rlDisableTextureCubemap();
-            }
-            else
-            {
-                rlDisableTexture();
-            }
+        for (int i = 0; (i < 6) && success; i++)
+        {
+            glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, glFormat, glType, pixels);
+            success = (fwrite(pixels, 1, faceSize, file) == faceSize);
         }
     }
 
-    // Unbind depth textures
-    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    free(pixels);
+
+    return success;
+}
+#endif
+
+// Upload the levels of a cubemap as stored in a bake file, advancing the data pointer past them
+static TextureCubemap rlgLoadCubemapLevels(const unsigned char **data, int size, int levels, int format)
+{
+    TextureCubemap cubemap = { 0 };
+
+    int glInternalFormat, glFormat, glType;
+    rlgGetGlTextureFormats(format, &glInternalFormat, &glFormat, &glType);
+
+    // The first level also gets the parameters and the swizzle of raylib cubemaps
+    cubemap.id = rlgLoadCubemap(*data, size, format);
+    *data += 6*rlgGetPixelDataSize(size, size, format);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id);
+
+    for (int level = 1; level < levels; level++)
     {
-        const struct RLG_Light *l = &rlgCtx->lights[i];
+        int levelSize = (size >> level);
+        size_t faceSize = rlgGetPixelDataSize(levelSize, levelSize, format);
 
-        if (l->data.enabled && l->data.shadow)
+        for (int i = 0; i < 6; i++)
         {
-            rlActiveTextureSlot(11 + i);
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, glInternalFormat,
+                levelSize, levelSize, 0, glFormat, glType, *data);
 
-            if (l->data.type == RLG_OMNILIGHT)
-            {
-                rlDisableTextureCubemap();
-            }
-            else
-            {
-                rlDisableTexture();
-            }
+            *data += faceSize;
         }
     }
 
-    // Disable all possible vertex array objects (or VBOs)
-    rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
-    // Disable shader program
-    rlDisableShader();
+    cubemap.width = size;
+    cubemap.height = size;
+    cubemap.mipmaps = levels;
+    cubemap.format = format;
 
-    // Restore rlgl internal modelview and projection matrices
-    rlSetMatrixModelview(matView);
-    rlSetMatrixProjection(matProjection);
+    return cubemap;
 }
 
-void RLG_DrawModel(Model model, Vector3 position, float scale, Color tint)
+bool RLG_SaveSkyboxBake(RLG_Skybox skybox, const char *bakeFileName, const char *skyboxFileName)
 {
-    Vector3 vScale = { scale, scale, scale };
-    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+#   if defined(GRAPHICS_API_OPENGL_ES2)
+    TraceLog(LOG_WARNING, "Skybox bakes cannot be saved on OpenGL ES, the textures cannot be read back");
+    return false;
+#   else
+    if (skybox.bakeTile < skybox.bakeTileCount)
+    {
+        TraceLog(LOG_WARNING, "The irradiance of the skybox is still being baked, it cannot be saved to [%s]", bakeFileName);
+        return false;
+    }
 
-    RLG_DrawModelEx(model, position, rotationAxis, 0.0f, vScale, tint);
-}
+    if ((skybox.cubemap.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) && !rlgIsPackedFormat(skybox.cubemap.format))
+    {
+        TraceLog(LOG_WARNING, "Compressed skyboxes cannot be saved to [%s]", bakeFileName);
+        return false;
+    }
 
-void RLG_DrawModelEx(Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale, Color tint)
-{
-    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
-    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
-    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+    struct RLG_SkyboxBakeHeader header = { 0 };
+    if (!rlgInitSkyboxBakeHeader(&header, rlgCtx->irradianceMode, rlgCtx->irradianceSamples, skyboxFileName)) return false;
 
-    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-    model.transform = MatrixMultiply(model.transform, matTransform);
+    // The full mip chains are stored, they are complete textures once uploaded
+    header.format = skybox.cubemap.format;
+    header.isHDR = skybox.isHDR;
+    header.cubemapSize = skybox.cubemap.width;
+    header.cubemapLevels = 1 + (int)floorf(log2f((float)skybox.cubemap.width));
+    header.prefilterSize = skybox.prefilter.width;
+    header.prefilterLevels = 1 + (int)floorf(log2f((float)skybox.prefilter.width));
+    header.irradianceSize = (skybox.irradiance.id != 0) ? skybox.irradiance.width : 0;
+    memcpy(header.irradianceSH, skybox.irradianceSH, sizeof(header.irradianceSH));
 
-    for (int i = 0; i < model.meshCount; i++)
+    FILE *file = fopen(bakeFileName, "wb");
+
+    if (file == NULL)
     {
-        Color color = model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color;
+        TraceLog(LOG_WARNING, "Failed to open [%s] to save the skybox bake", bakeFileName);
+        return false;
+    }
 
-        Color colorTint = WHITE;
-        colorTint.r = (unsigned char)((color.r*tint.r)/255);
-        colorTint.g = (unsigned char)((color.g*tint.g)/255);
-        colorTint.b = (unsigned char)((color.b*tint.b)/255);
-        colorTint.a = (unsigned char)((color.a*tint.a)/255);
+    GLint packAlignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
-        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = colorTint;
-        RLG_DrawMesh(model.meshes[i], model.materials[model.meshMaterial[i]], model.transform);
-        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = color;
-    }
+    bool success = (fwrite(&header, sizeof(header), 1, file) == 1)
+        && rlgWriteCubemapLevels(file, skybox.cubemap, header.cubemapLevels)
+        && rlgWriteCubemapLevels(file, skybox.prefilter, header.prefilterLevels)
+        && ((header.irradianceSize == 0) || rlgWriteCubemapLevels(file, skybox.irradiance, 1));
+
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+
+    if (fclose(file) != 0) success = false;
+
+    if (success) TraceLog(LOG_INFO, "Skybox bake saved to [%s]", bakeFileName);
+    else TraceLog(LOG_WARNING, "Failed to write the skybox bake [%s]", bakeFileName);
+
+    return success;
+#   endif
 }
 
-RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName)
+RLG_Skybox RLG_LoadSkyboxBake(const char *bakeFileName, const char *skyboxFileName)
 {
-    // Define the positions of the vertices for a cube
-    static const float positions[] =
+    RLG_Skybox skybox = { 0 };
+
+    size_t fileSize = 0;
+    unsigned char *fileData = rlgMapFile(bakeFileName, &fileSize);
+
+    if (fileData == NULL)
     {
-        // Front face
-        -0.5f, -0.5f,  0.5f,    // Vertex 0
-         0.5f, -0.5f,  0.5f,    // Vertex 1
-         0.5f,  0.5f,  0.5f,    // Vertex 2
-        -0.5f,  0.5f,  0.5f,    // Vertex 3
+        TraceLog(LOG_INFO, "Skybox bake [%s] not found", bakeFileName);
+        return skybox;
+    }
 
-        // Back face
-        -0.5f, -0.5f, -0.5f,    // Vertex 4
-         0.5f, -0.5f, -0.5f,    // Vertex 5
-         0.5f,  0.5f, -0.5f,    // Vertex 6
-        -0.5f,  0.5f, -0.5f     // Vertex 7
-    };
+    struct RLG_SkyboxBakeHeader header = { 0 };
+    struct RLG_SkyboxBakeHeader expected = { 0 };
 
-    // Define the indices for drawing the cube faces
-    const unsigned short indices[] =
+    // Read by copy, the header of a file read into memory may not be aligned
+    if (fileSize >= sizeof(header)) memcpy(&header, fileData, sizeof(header));
+
+    // Without the source file the bake is trusted whatever it was made from
+    if (skyboxFileName == NULL) expected.sourceHash = header.sourceHash;
+
+    bool valid = (fileSize >= sizeof(header))
+        && rlgInitSkyboxBakeHeader(&expected, rlgCtx->irradianceMode, rlgCtx->irradianceSamples, skyboxFileName)
+        && (memcmp(&header, &expected, offsetof(struct RLG_SkyboxBakeHeader, format)) == 0);
+
+    if (valid)
     {
-        // Front face
-        0, 1, 2,
-        2, 3, 0,
+        size_t cubemapSize = rlgGetCubemapLevelsSize(header.cubemapSize, header.cubemapLevels, header.format);
+        size_t prefilterSize = rlgGetCubemapLevelsSize(header.prefilterSize, header.prefilterLevels, header.format);
+        size_t irradianceSize = (header.irradianceSize == 0) ? 0 : rlgGetCubemapLevelsSize(header.irradianceSize, 1, header.format);
 
-        // Right face
-        1, 5, 6,
-        6, 2, 1,
+        valid = (cubemapSize > 0) && (prefilterSize > 0) && ((header.irradianceSize == 0) || (irradianceSize > 0))
+            && (fileSize == sizeof(header) + cubemapSize + prefilterSize + irradianceSize);
+    }
 
-        // Back face
-        5, 4, 7,
-        7, 6, 5,
+    if (!valid)
+    {
+        TraceLog(LOG_INFO, "Skybox bake [%s] is outdated or invalid", bakeFileName);
+        rlgUnmapFile(fileData, fileSize);
+        return skybox;
+    }
 
-        // Left face
-        4, 0, 3,
-        3, 7, 4,
+    rlgLoadSkyboxGeometry(&skybox);
 
-        // Top face
-        3, 2, 6,
-        6, 7, 3,
+    GLint unpackAlignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        // Bottom face
-        4, 5, 1,
-        1, 0, 4
-    };
+    const unsigned char *data = fileData + sizeof(header);
 
-    RLG_Skybox skybox = { 0 };
+    skybox.cubemap = rlgLoadCubemapLevels(&data, header.cubemapSize, header.cubemapLevels, header.format);
+    skybox.prefilter = rlgLoadCubemapLevels(&data, header.prefilterSize, header.prefilterLevels, header.format);
+    skybox.prefilter.mipmaps = RLG_PREFILTER_MIP_LEVELS;
 
-    // Load vertex array object (VAO) and bind it
-    skybox.vaoID = rlLoadVertexArray();
-    rlEnableVertexArray(skybox.vaoID);
+    if (header.irradianceSize > 0)
     {
-        // Load vertex buffer object (VBO) for positions and bind it
-        skybox.vboPostionsID = rlLoadVertexBuffer(positions, sizeof(positions), false);
-        rlSetVertexAttribute(0, 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(0);
+        skybox.irradiance = rlgLoadCubemapLevels(&data, header.irradianceSize, 1, header.format);
+    }
 
-        // Load element buffer object (EBO) for indices and bind it
-        skybox.vboIndicesID = rlLoadVertexBufferElement(indices, sizeof(indices), false);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+    memcpy(skybox.irradianceSH, header.irradianceSH, sizeof(skybox.irradianceSH));
+    skybox.isHDR = header.isHDR;
+
+    rlgUnmapFile(fileData, fileSize);
+
+    TraceLog(LOG_INFO, "Skybox bake loaded from [%s]", bakeFileName);
+
+    return skybox;
+}
+
+// Cubemap and its mip chain in memory, as RGB floats, the six faces of each level being contiguous
+struct rlgCubemapCPU
+{
+    int size;
+    int levels;
+    float *data[16];
+};
+
+// Rows of cubemap texels rendered on the CPU by RLG_BakeSkyboxFile, one job per row of a face
+struct rlgBakeCPU
+{
+    const Image *panorama;                      ///< R32G32B32 equirectangular source
+    const struct rlgCubemapCPU *environment;    ///< Cubemap sampled by the convolutions
+    float *output;                              ///< Level being rendered
+    int size;
+    int sampleCount;
+    float roughness;
+};
+
+// Allocate a cubemap in memory, cleared to black
+static bool rlgLoadCubemapCPU(struct rlgCubemapCPU *cubemap, int size, int levels)
+{
+    memset(cubemap, 0, sizeof(*cubemap));
+    cubemap->size = size;
+    cubemap->levels = levels;
+
+    for (int level = 0; level < levels; level++)
+    {
+        int levelSize = (size >> level);
+        cubemap->data[level] = (float*)calloc(6*3*(size_t)levelSize*levelSize, sizeof(float));
+        if (cubemap->data[level] == NULL) return false;
     }
-    rlDisableVertexArray();
 
-    // Load the cubemap texture from the image file
-    Image img = LoadImage(skyboxFileName);
-    skybox.cubemap = LoadTextureCubemap(img, CUBEMAP_LAYOUT_AUTO_DETECT);
-    UnloadImage(img);
+    return true;
+}
 
-    // Generate Irradiance Cubemap
+static void rlgUnloadCubemapCPU(struct rlgCubemapCPU *cubemap)
+{
+    for (int level = 0; level < cubemap->levels; level++) free(cubemap->data[level]);
+}
+
+// Face hit by a direction and its texture coordinates, from 0 to 1
+static int rlgGetCubemapFaceCoords(Vector3 v, float *s, float *t)
+{
+    float ax = fabsf(v.x), ay = fabsf(v.y), az = fabsf(v.z);
+    float sc, tc, ma;
+    int face;
+
+    if ((ax >= ay) && (ax >= az)) { face = (v.x > 0.0f) ? 0 : 1; sc = (v.x > 0.0f) ? -v.z : v.z; tc = -v.y; ma = ax; }
+    else if (ay >= az)            { face = (v.y > 0.0f) ? 2 : 3; sc = v.x; tc = (v.y > 0.0f) ? v.z : -v.z; ma = ay; }
+    else                          { face = (v.z > 0.0f) ? 4 : 5; sc = (v.z > 0.0f) ? v.x : -v.x; tc = -v.y; ma = az; }
+
+    *s = 0.5f*(sc/ma + 1.0f);
+    *t = 0.5f*(tc/ma + 1.0f);
+
+    return face;
+}
+
+// Texel of a level of a cubemap in memory, the texels past the edges of a face
+// being read from the neighbouring face, as with seamless cubemap filtering
+static const float *rlgFetchCubemapTexelCPU(const struct rlgCubemapCPU *cubemap, int level, int face, int x, int y)
+{
+    int size = (cubemap->size >> level);
+
+    if ((x < 0) || (y < 0) || (x >= size) || (y >= size))
     {
-        int size = skybox.cubemap.width / 16;
-        size = (size < 8) ? 8 : size;
+        float s, t;
+        face = rlgGetCubemapFaceCoords(rlgGetCubemapFaceDirection(face, 2.0f*(x + 0.5f)/size - 1.0f, 2.0f*(y + 0.5f)/size - 1.0f), &s, &t);
 
-        // Create a renderbuffer for depth attachment
-        unsigned int rbo = rlLoadTextureDepth(size, size, true);
+        x = Clamp((int)(s*size), 0, size - 1);
+        y = Clamp((int)(t*size), 0, size - 1);
+    }
 
-        // Create a cubemap texture to hold the HDR data
-        skybox.irradiance.id = rlLoadTextureCubemap(NULL, size, skybox.cubemap.format);
-        rlCubemapParameters(skybox.irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
-        rlCubemapParameters(skybox.irradiance.id, GL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    return cubemap->data[level] + 3*(((size_t)face*size + y)*size + x);
+}
 
-        // Create and configure the framebuffer
-        unsigned int fbo = rlLoadFramebuffer(size, size);
-        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
-        rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+// Bilinear sample of a level of a cubemap in memory
+static Vector3 rlgSampleCubemapLevelCPU(const struct rlgCubemapCPU *cubemap, int face, float s, float t, int level)
+{
+    int size = (cubemap->size >> level);
 
-        // Validate the framebuffer configuration
-        if (rlFramebufferComplete(fbo))
-        {
-            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
-        }  
+    float x = s*size - 0.5f;
+    float y = t*size - 0.5f;
 
-        // Enable the shader for converting HDR equirectangular environment map to cubemap faces
-        rlEnableShader(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].id);
+    int x0 = (int)floorf(x), y0 = (int)floorf(y);
+    float fx = x - x0, fy = y - y0;
 
-        // Set the projection matrix for the shader
-        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
-        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+    const float *t00 = rlgFetchCubemapTexelCPU(cubemap, level, face, x0, y0);
+    const float *t10 = rlgFetchCubemapTexelCPU(cubemap, level, face, x0 + 1, y0);
+    const float *t01 = rlgFetchCubemapTexelCPU(cubemap, level, face, x0, y0 + 1);
+    const float *t11 = rlgFetchCubemapTexelCPU(cubemap, level, face, x0 + 1, y0 + 1);
 
-        // Define view matrices for each cubemap face
-        Matrix fboViews[6] = {
-            MatrixLookAt((Vector3){0}, (Vector3){  1.0f,  0.0f,  0.0f}, (Vector3) {0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){ -1.0f,  0.0f,  0.0f}, (Vector3) {0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  1.0f,  0.0f}, (Vector3) {0.0f,  0.0f,  1.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f, -1.0f,  0.0f}, (Vector3) {0.0f,  0.0f, -1.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f,  1.0f}, (Vector3) {0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f, -1.0f}, (Vector3) {0.0f, -1.0f,  0.0f})
-        };
+    Vector3 color;
+    color.x = Lerp(Lerp(t00[0], t10[0], fx), Lerp(t01[0], t11[0], fx), fy);
+    color.y = Lerp(Lerp(t00[1], t10[1], fx), Lerp(t01[1], t11[1], fx), fy);
+    color.z = Lerp(Lerp(t00[2], t10[2], fx), Lerp(t01[2], t11[2], fx), fy);
 
-        // Set the viewport to match the framebuffer dimensions
-        rlViewport(0, 0, size, size);
-        rlDisableBackfaceCulling();
+    return color;
+}
 
-        // Activate the panorama texture
-        rlActiveTextureSlot(0);
-        rlEnableTextureCubemap(skybox.cubemap.id);
+// Trilinear sample of a cubemap in memory, as textureLod does
+static Vector3 rlgSampleCubemapCPU(const struct rlgCubemapCPU *cubemap, Vector3 v, float lod)
+{
+    float s, t;
+    int face = rlgGetCubemapFaceCoords(v, &s, &t);
 
-        for (int i = 0; i < 6; i++)
-        {
-            // Set the view matrix for the current cubemap face
-            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
-            
-            // Attach the current cubemap face to the framebuffer
-            rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
-            rlEnableFramebuffer(fbo);
+    lod = Clamp(lod, 0.0f, (float)(cubemap->levels - 1));
+    int level = (int)lod;
+    float f = lod - level;
 
-            // Clear the framebuffer and draw the cube face
-            rlClearScreenBuffers();
-            rlLoadDrawCube();
-        }
+    Vector3 color = rlgSampleCubemapLevelCPU(cubemap, face, s, t, level);
+    if (f > 0.0f) color = Vector3Lerp(color, rlgSampleCubemapLevelCPU(cubemap, face, s, t, level + 1), f);
 
-        // Disable the shader and textures
-        rlDisableShader();
-        rlDisableTextureCubemap();
-        rlDisableFramebuffer();
+    return color;
+}
 
-        // Unload the framebuffer and its attachments
-        rlUnloadFramebuffer(fbo);
+// Van der Corput radical inverse in base 2, as computed by the sampling shaders
+static float rlgRadicalInverse(unsigned int i)
+{
+    i = (i << 16) | (i >> 16);
+    i = ((i & 0x55555555u) << 1) | ((i & 0xAAAAAAAAu) >> 1);
+    i = ((i & 0x33333333u) << 2) | ((i & 0xCCCCCCCCu) >> 2);
+    i = ((i & 0x0F0F0F0Fu) << 4) | ((i & 0xF0F0F0F0u) >> 4);
+    i = ((i & 0x00FF00FFu) << 8) | ((i & 0xFF00FF00u) >> 8);
 
-        // Reset the viewport to default dimensions
-        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-        rlEnableBackfaceCulling();
+    return (float)i*2.3283064365386963e-10f;
+}
 
-        // Set the cubemap properties
-        skybox.cubemap.width = size;
-        skybox.cubemap.height = size;
-        skybox.cubemap.mipmaps = 1;
-        skybox.cubemap.format = skybox.cubemap.format;
-    }
+// Tangent frame of the sampling shaders around a direction
+static void rlgGetSamplingFrame(Vector3 N, Vector3 *right, Vector3 *up)
+{
+    *up = (fabsf(N.y) < 0.999f) ? (Vector3) { 0.0f, 1.0f, 0.0f } : (Vector3) { 1.0f, 0.0f, 0.0f };
+    *right = Vector3Normalize(Vector3CrossProduct(*up, N));
+    *up = Vector3CrossProduct(N, *right);
+}
 
-    return skybox;
+static void rlgStoreBakeTexel(const struct rlgBakeCPU *bake, int job, int x, Vector3 color)
+{
+    float *texel = bake->output + 3*((size_t)job*bake->size + x);
+
+    texel[0] = color.x;
+    texel[1] = color.y;
+    texel[2] = color.z;
 }
 
-RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format)
+// Equirectangular projection read with nearest filtering, as rlgEquirectangularToCubemapFS
+static void rlgBakeEquirectangularRow(void *data, int job)
 {
-    // Define the positions of the vertices for a cube
-    static const float positions[] =
+    const struct rlgBakeCPU *bake = (const struct rlgBakeCPU*)data;
+    const Image *panorama = bake->panorama;
+    const float *pixels = (const float*)panorama->data;
+
+    for (int x = 0; x < bake->size; x++)
     {
-        // Front face
-        -0.5f, -0.5f,  0.5f,    // Vertex 0
-         0.5f, -0.5f,  0.5f,    // Vertex 1
-         0.5f,  0.5f,  0.5f,    // Vertex 2
-        -0.5f,  0.5f,  0.5f,    // Vertex 3
+        Vector3 v = rlgGetCubemapTexelDirection(job/bake->size, x, job%bake->size, bake->size);
 
-        // Back face
-        -0.5f, -0.5f, -0.5f,    // Vertex 4
-         0.5f, -0.5f, -0.5f,    // Vertex 5
-         0.5f,  0.5f, -0.5f,    // Vertex 6
-        -0.5f,  0.5f, -0.5f     // Vertex 7
-    };
+        float u = atan2f(v.z, v.x)*0.1591f + 0.5f;
+        float w = asinf(v.y)*-0.3183f + 0.5f;
 
-    // Define the indices for drawing the cube faces
-    const unsigned short indices[] =
-    {
-        // Front face
-        0, 1, 2,
-        2, 3, 0,
+        int px = (int)floorf(u*panorama->width)%panorama->width;
+        int py = (int)floorf(w*panorama->height)%panorama->height;
+        if (px < 0) px += panorama->width;
+        if (py < 0) py += panorama->height;
 
-        // Right face
-        1, 5, 6,
-        6, 2, 1,
+        const float *p = pixels + 3*((size_t)py*panorama->width + px);
+        rlgStoreBakeTexel(bake, job, x, (Vector3) { p[0], p[1], p[2] });
+    }
+}
 
-        // Back face
-        5, 4, 7,
-        7, 6, 5,
+// Hemisphere integration over a regular grid, as rlgIrradianceConvolutionFS
+static void rlgBakeIrradianceConvolutionRow(void *data, int job)
+{
+    const struct rlgBakeCPU *bake = (const struct rlgBakeCPU*)data;
 
-        // Left face
-        4, 0, 3,
-        3, 7, 4,
+    // The shader reads the mip level selected by the derivatives of the sample directions
+    float lod = log2f((float)bake->environment->size/bake->size);
 
-        // Top face
-        3, 2, 6,
-        6, 7, 3,
+    for (int x = 0; x < bake->size; x++)
+    {
+        Vector3 N = rlgGetCubemapTexelDirection(job/bake->size, x, job%bake->size, bake->size);
+        Vector3 right = Vector3Normalize(Vector3CrossProduct((Vector3) { 0.0f, 1.0f, 0.0f }, N));
+        Vector3 up = Vector3Normalize(Vector3CrossProduct(N, right));
 
-        // Bottom face
-        4, 5, 1,
-        1, 0, 4
-    };
+        Vector3 irradiance = { 0 };
+        float sampleCount = 0.0f;
 
-    RLG_Skybox skybox = { 0 };
+        for (float phi = 0.0f; phi < 2.0f*PI; phi += 0.025f)
+        {
+            for (float theta = 0.0f; theta < 0.5f*PI; theta += 0.025f)
+            {
+                float sinTheta = sinf(theta), cosTheta = cosf(theta);
+
+                Vector3 L = Vector3Add(Vector3Scale(right, sinTheta*cosf(phi)),
+                    Vector3Add(Vector3Scale(up, sinTheta*sinf(phi)), Vector3Scale(N, cosTheta)));
 
-    // Generate a vertex array object (VAO) for the skybox
-    skybox.vaoID = rlLoadVertexArray();
-    rlEnableVertexArray(skybox.vaoID);
-    {
-        // Load the vertex positions into a vertex buffer object (VBO)
-        skybox.vboPostionsID = rlLoadVertexBuffer(positions, sizeof(positions), false);
-        rlSetVertexAttribute(0, 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(0);
+                irradiance = Vector3Add(irradiance, Vector3Scale(rlgSampleCubemapCPU(bake->environment, L, lod), cosTheta*sinTheta));
+                sampleCount++;
+            }
+        }
 
-        // Load the indices into an element buffer object (EBO)
-        skybox.vboIndicesID = rlLoadVertexBufferElement(indices, sizeof(indices), false);
+        rlgStoreBakeTexel(bake, job, x, Vector3Scale(irradiance, PI/sampleCount));
     }
-    rlDisableVertexArray();
+}
+
+// Cosine-weighted importance sampling, as rlgIrradianceSamplingFS
+static void rlgBakeIrradianceSamplingRow(void *data, int job)
+{
+    const struct rlgBakeCPU *bake = (const struct rlgBakeCPU*)data;
 
-    // Create a framebuffer object (FBO) to generate the skybox and irradiance map
-    unsigned int fbo = rlLoadFramebuffer(0, 0);
+    float n = (float)bake->sampleCount;
+    float environmentSize = (float)bake->environment->size;
+    float texelSolidAngle = 4.0f*PI/(6.0f*environmentSize*environmentSize);
 
-    // Generate the cubemap for the skybox
+    for (int x = 0; x < bake->size; x++)
     {
-        // Load the HDR panorama texture
-        Texture2D panorama = LoadTexture(skyboxFileName);
+        Vector3 N = rlgGetCubemapTexelDirection(job/bake->size, x, job%bake->size, bake->size);
+        Vector3 right, up;
+        rlgGetSamplingFrame(N, &right, &up);
 
-        // Create a renderbuffer for depth attachment
-        unsigned int rbo = rlLoadTextureDepth(size, size, true);
+        Vector3 irradiance = { 0 };
 
-        // Create a cubemap texture to hold the HDR data
-        skybox.cubemap.id = rlLoadTextureCubemap(NULL, size, format);
+        for (int i = 0; i < bake->sampleCount; i++)
+        {
+            float phi = 2.0f*PI*i/n;
+            float u = rlgRadicalInverse(i);
+            float cosTheta = sqrtf(1.0f - u);
+            float sinTheta = sqrtf(u);
 
-        // Configure the framebuffer with the renderbuffer and cubemap texture
-        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
-        rlFramebufferAttach(fbo, skybox.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+            Vector3 L = Vector3Add(Vector3Scale(Vector3Add(Vector3Scale(right, cosf(phi)), Vector3Scale(up, sinf(phi))), sinTheta),
+                Vector3Scale(N, cosTheta));
 
-        // Validate the framebuffer configuration
-        if (rlFramebufferComplete(fbo))
-        {
-            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
+            float pdf = fmaxf(cosTheta, 1e-4f)/PI;
+            float lod = 0.5f*log2f(1.0f/(n*pdf*texelSolidAngle));
+
+            irradiance = Vector3Add(irradiance, rlgSampleCubemapCPU(bake->environment, L, fmaxf(lod, 0.0f)));
         }
 
-        // Enable the shader to convert the HDR equirectangular map to cubemap faces
-        rlEnableShader(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].id);
+        rlgStoreBakeTexel(bake, job, x, Vector3Scale(irradiance, 1.0f/n));
+    }
+}
 
-        // Set the projection matrix for the shader
-        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
-        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+// GGX importance sampling, as rlgPrefilterFS
+static void rlgBakePrefilterRow(void *data, int job)
+{
+    const struct rlgBakeCPU *bake = (const struct rlgBakeCPU*)data;
 
-        // Define view matrices for each cubemap face
-        Matrix fboViews[6] = {
-            MatrixLookAt((Vector3){0}, (Vector3) { 1.0f,  0.0f,  0.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3) {-1.0f,  0.0f,  0.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3) { 0.0f,  1.0f,  0.0f}, (Vector3){ 0.0f,  0.0f,  1.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3) { 0.0f, -1.0f,  0.0f}, (Vector3){ 0.0f,  0.0f, -1.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3) { 0.0f,  0.0f,  1.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3) { 0.0f,  0.0f, -1.0f}, (Vector3){ 0.0f, -1.0f,  0.0f})
-        };
+    float alpha = bake->roughness*bake->roughness;
+    float a2 = alpha*alpha;
 
-        // Set the viewport to match the framebuffer dimensions
-        rlViewport(0, 0, size, size);
-        rlDisableBackfaceCulling();
+    float n = (float)bake->sampleCount;
+    float environmentSize = (float)bake->environment->size;
+    float texelSolidAngle = 4.0f*PI/(6.0f*environmentSize*environmentSize);
 
-        // Activate the panorama texture
-        rlActiveTextureSlot(0);
-        rlEnableTexture(panorama.id);
+    for (int x = 0; x < bake->size; x++)
+    {
+        Vector3 N = rlgGetCubemapTexelDirection(job/bake->size, x, job%bake->size, bake->size);
+        Vector3 right, up;
+        rlgGetSamplingFrame(N, &right, &up);
 
-        for (int i = 0; i < 6; i++)
+        Vector3 color = { 0 };
+        float weight = 0.0f;
+
+        for (int i = 0; i < bake->sampleCount; i++)
         {
-            // Set the view matrix for the current cubemap face
-            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
-            
-            // Attach the current cubemap face to the framebuffer
-            rlFramebufferAttach(fbo, skybox.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
-            rlEnableFramebuffer(fbo);
+            float phi = 2.0f*PI*i/n;
+            float u = rlgRadicalInverse(i);
+            float cosTheta = sqrtf((1.0f - u)/(1.0f + (a2 - 1.0f)*u));
+            float sinTheta = sqrtf(1.0f - cosTheta*cosTheta);
 
-            // Clear the framebuffer and draw the cube
-            rlClearScreenBuffers();
-            rlLoadDrawCube();
+            Vector3 H = Vector3Add(Vector3Scale(Vector3Add(Vector3Scale(right, cosf(phi)), Vector3Scale(up, sinf(phi))), sinTheta),
+                Vector3Scale(N, cosTheta));
+            Vector3 L = Vector3Subtract(Vector3Scale(H, 2.0f*Vector3DotProduct(N, H)), N);
+
+            float NdotL = Vector3DotProduct(N, L);
+            if (NdotL > 0.0f)
+            {
+                float d = cosTheta*cosTheta*(a2 - 1.0f) + 1.0f;
+                float pdf = a2/(PI*d*d)*0.25f + 1e-4f;
+                float lod = (bake->roughness > 0.0f) ? 0.5f*log2f(1.0f/(n*pdf*texelSolidAngle)) : 0.0f;
+
+                color = Vector3Add(color, Vector3Scale(rlgSampleCubemapCPU(bake->environment, L, fmaxf(lod, 0.0f)), NdotL));
+                weight += NdotL;
+            }
         }
 
-        // Disable the shader and textures
-        rlDisableShader();
-        rlDisableTexture();
-        rlDisableFramebuffer();
+        rlgStoreBakeTexel(bake, job, x, Vector3Scale(color, 1.0f/fmaxf(weight, 1e-4f)));
+    }
+}
 
-        // Reset the viewport to default dimensions
-        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-        rlEnableBackfaceCulling();
+// Mip chain filtered like glGenerateMipmap, by a bilinear sample of the parent at the center of
+// each texel: a 2x2 box when the parent is twice the size, and still aligned when it is odd
+static void rlgGenCubemapMipmapsCPU(struct rlgCubemapCPU *cubemap)
+{
+    for (int level = 1; level < cubemap->levels; level++)
+    {
+        int size = (cubemap->size >> level);
+        int parentSize = (cubemap->size >> (level - 1));
+        float scale = (float)parentSize/size;
 
-        // Set the cubemap properties
-        skybox.cubemap.width = size;
-        skybox.cubemap.height = size;
-        skybox.cubemap.mipmaps = 1;
-        skybox.cubemap.format = format;
+        for (int face = 0; face < 6; face++)
+        {
+            const float *parent = cubemap->data[level - 1] + 3*(size_t)face*parentSize*parentSize;
+            float *texels = cubemap->data[level] + 3*(size_t)face*size*size;
+
+            for (int y = 0; y < size; y++)
+            {
+                float sy = (y + 0.5f)*scale - 0.5f;
+                int y0 = (int)floorf(sy);
+                int y1 = (y0 + 1 < parentSize) ? y0 + 1 : y0;
+                float fy = sy - y0;
 
-        // Unload the panorama texture as it's no longer needed
-        UnloadTexture(panorama);
+                for (int x = 0; x < size; x++)
+                {
+                    float sx = (x + 0.5f)*scale - 0.5f;
+                    int x0 = (int)floorf(sx);
+                    int x1 = (x0 + 1 < parentSize) ? x0 + 1 : x0;
+                    float fx = sx - x0;
+
+                    for (int c = 0; c < 3; c++)
+                    {
+                        float top = Lerp(parent[3*(y0*parentSize + x0) + c], parent[3*(y0*parentSize + x1) + c], fx);
+                        float bottom = Lerp(parent[3*(y1*parentSize + x0) + c], parent[3*(y1*parentSize + x1) + c], fx);
+                        texels[3*(y*size + x) + c] = Lerp(top, bottom, fy);
+                    }
+                }
+            }
+        }
     }
+}
 
-    // Generate the irradiance cubemap
+static bool rlgWriteCubemapCPU(FILE *file, const struct rlgCubemapCPU *cubemap)
+{
+    for (int level = 0; level < cubemap->levels; level++)
     {
-        int irrSize = skybox.cubemap.width / 16;
-        irrSize = (irrSize < 8) ? 8 : irrSize;
+        int levelSize = (cubemap->size >> level);
+        size_t count = 6*3*(size_t)levelSize*levelSize;
 
-        // Create a renderbuffer for depth attachment
-        unsigned int rbo = rlLoadTextureDepth(irrSize, irrSize, true);
+        if (fwrite(cubemap->data[level], sizeof(float), count, file) != count) return false;
+    }
 
-        // Create a cubemap texture to hold the irradiance data
-        skybox.irradiance.id = rlLoadTextureCubemap(NULL, irrSize, skybox.cubemap.format);
-        rlCubemapParameters(skybox.irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
-        rlCubemapParameters(skybox.irradiance.id, GL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    return true;
+}
 
-        // Create and configure the framebuffer
-        unsigned int fbo = rlLoadFramebuffer(irrSize, irrSize);
-        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
-        rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+bool RLG_BakeSkyboxFile(const char *skyboxFileName, const char *bakeFileName, int size, RLG_IrradianceMode irradianceMode, int irradianceSamples)
+{
+    if (irradianceSamples < 1) irradianceSamples = 1;
+    if (irradianceSamples > RLG_IRRADIANCE_MAX_SAMPLES) irradianceSamples = RLG_IRRADIANCE_MAX_SAMPLES;
 
-        // Validate the framebuffer configuration
-        if (rlFramebufferComplete(fbo))
-        {
-            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
-        }
+    struct RLG_SkyboxBakeHeader header = { 0 };
+    if (!rlgInitSkyboxBakeHeader(&header, irradianceMode, irradianceSamples, skyboxFileName)) return false;
 
-        // Enable the shader for irradiance convolution
-        rlEnableShader(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].id);
+    Image panorama = RLG_LoadImageHDR(skyboxFileName);
+    if (panorama.data == NULL) return false;
+    ImageFormat(&panorama, PIXELFORMAT_UNCOMPRESSED_R32G32B32);
 
-        // Set the projection matrix for the shader
-        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
-        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+    int prefilterSize = (size < RLG_PREFILTER_SIZE) ? size : RLG_PREFILTER_SIZE;
+    int irradianceSize = (size/16 < 8) ? 8 : size/16;
 
-        // Define view matrices for each cubemap face
-        Matrix fboViews[6] = {
-            MatrixLookAt((Vector3){0}, (Vector3){  1.0f,  0.0f,  0.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){ -1.0f,  0.0f,  0.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  1.0f,  0.0f}, (Vector3){ 0.0f,  0.0f,  1.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f, -1.0f,  0.0f}, (Vector3){ 0.0f,  0.0f, -1.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f,  1.0f}, (Vector3){ 0.0f, -1.0f,  0.0f}),
-            MatrixLookAt((Vector3){0}, (Vector3){  0.0f,  0.0f, -1.0f}, (Vector3){ 0.0f, -1.0f,  0.0f})
-        };
+    header.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32;
+    header.isHDR = true;
+    header.cubemapSize = size;
+    header.cubemapLevels = 1 + (int)floorf(log2f((float)size));
+    header.prefilterSize = prefilterSize;
+    header.prefilterLevels = 1 + (int)floorf(log2f((float)prefilterSize));
+    header.irradianceSize = (irradianceMode == RLG_IRRADIANCE_SH9) ? 0 : irradianceSize;
 
-        // Set the viewport to match the framebuffer dimensions
-        rlViewport(0, 0, irrSize, irrSize);
-        rlDisableBackfaceCulling();
+    struct rlgCubemapCPU cubemap = { 0 }, prefilter = { 0 }, irradiance = { 0 };
 
-        // Activate the cubemap texture
-        rlActiveTextureSlot(0);
-        rlEnableTextureCubemap(skybox.cubemap.id);
+    bool success = rlgLoadCubemapCPU(&cubemap, size, header.cubemapLevels)
+        && rlgLoadCubemapCPU(&prefilter, prefilterSize, header.prefilterLevels)
+        && ((header.irradianceSize == 0) || rlgLoadCubemapCPU(&irradiance, irradianceSize, 1));
 
-        for (int i = 0; i < 6; i++)
+    if (success)
+    {
+        // Environment cubemap and the mipmaps read by the convolutions
+        struct rlgBakeCPU bake = { &panorama, &cubemap, cubemap.data[0], size, 0, 0.0f };
+        rlgParallelFor(6*size, rlgBakeEquirectangularRow, &bake);
+        rlgGenCubemapMipmapsCPU(&cubemap);
+
+        if (irradianceMode == RLG_IRRADIANCE_SH9)
         {
-            // Set the view matrix for the current cubemap face
-            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
-            
-            // Attach the current cubemap face to the framebuffer
-            rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
-            rlEnableFramebuffer(fbo);
+            rlgProjectImageSH(panorama, (Vector3*)header.irradianceSH);
+        }
+        else
+        {
+            bake.output = irradiance.data[0];
+            bake.size = irradianceSize;
+            bake.sampleCount = irradianceSamples;
 
-            // Clear the framebuffer and draw the cube
-            rlClearScreenBuffers();
-            rlLoadDrawCube();
+            rlgParallelFor(6*irradianceSize, (irradianceMode == RLG_IRRADIANCE_SAMPLED_CUBEMAP)
+                ? rlgBakeIrradianceSamplingRow : rlgBakeIrradianceConvolutionRow, &bake);
         }
 
-        // Disable the shader and textures
-        rlDisableShader();
-        rlDisableTextureCubemap();
-        rlDisableFramebuffer();
+        // The levels past the last roughness step are left black, as by the GPU loaders
+        for (int mip = 0; (mip < RLG_PREFILTER_MIP_LEVELS) && (mip < prefilter.levels); mip++)
+        {
+            bake.output = prefilter.data[mip];
+            bake.size = (prefilterSize >> mip);
+            bake.sampleCount = (mip == 0) ? 1 : RLG_PREFILTER_SAMPLES;
+            bake.roughness = (float)mip/(RLG_PREFILTER_MIP_LEVELS - 1);
 
-        // Reset the viewport to default dimensions
-        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-        rlEnableBackfaceCulling();
+            rlgParallelFor(6*bake.size, rlgBakePrefilterRow, &bake);
+        }
+
+        FILE *file = fopen(bakeFileName, "wb");
+        success = (file != NULL)
+            && (fwrite(&header, sizeof(header), 1, file) == 1)
+            && rlgWriteCubemapCPU(file, &cubemap)
+            && rlgWriteCubemapCPU(file, &prefilter)
+            && ((header.irradianceSize == 0) || rlgWriteCubemapCPU(file, &irradiance));
 
-        // Set the cubemap properties
-        skybox.cubemap.width = irrSize;
-        skybox.cubemap.height = irrSize;
-        skybox.cubemap.mipmaps = 1;
-        skybox.cubemap.format = skybox.cubemap.format;
+        if ((file != NULL) && (fclose(file) != 0)) success = false;
     }
 
-    // Unload the framebuffer
-    rlUnloadFramebuffer(fbo);
+    rlgUnloadCubemapCPU(&cubemap);
+    rlgUnloadCubemapCPU(&prefilter);
+    rlgUnloadCubemapCPU(&irradiance);
+    UnloadImage(panorama);
 
-    // Indicate that the texture used is HDR
-    skybox.isHDR = true;
+    if (success) TraceLog(LOG_INFO, "Skybox bake of [%s] saved to [%s]", skyboxFileName, bakeFileName);
+    else TraceLog(LOG_WARNING, "Failed to bake the skybox [%s] to [%s]", skyboxFileName, bakeFileName);
 
-    return skybox;
+    return success;
 }
 
 void RLG_UnloadSkybox(RLG_Skybox skybox)
 {
     UnloadTexture(skybox.cubemap);
     UnloadTexture(skybox.irradiance);
+    UnloadTexture(skybox.prefilter);
 
-    rlUnloadVertexArray(skybox.vaoID);
-    rlUnloadVertexBuffer(skybox.vboIndicesID);
-    rlUnloadVertexBuffer(skybox.vboPostionsID);
+    // NOTE: The cube is shared by the skyboxes, it is unloaded with the context
 }
 
 void RLG_DrawSkybox(RLG_Skybox skybox)
@@ -2303,7 +7864,8 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
 
     if (rlgCtx->skybox.previousCubemapID != skybox.cubemap.id)
     {
-        int isHDR = (int)skybox.isHDR;
+        // The captures of the reflection probes keep the linear radiance of the HDR skyboxes
+        int isHDR = (int)(skybox.isHDR && !rlgCtx->reflectionProbes.capturing);
         rlSetUniform(rlgCtx->skybox.locDoGamma, &isHDR, SHADER_UNIFORM_INT, 1);
         rlgCtx->skybox.previousCubemapID = skybox.cubemap.id;
     }
@@ -2311,6 +7873,11 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
     rlDisableBackfaceCulling();
     rlDisableDepthMask();
 
+    // The cube is projected on the far plane, where the depth cleared to 1.0 must pass
+    GLint depthFunc = GL_LEQUAL;
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    glDepthFunc(GL_LEQUAL);
+
     // Get current view/projection matrices
     Matrix matView = rlGetMatrixModelview();
     Matrix matProjection = rlGetMatrixProjection();
@@ -2391,6 +7958,314 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
     rlSetMatrixModelview(matView);
     rlSetMatrixProjection(matProjection);
 
+    glDepthFunc(depthFunc);
     rlEnableBackfaceCulling();
     rlEnableDepthMask();
 }
+
+// Number of steps of a refresh of a reflection probe, six faces captured then six faces prefiltered
+#define RLG_PROBE_STEPS 12
+
+static struct RLG_ReflectionProbe *rlgFindReflectionProbe(unsigned int probe, const char *caller)
+{
+    if (probe == 0 || probe > rlgCtx->reflectionProbes.capacity || !rlgCtx->reflectionProbes.probes[probe - 1].used)
+    {
+        TraceLog(LOG_ERROR, "Reflection probe [ID %i] specified to '%s' is not valid", probe, caller);
+        return NULL;
+    }
+
+    return &rlgCtx->reflectionProbes.probes[probe - 1];
+}
+
+unsigned int RLG_CreateReflectionProbe(Vector3 position, BoundingBox box, int resolution)
+{
+    if (resolution < 1)
+    {
+        TraceLog(LOG_ERROR, "Invalid resolution [%i] specified to 'RLG_CreateReflectionProbe'", resolution);
+        return 0;
+    }
+
+    // Look for a free slot in the probe array
+    unsigned int index = 0;
+    while (index < rlgCtx->reflectionProbes.capacity && rlgCtx->reflectionProbes.probes[index].used) index++;
+
+    // Grow the probe array if it is full
+    if (index == rlgCtx->reflectionProbes.capacity)
+    {
+        unsigned int capacity = (rlgCtx->reflectionProbes.capacity == 0) ? 4 : 2*rlgCtx->reflectionProbes.capacity;
+        struct RLG_ReflectionProbe *probes = (struct RLG_ReflectionProbe*)realloc(
+            rlgCtx->reflectionProbes.probes, capacity*sizeof(struct RLG_ReflectionProbe));
+
+        if (!probes)
+        {
+            TraceLog(LOG_ERROR, "Heap allocation for reflection probes failed!");
+            return 0;
+        }
+
+        memset(probes + rlgCtx->reflectionProbes.capacity, 0,
+            (capacity - rlgCtx->reflectionProbes.capacity)*sizeof(struct RLG_ReflectionProbe));
+
+        rlgCtx->reflectionProbes.probes = probes;
+        rlgCtx->reflectionProbes.capacity = capacity;
+    }
+
+    // Float faces like the HDR skyboxes, the lighting is not clamped
+#   if defined(GRAPHICS_API_OPENGL_ES2)
+    int format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+#   else
+    int format = PIXELFORMAT_UNCOMPRESSED_R32G32B32;
+#   endif
+
+    rlDrawRenderBatchActive();
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    struct RLG_ReflectionProbe probe = { 0 };
+
+    probe.capture.cubemap.id = rlgLoadCubemap(NULL, resolution, format);
+    probe.capture.cubemap.width = resolution;
+    probe.capture.cubemap.height = resolution;
+    probe.capture.cubemap.mipmaps = 1;
+    probe.capture.cubemap.format = format;
+    probe.capture.isHDR = true;
+
+    // The first prefiltered cubemap becomes the sampled one, the second is rendered to
+    rlgLoadPrefilterCubemap(&probe.capture);
+    probe.prefilter = probe.capture.prefilter;
+    rlgLoadPrefilterCubemap(&probe.capture);
+
+    // NOTE: The depth renderbuffer is deleted along with the framebuffer
+    unsigned int depthId = rlLoadTextureDepth(resolution, resolution, true);
+    probe.framebufferId = rlLoadFramebuffer(resolution, resolution);
+    rlFramebufferAttach(probe.framebufferId, depthId, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+    rlFramebufferAttach(probe.framebufferId, probe.capture.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+
+    bool complete = rlFramebufferComplete(probe.framebufferId);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+
+    if (!complete)
+    {
+        TraceLog(LOG_ERROR, "The capture target of a reflection probe could not be created");
+
+        RLG_UnloadSkybox(probe.capture);
+        rlUnloadTexture(probe.prefilter.id);
+        rlUnloadFramebuffer(probe.framebufferId);
+
+        return 0;
+    }
+
+    probe.position = position;
+    probe.box = box;
+    probe.isStatic = true;
+    probe.used = true;
+
+    rlgCtx->reflectionProbes.probes[index] = probe;
+
+    return index + 1;
+}
+
+void RLG_DestroyReflectionProbe(unsigned int probe)
+{
+    struct RLG_ReflectionProbe *p = rlgFindReflectionProbe(probe, "RLG_DestroyReflectionProbe");
+    if (p == NULL) return;
+
+    RLG_UnloadSkybox(p->capture);
+    rlUnloadTexture(p->prefilter.id);
+    rlUnloadFramebuffer(p->framebufferId);
+
+    *p = (struct RLG_ReflectionProbe){ 0 };
+}
+
+void RLG_SetReflectionProbeStatic(unsigned int probe, bool isStatic)
+{
+    struct RLG_ReflectionProbe *p = rlgFindReflectionProbe(probe, "RLG_SetReflectionProbeStatic");
+    if (p != NULL) p->isStatic = isStatic;
+}
+
+void RLG_RefreshReflectionProbe(unsigned int probe)
+{
+    struct RLG_ReflectionProbe *p = rlgFindReflectionProbe(probe, "RLG_RefreshReflectionProbe");
+    if (p != NULL) p->upToDate = false;
+}
+
+TextureCubemap RLG_GetReflectionProbe(unsigned int probe)
+{
+    struct RLG_ReflectionProbe *p = rlgFindReflectionProbe(probe, "RLG_GetReflectionProbe");
+    if (p == NULL || !p->complete) return (TextureCubemap) { 0 };
+
+    return p->prefilter;
+}
+
+// Point the lighting shader of the captures at the shadow maps instead of the screen-space shadow mask, or back
+static void rlgSuspendShadowMask(bool suspend)
+{
+    const struct RLG_ShadowMask *sm = &rlgCtx->shadowMask;
+    if (!sm->active) return;
+
+    Shader lightShader = rlgCtx->shaders[RLG_SHADER_LIGHTING];
+
+    for (unsigned int i = 0; i < rlgCtx->lightCount; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+
+        if (l->data.shadowMaskChannel >= 0)
+        {
+            int channel = suspend ? -1 : l->data.shadowMaskChannel;
+            SetShaderValue(lightShader, l->locs.shadowMaskChannel, &channel, SHADER_UNIFORM_INT);
+        }
+    }
+
+    int useShadowMask = !suspend && (sm->lights[0] >= 0);
+    SetShaderValue(lightShader, sm->locLightingUse, &useShadowMask, SHADER_UNIFORM_INT);
+}
+
+// Render a face of the capture of a probe, seen from its position
+static void rlgCaptureProbeFace(struct RLG_ReflectionProbe *probe, RLG_DrawFunc drawFunc, int face)
+{
+    int size = probe->capture.cubemap.width;
+
+    rlFramebufferAttach(probe->framebufferId, probe->capture.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + face, 0);
+    rlEnableFramebuffer(probe->framebufferId);
+    rlViewport(0, 0, size, size);
+
+    rlClearColor(0, 0, 0, 255);
+    rlClearScreenBuffers();
+
+    rlEnableDepthTest();
+    rlEnableBackfaceCulling();
+
+    Vector3 p = probe->position;
+    rlSetMatrixProjection(MatrixPerspective(90.0*DEG2RAD, 1.0, rlgCtx->zNear, rlgCtx->zFar));
+    rlSetMatrixModelview(MatrixMultiply(MatrixTranslate(-p.x, -p.y, -p.z), rlgGetCubemapFaceView(face)));
+
+    drawFunc(rlgCtx->shaders[RLG_SHADER_LIGHTING]);
+    rlDrawRenderBatchActive();
+}
+
+// Run the next step of the refresh of a probe
+static void rlgStepReflectionProbe(struct RLG_ReflectionProbe *probe, RLG_DrawFunc drawFunc)
+{
+    if (probe->step < 6)
+    {
+        rlgCaptureProbeFace(probe, drawFunc, probe->step);
+    }
+    else
+    {
+        // The mipmaps of the capture are read by the importance sampling of the prefilter
+        if (probe->step == 6) rlgGenEnvironmentMipmaps(&probe->capture);
+
+        for (int mip = 0; mip < RLG_PREFILTER_MIP_LEVELS; mip++)
+        {
+            rlgRenderPrefilterFace(&probe->capture, mip, probe->step - 6);
+        }
+    }
+
+    if (++probe->step == RLG_PROBE_STEPS)
+    {
+        // The refresh becomes visible at once, the previous one being rendered over by the next
+        TextureCubemap prefilter = probe->prefilter;
+        probe->prefilter = probe->capture.prefilter;
+        probe->capture.prefilter = prefilter;
+
+        probe->step = 0;
+        probe->upToDate = true;
+        probe->complete = true;
+    }
+}
+
+// Find the next probe with steps to run from the round-robin position, the incomplete ones first
+static struct RLG_ReflectionProbe *rlgGetNextReflectionProbe(void)
+{
+    unsigned int capacity = rlgCtx->reflectionProbes.capacity;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (unsigned int n = 0; n < capacity; n++)
+        {
+            struct RLG_ReflectionProbe *probe = &rlgCtx->reflectionProbes.probes[(rlgCtx->reflectionProbes.next + n)%capacity];
+            if (!probe->used || (probe->isStatic && probe->upToDate)) continue;
+
+            if ((pass == 1) || !probe->complete) return probe;
+        }
+    }
+
+    return NULL;
+}
+
+void RLG_UpdateReflectionProbes(RLG_DrawFunc drawFunc, int budget)
+{
+    // Every probe with steps to run is refreshed once
+    if (budget <= 0)
+    {
+        budget = 0;
+
+        for (unsigned int i = 0; i < rlgCtx->reflectionProbes.capacity; i++)
+        {
+            const struct RLG_ReflectionProbe *probe = &rlgCtx->reflectionProbes.probes[i];
+            if (probe->used && !(probe->isStatic && probe->upToDate)) budget += RLG_PROBE_STEPS - probe->step;
+        }
+    }
+
+    if (budget == 0 || drawFunc == NULL) return;
+
+    // The captures can happen between the draws of a frame, the state changed here is restored afterwards
+    rlDrawRenderBatchActive();
+
+    GLint previousFramebuffer = 0, viewport[4] = { 0 };
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    GLfloat clearColor[4] = { 0 };
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+    bool cullFace = glIsEnabled(GL_CULL_FACE);
+
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matProjection = rlGetMatrixProjection();
+
+    rlgCtx->reflectionProbes.capturing = true;
+    rlgCtx->skybox.previousCubemapID = 0;
+    rlgSuspendShadowMask(true);
+
+    for (int i = 0; i < budget; i++)
+    {
+        struct RLG_ReflectionProbe *probe = rlgGetNextReflectionProbe();
+        if (probe == NULL) break;
+
+        // The specular lighting of the capture is seen from the probe
+        if (probe->step < 6)
+        {
+            SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING],
+                rlgCtx->shaders[RLG_SHADER_LIGHTING].locs[RLG_LOC_VECTOR_VIEW], &probe->position, SHADER_UNIFORM_VEC3);
+        }
+
+        rlgStepReflectionProbe(probe, drawFunc);
+
+        // Once refreshed, the probe lets the next ones be served
+        unsigned int index = (unsigned int)(probe - rlgCtx->reflectionProbes.probes);
+        rlgCtx->reflectionProbes.next = (probe->step == 0) ? index + 1 : index;
+    }
+
+    rlgSuspendShadowMask(false);
+    rlgCtx->reflectionProbes.capturing = false;
+    rlgCtx->skybox.previousCubemapID = 0;
+
+    SetShaderValue(rlgCtx->shaders[RLG_SHADER_LIGHTING],
+        rlgCtx->shaders[RLG_SHADER_LIGHTING].locs[RLG_LOC_VECTOR_VIEW], &rlgCtx->viewPos, SHADER_UNIFORM_VEC3);
+
+    // Restore the previous state
+    rlSetMatrixModelview(matView);
+    rlSetMatrixProjection(matProjection);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    rlViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+    if (depthTest) rlEnableDepthTest();
+    else rlDisableDepthTest();
+
+    if (cullFace) rlEnableBackfaceCulling();
+    else rlDisableBackfaceCulling();
+}
@@ -19,7 +19,9 @@ RLGShader :: enum {
     DEPTH_CUBEMAP,
     EQUIRECTANGULAR_TO_CUBEMAP,
     IRRADIANCE_CONVOLUTION,
-    SKYBOX 
+    SKYBOX,
+    IRRADIANCE_SAMPLING,
+    PREFILTER
 }
 
 LightProperty :: enum {
@@ -37,6 +39,37 @@ LightProperty :: enum {
     ATTENUATION_QUADRATIC
 }
 
+CasterFlag :: enum c.uint {
+    DIRLIGHT = 0,
+    OMNILIGHT,
+    SPOTLIGHT,
+    NO_CULL,
+}
+
+CasterFlags :: bit_set[CasterFlag; c.uint]
+
+ShadowTechnique :: enum c.int {
+    PCF = 0,
+    VSM,
+    EVSM
+}
+
+OmniShadowMode :: enum c.int {
+    CUBEMAP = 0,
+    DUAL_PARABOLOID
+}
+
+IrradianceMode :: enum c.int {
+    CUBEMAP = 0,
+    SH9,
+    SAMPLED_CUBEMAP
+}
+
+PixelFormat :: enum c.int {
+    R11G11B10F = 100,
+    RGB9E5
+}
+
 ShaderLocIndex :: enum {
     /* Same as raylib */
 
@@ -74,6 +107,12 @@ ShaderLocIndex :: enum {
     ROUGHNESS_SCALE,
     AO_LIGHT_AFFECT,
     HEIGHT_SCALE,
+    IRRADIANCE_SH,
+    USE_IRRADIANCE_SH,
+    USE_PROBE,
+    PROBE_POSITION,
+    PROBE_BOX_MIN,
+    PROBE_BOX_MAX,
 
     /* Internal use */
 
@@ -81,12 +120,22 @@ ShaderLocIndex :: enum {
 }
 
 Skybox :: struct {
-    cubemap, irradiance: rl.TextureCubemap,
+    cubemap, irradiance, prefilter: rl.TextureCubemap,
+    irradianceSH: [9]rl.Vector3,
     vboPostionID, vboIndicesID, vaoID: c.int,
     isHDR: c.bool,
+    bakeTile, bakeTileCount: c.int,
+}
+
+ShadowPoolStats :: struct {
+    count: c.uint,
+    memory: c.size_t,
+    reused, loaded: c.uint,
 }
 
 Context :: rawptr
+
+SkyboxLoad :: rawptr
 DrawFunc :: proc(shader: rl.Shader)
 
 foreign rll {
@@ -228,12 +277,99 @@ foreign rll {
     @(link_name = "RLG_GetShadowBias")
     GetShadowBias :: proc(light: c.uint) -> c.float ---
 
+    @(link_name = "RLG_SetShadowTechnique")
+    SetShadowTechnique :: proc(light: c.uint, technique: ShadowTechnique) ---
+
+    @(link_name = "RLG_GetShadowTechnique")
+    GetShadowTechnique :: proc(light: c.uint) -> ShadowTechnique ---
+
+    @(link_name = "RLG_SetOmniShadowMode")
+    SetOmniShadowMode :: proc(light: c.uint, mode: OmniShadowMode) ---
+
+    @(link_name = "RLG_GetOmniShadowMode")
+    GetOmniShadowMode :: proc(light: c.uint) -> OmniShadowMode ---
+
+    @(link_name = "RLG_SetShadowResolutionRange")
+    SetShadowResolutionRange :: proc(light: c.uint, min: c.int, max: c.int) ---
+
+    @(link_name = "RLG_SetShadowFade")
+    SetShadowFade :: proc(light: c.uint, start: c.float, end: c.float) ---
+
+    @(link_name = "RLG_GetShadowFade")
+    GetShadowFade :: proc(light: c.uint, start: ^c.float, end: ^c.float) ---
+
+    @(link_name = "RLG_IsShadowFadedOut")
+    IsShadowFadedOut :: proc(light: c.uint) -> c.bool ---
+
+    @(link_name = "RLG_GetShadowMemoryUsage")
+    GetShadowMemoryUsage :: proc() -> c.size_t ---
+
+    @(link_name = "RLG_TrimShadowPool")
+    TrimShadowPool :: proc(maxMemory: c.size_t) ---
+
+    @(link_name = "RLG_GetShadowPoolStats")
+    GetShadowPoolStats :: proc() -> ShadowPoolStats ---
+
+    @(link_name = "RLG_UseLayeredShadowMaps")
+    UseLayeredShadowMaps :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsLayeredShadowMapsUsed")
+    IsLayeredShadowMapsUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_UseShadowMask")
+    UseShadowMask :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsShadowMaskUsed")
+    IsShadowMaskUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_SetShadowMaskScale")
+    SetShadowMaskScale :: proc(scale: c.float) ---
+
+    @(link_name = "RLG_GetShadowMaskScale")
+    GetShadowMaskScale :: proc() -> c.float ---
+
+    @(link_name = "RLG_UpdateShadowMask")
+    UpdateShadowMask :: proc(camera: rl.Camera3D, drawFunc: DrawFunc) ---
+
+    @(link_name = "RLG_GetShadowMask")
+    GetShadowMask :: proc() -> rl.Texture ---
+
     @(link_name = "RLG_UpdateShadowMap")
     UpdateShadowMap :: proc(light: c.uint, drawFunc: DrawFunc) ---
 
+    @(link_name = "RLG_UpdateShadows")
+    UpdateShadows :: proc(drawFunc: DrawFunc, budget: c.int) ---
+
+    @(link_name = "RLG_GetShadowUpdateAge")
+    GetShadowUpdateAge :: proc(light: c.uint) -> c.uint ---
+
     @(link_name = "RLG_GetShadowMap")
     GetShadowMap :: proc(light: c.uint) -> rl.Texture ---
 
+    @(link_name = "RLG_AddShadowCaster")
+    AddShadowCaster :: proc(model: rl.Model, transform: rl.Matrix, flags: CasterFlags) -> c.uint ---
+
+    @(link_name = "RLG_RemoveShadowCaster")
+    RemoveShadowCaster :: proc(caster: c.uint) ---
+
+    @(link_name = "RLG_SetShadowCasterTransform")
+    SetShadowCasterTransform :: proc(caster: c.uint, transform: rl.Matrix) ---
+
+    @(link_name = "RLG_UsePositionStreams")
+    UsePositionStreams :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsPositionStreamsUsed")
+    IsPositionStreamsUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_UseQuantizedPositions")
+    UseQuantizedPositions :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsQuantizedPositionsUsed")
+    IsQuantizedPositionsUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_UnloadPositionStream")
+    UnloadPositionStream :: proc(mesh: rl.Mesh) ---
+
     @(link_name = "RLG_CastMesh")
     CastMesh :: proc(shader: rl.Shader, mesh: rl.Mesh, transform: rl.Matrix) ---
 
@@ -243,6 +379,36 @@ foreign rll {
     @(link_name = "RLG_CastModelEx")
     CastModelEx :: proc(shader: rl.Shader, model: rl.Model, position: rl.Vector3, rotationAxis: rl.Vector3, rotationAngle: c.float, scale: rl.Vector3) ---
 
+    @(link_name = "RLG_UseDepthPrepass")
+    UseDepthPrepass :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsDepthPrepassUsed")
+    IsDepthPrepassUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_DrawDepthPrepass")
+    DrawDepthPrepass :: proc(drawFunc: DrawFunc) ---
+
+    @(link_name = "RLG_EndDepthPrepass")
+    EndDepthPrepass :: proc() ---
+
+    @(link_name = "RLG_UseDeferred")
+    UseDeferred :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsDeferredUsed")
+    IsDeferredUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_BeginDeferred")
+    BeginDeferred :: proc() ---
+
+    @(link_name = "RLG_EndDeferred")
+    EndDeferred :: proc() ---
+
+    @(link_name = "RLG_UseMultiPass")
+    UseMultiPass :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsMultiPassUsed")
+    IsMultiPassUsed :: proc() -> c.bool ---
+
     @(link_name = "RLG_DrawMesh")
     DrawMesh :: proc(mesh: rl.Mesh, material: rl.Material, transform: rl.Matrix) ---
 
@@ -252,15 +418,84 @@ foreign rll {
     @(link_name = "RLG_DrawModelEx")
     DrawModelEx :: proc(model: rl.Model, position: rl.Vector3, rotationAxis: rl.Vector3, rotationAngle: c.float, scale: rl.Vector3, tint: rl.Color) ---
 
+    @(link_name = "RLG_SetIrradianceMode")
+    SetIrradianceMode :: proc(mode: IrradianceMode) ---
+
+    @(link_name = "RLG_GetIrradianceMode")
+    GetIrradianceMode :: proc() -> IrradianceMode ---
+
+    @(link_name = "RLG_SetIrradianceSH")
+    SetIrradianceSH :: proc(coefficients: [^]rl.Vector3) ---
+
+    @(link_name = "RLG_SetIrradianceSampleCount")
+    SetIrradianceSampleCount :: proc(count: c.int) ---
+
+    @(link_name = "RLG_GetIrradianceSampleCount")
+    GetIrradianceSampleCount :: proc() -> c.int ---
+
+    @(link_name = "RLG_UseIncrementalSkyboxBake")
+    UseIncrementalSkyboxBake :: proc(active: c.bool) ---
+
+    @(link_name = "RLG_IsIncrementalSkyboxBakeUsed")
+    IsIncrementalSkyboxBakeUsed :: proc() -> c.bool ---
+
+    @(link_name = "RLG_BakeSkyboxStep")
+    BakeSkyboxStep :: proc(skybox: ^Skybox, tileCount: c.int) -> c.bool ---
+
+    @(link_name = "RLG_GetBRDFLUT")
+    GetBRDFLUT :: proc() -> rl.Texture2D ---
+
     @(link_name = "RLG_LoadSkybox")
     LoadSkybox :: proc(skyboxFileName: cstring) -> Skybox ---
 
+    @(link_name = "RLG_LoadImageHDR")
+    LoadImageHDR :: proc(fileName: cstring) -> rl.Image ---
+
     @(link_name = "RLG_LoadSkyboxHDR")
     LoadSkyboxHDR :: proc(skyboxFileName: cstring, size: c.int, format: c.int) -> Skybox ---
 
+    @(link_name = "RLG_LoadSkyboxHDRAsync")
+    LoadSkyboxHDRAsync :: proc(skyboxFileName: cstring, size: c.int, format: c.int) -> SkyboxLoad ---
+
+    @(link_name = "RLG_PollSkybox")
+    PollSkybox :: proc(load: SkyboxLoad, skybox: ^Skybox) -> c.bool ---
+
+    @(link_name = "RLG_CancelSkyboxLoad")
+    CancelSkyboxLoad :: proc(load: SkyboxLoad) ---
+
+    @(link_name = "RLG_SaveSkyboxBake")
+    SaveSkyboxBake :: proc(skybox: Skybox, bakeFileName: cstring, skyboxFileName: cstring) -> c.bool ---
+
+    @(link_name = "RLG_LoadSkyboxBake")
+    LoadSkyboxBake :: proc(bakeFileName: cstring, skyboxFileName: cstring) -> Skybox ---
+
+    @(link_name = "RLG_BakeSkyboxFile")
+    BakeSkyboxFile :: proc(skyboxFileName: cstring, bakeFileName: cstring, size: c.int, irradianceMode: IrradianceMode, irradianceSamples: c.int) -> c.bool ---
+
     @(link_name = "RLG_UnloadSkybox")
     UnloadSkybox :: proc(skybox: Skybox) ---
 
+    @(link_name = "RLG_GetSkyboxMemory")
+    GetSkyboxMemory :: proc(skybox: Skybox) -> c.size_t ---
+
     @(link_name = "RLG_DrawSkybox")
     DrawSkybox :: proc(skybox: Skybox) ---
+
+    @(link_name = "RLG_CreateReflectionProbe")
+    CreateReflectionProbe :: proc(position: rl.Vector3, box: rl.BoundingBox, resolution: c.int) -> c.uint ---
+
+    @(link_name = "RLG_DestroyReflectionProbe")
+    DestroyReflectionProbe :: proc(probe: c.uint) ---
+
+    @(link_name = "RLG_SetReflectionProbeStatic")
+    SetReflectionProbeStatic :: proc(probe: c.uint, isStatic: c.bool) ---
+
+    @(link_name = "RLG_RefreshReflectionProbe")
+    RefreshReflectionProbe :: proc(probe: c.uint) ---
+
+    @(link_name = "RLG_UpdateReflectionProbes")
+    UpdateReflectionProbes :: proc(drawFunc: DrawFunc, budget: c.int) ---
+
+    @(link_name = "RLG_GetReflectionProbe")
+    GetReflectionProbe :: proc(probe: c.uint) -> rl.TextureCubemap ---
 }
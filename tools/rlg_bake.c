@@ -0,0 +1,170 @@
+// Offline skybox baker, writes the files loaded by RLG_LoadSkyboxBake
+//
+//  rlg_bake <skybox.hdr> <output.bake> [--size N] [--irradiance cubemap|sh9|sampled] [--samples N] [--validate]
+//
+// The bake runs on the CPU, without a window nor a GPU. With --validate, the skybox is
+// also loaded by RLG_LoadSkyboxHDR in a hidden window and both results are compared.
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "../rlights.h"
+
+static void printUsage(void)
+{
+    printf("usage: rlg_bake <skybox.hdr> <output.bake> [--size N] [--irradiance cubemap|sh9|sampled] [--samples N] [--validate]\n");
+}
+
+// Compare a level of two cubemaps, returning the largest error relative to the brightest texel
+static float compareCubemapLevel(TextureCubemap a, TextureCubemap b, int level, float *meanError)
+{
+    int size = (a.width >> level);
+    size_t count = 6*3*(size_t)size*size;
+
+    float *pa = (float*)malloc(count*sizeof(float));
+    float *pb = (float*)malloc(count*sizeof(float));
+
+    for (int i = 0; i < 6; i++)
+    {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, a.id);
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB, GL_FLOAT, pa + i*count/6);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, b.id);
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB, GL_FLOAT, pb + i*count/6);
+    }
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    float maxValue = 1e-6f, maxError = 0.0f;
+    double sumError = 0.0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float error = fabsf(pa[i] - pb[i]);
+        maxValue = fmaxf(maxValue, fabsf(pb[i]));
+        maxError = fmaxf(maxError, error);
+        sumError += error;
+    }
+
+    *meanError = (float)(sumError/count)/maxValue;
+
+    free(pa);
+    free(pb);
+
+    return maxError/maxValue;
+}
+
+static void printComparison(const char *name, TextureCubemap cpu, TextureCubemap gpu, int levels)
+{
+    for (int level = 0; level < levels; level++)
+    {
+        float meanError = 0.0f;
+        float maxError = compareCubemapLevel(cpu, gpu, level, &meanError);
+
+        printf("%-12s level %2d: mean error %.5f, max error %.5f (relative to the brightest texel)\n",
+            name, level, meanError, maxError);
+    }
+}
+
+static bool validate(const char *skyboxFileName, const char *bakeFileName, int size, RLG_IrradianceMode mode, int samples)
+{
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(64, 64, "rlg_bake");
+
+    RLG_Context rlgCtx = RLG_CreateContext(1);
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetIrradianceMode(mode);
+    RLG_SetIrradianceSampleCount(samples);
+
+    RLG_Skybox cpu = RLG_LoadSkyboxBake(bakeFileName, skyboxFileName);
+    RLG_Skybox gpu = RLG_LoadSkyboxHDR(skyboxFileName, size, PIXELFORMAT_UNCOMPRESSED_R32G32B32);
+
+    bool loaded = (cpu.cubemap.id != 0);
+
+    if (loaded)
+    {
+        printComparison("cubemap", cpu.cubemap, gpu.cubemap, 1);
+        printComparison("prefilter", cpu.prefilter, gpu.prefilter, RLG_PREFILTER_MIP_LEVELS);
+
+        if (mode == RLG_IRRADIANCE_SH9)
+        {
+            float maxError = 0.0f;
+            for (int i = 0; i < 9; i++)
+            {
+                maxError = fmaxf(maxError, Vector3Length(Vector3Subtract(cpu.irradianceSH[i], gpu.irradianceSH[i])));
+            }
+
+            printf("%-12s max coefficient error %.6f\n", "SH9", maxError);
+        }
+        else
+        {
+            printComparison("irradiance", cpu.irradiance, gpu.irradiance, 1);
+        }
+    }
+    else
+    {
+        printf("The bake could not be loaded back\n");
+    }
+
+    RLG_UnloadSkybox(cpu);
+    RLG_UnloadSkybox(gpu);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return loaded;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const char *skyboxFileName = argv[1];
+    const char *bakeFileName = argv[2];
+
+    int size = 1024;
+    int samples = 512;
+    RLG_IrradianceMode mode = RLG_IRRADIANCE_CUBEMAP;
+    bool doValidation = false;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--size") == 0) && (i + 1 < argc)) size = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc)) samples = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--irradiance") == 0) && (i + 1 < argc))
+        {
+            const char *name = argv[++i];
+
+            if (strcmp(name, "cubemap") == 0) mode = RLG_IRRADIANCE_CUBEMAP;
+            else if (strcmp(name, "sh9") == 0) mode = RLG_IRRADIANCE_SH9;
+            else if (strcmp(name, "sampled") == 0) mode = RLG_IRRADIANCE_SAMPLED_CUBEMAP;
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--validate") == 0) doValidation = true;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (size < 1)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!RLG_BakeSkyboxFile(skyboxFileName, bakeFileName, size, mode, samples)) return 1;
+
+    if (doValidation && !validate(skyboxFileName, bakeFileName, size, mode, samples)) return 1;
+
+    return 0;
+}